@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FrameBufferPool.h"
+#include "OpenVinoStyleTransfer.h"
+
+#include "Misc/ScopeLock.h"
+
+// alignment of the pixels, a cache line
+static const uint32 FrameBufferAlignment = 64;
+// free buffers kept per size: a capture, a result and the ones the triple buffers hold
+static const int32 MaxFreePerSize = 4;
+// free buffers of a size not acquired for this many acquisitions are released, e.g. after a resize
+static const uint64 StaleAcquisitions = 256;
+
+FFrameBuffer::FFrameBuffer(FIntPoint InSize)
+	: Data(static_cast<FColor*>(FMemory::Malloc(static_cast<SIZE_T>(InSize.X) * InSize.Y * sizeof(FColor), FrameBufferAlignment)))
+	, Size(InSize)
+{
+}
+
+FFrameBuffer::~FFrameBuffer()
+{
+	FMemory::Free(Data);
+}
+
+uint32 FFrameBuffer::AddRef() const
+{
+	return static_cast<uint32>(NumRefs.Increment());
+}
+
+uint32 FFrameBuffer::Release() const
+{
+	int32 Refs = NumRefs.Decrement();
+	if (Refs == 0)
+	{
+		// the pool reference of a free buffer would keep the pool alive forever
+		TSharedPtr<FFrameBufferPool, ESPMode::ThreadSafe> Owner = MoveTemp(Pool);
+		Owner->Recycle(const_cast<FFrameBuffer*>(this));
+	}
+	return static_cast<uint32>(Refs);
+}
+
+uint32 FFrameBuffer::GetRefCount() const
+{
+	return static_cast<uint32>(NumRefs.GetValue());
+}
+
+FFrameBufferPool::FFrameBufferPool()
+	: Acquisitions(0)
+{
+}
+
+FFrameBufferPool::~FFrameBufferPool()
+{
+	// buffers in use hold the pool, only free ones are left
+	for (TPair<FIntPoint, FBucket>& Bucket : Buckets)
+	{
+		for (FFrameBuffer* Buffer : Bucket.Value.Free)
+		{
+			delete Buffer;
+		}
+	}
+}
+
+TRefCountPtr<FFrameBuffer> FFrameBufferPool::Acquire(FIntPoint Size)
+{
+	check(Size.X > 0 && Size.Y > 0);
+
+	FFrameBuffer* Buffer = nullptr;
+	{
+		FScopeLock Lock(&Mutex);
+		Acquisitions++;
+
+		FBucket* Bucket = Buckets.Find(Size);
+		if (Bucket == nullptr)
+		{
+			// a new size, the sizes left behind are not coming back soon
+			for (auto It = Buckets.CreateIterator(); It; ++It)
+			{
+				if (Acquisitions - It.Value().LastAcquire > StaleAcquisitions)
+				{
+					for (FFrameBuffer* Stale : It.Value().Free)
+					{
+						delete Stale;
+					}
+					It.RemoveCurrent();
+				}
+			}
+			Bucket = &Buckets.Add(Size);
+		}
+		Bucket->LastAcquire = Acquisitions;
+		if (Bucket->Free.Num() > 0)
+		{
+			Buffer = Bucket->Free.Pop(false);
+		}
+	}
+
+	if (Buffer == nullptr)
+	{
+		Buffer = new FFrameBuffer(Size);
+		UE_LOG(LogStyleTransfer, Verbose, TEXT("Frame buffer of %d*%d allocated!"), Size.X, Size.Y);
+	}
+	Buffer->Pool = AsShared();
+	return TRefCountPtr<FFrameBuffer>(Buffer);
+}
+
+void FFrameBufferPool::Trim()
+{
+	FScopeLock Lock(&Mutex);
+	for (TPair<FIntPoint, FBucket>& Bucket : Buckets)
+	{
+		for (FFrameBuffer* Buffer : Bucket.Value.Free)
+		{
+			delete Buffer;
+		}
+	}
+	Buckets.Empty();
+}
+
+void FFrameBufferPool::Recycle(FFrameBuffer* Buffer)
+{
+	{
+		FScopeLock Lock(&Mutex);
+		FBucket* Bucket = Buckets.Find(Buffer->GetSize());
+		// a trimmed size, or enough of it are free already
+		if (Bucket != nullptr && Bucket->Free.Num() < MaxFreePerSize)
+		{
+			Bucket->Free.Add(Buffer);
+			return;
+		}
+	}
+	delete Buffer;
+}
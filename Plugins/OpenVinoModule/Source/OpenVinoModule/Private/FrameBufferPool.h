@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Templates/RefCounting.h"
+
+class FFrameBufferPool;
+
+/**
+ * A BGRA frame of fixed size from a FFrameBufferPool, rows are not padded. Shared through TRefCountPtr; when
+ * the last reference is released it goes back to its pool instead of to the allocator.
+ */
+class FFrameBuffer
+{
+public:
+	FColor* GetData() const { return Data; }
+	FIntPoint GetSize() const { return Size; }
+	int32 Num() const { return Size.X * Size.Y; }
+	uint32 GetPitch() const { return Size.X * sizeof(FColor); }
+
+	// reference counting as TRefCountPtr expects it
+	uint32 AddRef() const;
+	uint32 Release() const;
+	uint32 GetRefCount() const;
+
+	FFrameBuffer(const FFrameBuffer&) = delete;
+	FFrameBuffer& operator=(const FFrameBuffer&) = delete;
+
+private:
+	friend class FFrameBufferPool;
+
+	explicit FFrameBuffer(FIntPoint InSize);
+	~FFrameBuffer();
+
+	FColor* Data;
+	FIntPoint Size;
+	mutable FThreadSafeCounter NumRefs;
+	// set while the buffer is in use, it keeps the pool alive until every buffer came back
+	mutable TSharedPtr<FFrameBufferPool, ESPMode::ThreadSafe> Pool;
+};
+
+/**
+ * Frame buffers of the capture -> inference -> texture path, kept per frame size so a resize does not
+ * reallocate the buffers of the other sizes every frame. Buffers are aligned to a cache line. Thread safe.
+ */
+class FFrameBufferPool : public TSharedFromThis<FFrameBufferPool, ESPMode::ThreadSafe>
+{
+public:
+	FFrameBufferPool();
+	~FFrameBufferPool();
+
+	/**
+	 * @brief A buffer of the given size, recycled if one is free. Its content is undefined.
+	 */
+	TRefCountPtr<FFrameBuffer> Acquire(FIntPoint Size);
+
+	/**
+	 * @brief Free the buffers not in use, e.g. once a session stopped
+	 */
+	void Trim();
+
+private:
+	friend class FFrameBuffer;
+
+	struct FBucket
+	{
+		TArray<FFrameBuffer*> Free;
+		// acquisition it was used by last
+		uint64 LastAcquire = 0;
+	};
+
+	// called by the last release of a buffer
+	void Recycle(FFrameBuffer* Buffer);
+
+	FCriticalSection Mutex;
+	TMap<FIntPoint, FBucket> Buckets;
+	uint64 Acquisitions;
+};
@@ -2,6 +2,7 @@
 
 
 #include "OpenVinoStyleTransfer.h"
+#include "StyleTransferPipeline.h"
 #include "ThirdParty\OpenVinoWrapper\OpenVinoWrapper.h"
 #include "EditorStyleSet.h"
 
@@ -36,6 +37,91 @@ static TAutoConsoleVariable<FString> CVarDevice(
 	"CPU",
 	TEXT("Set device for Openvino Style transfer: CPU, GPU.0, GPU.1"));
 
+static TAutoConsoleVariable<float> CVarChangeThreshold(
+	TEXT("r.OVST.ChangeThreshold"),
+	0.0f,
+	TEXT("Mean luma difference (0-255) below which a frame counts as unchanged and reuses the last stylized frame, e.g. 1.5; 0 stylizes every frame."));
+
+static TAutoConsoleVariable<float> CVarSkipRatio(
+	TEXT("r.OVST.SkipRatio"),
+	0.0f,
+	TEXT("Read only: fraction of the frames of the last second that reused the last stylized frame, see r.OVST.ChangeThreshold."));
+
+static TAutoConsoleVariable<float> CVarFrameBudget(
+	TEXT("r.OVST.FrameBudget"),
+	0.0f,
+	TEXT("Time in ms a stylized frame may take, e.g. 33; the inference resolution steps down r.OVST.ResolutionScales to hold it and the result is rescaled to r.OVST.Width/Height. 0 always infers at r.OVST.Width/Height."));
+
+static TAutoConsoleVariable<FString> CVarResolutionScales(
+	TEXT("r.OVST.ResolutionScales"),
+	"0.75,0.5",
+	TEXT("Comma separated scales of r.OVST.Width/Height the inference resolution may step down to, see r.OVST.FrameBudget."));
+
+static TAutoConsoleVariable<int32> CVarResolutionRung(
+	TEXT("r.OVST.ResolutionRung"),
+	0,
+	TEXT("Read only: rung of r.OVST.ResolutionScales frames are inferred at, 0 for r.OVST.Width/Height."));
+
+static TAutoConsoleVariable<FString> CVarStyle(
+	TEXT("r.OVST.Style"),
+	"default",
+	TEXT("Name of the style to transfer, registered with RegisterStyle; default is the model passed to Initialize."));
+
+// OpenVINO performance properties, changes recompile the model in the background
+static TAutoConsoleVariable<FString> CVarPerformanceMode(
+	TEXT("r.OVST.PerformanceMode"),
+	"",
+	TEXT("OpenVINO performance hint: LATENCY, THROUGHPUT, CUMULATIVE_THROUGHPUT, empty for the plugin default."));
+
+static TAutoConsoleVariable<int32> CVarStreams(
+	TEXT("r.OVST.Streams"),
+	0,
+	TEXT("Number of OpenVINO inference streams, 0 for the plugin default."));
+
+static TAutoConsoleVariable<int32> CVarThreads(
+	TEXT("r.OVST.Threads"),
+	0,
+	TEXT("Number of OpenVINO CPU inference threads, 0 for the plugin default."));
+
+static TAutoConsoleVariable<FString> CVarPrecision(
+	TEXT("r.OVST.Precision"),
+	"",
+	TEXT("OpenVINO inference precision: f32, bf16 (CPU), f16 (GPU), empty for the plugin default."));
+
+static TAutoConsoleVariable<FString> CVarProbePrecisions(
+	TEXT("r.OVST.ProbePrecisions"),
+	"",
+	TEXT("Comma separated inference precisions SelectModelVariant tries with every IR, the reference first, e.g. f32,bf16,f16; empty for f32,f16 on GPU and f32,bf16 on other devices."));
+
+static TAutoConsoleVariable<FString> CVarCpuPinning(
+	TEXT("r.OVST.CpuPinning"),
+	"",
+	TEXT("OpenVINO CPU thread pinning: NONE, CORE, NUMA, HYBRID_AWARE, empty for the plugin default."));
+
+static TAutoConsoleVariable<FString> CVarCoreSet(
+	TEXT("r.OVST.CoreSet"),
+	"",
+	TEXT("Cores CPU inference runs on: P or E cores of a hybrid CPU, numa:N, logical processors such as 0-7,16, empty for all."));
+
+static TAutoConsoleVariable<int32> CVarNumRequests(
+	TEXT("r.OVST.NumRequests"),
+	0,
+	TEXT("Number of infer requests OpenVINO optimizes for, 0 for no limit."));
+
+// console variables forwarded to OpenVino_SetProperty, "0" and empty values restore the plugin default
+static const struct
+{
+	const TCHAR* cvar;
+	const char* property;
+} performance_properties[] = {
+	{ TEXT("r.OVST.PerformanceMode"), "PERFORMANCE_HINT" },
+	{ TEXT("r.OVST.Streams"), "NUM_STREAMS" },
+	{ TEXT("r.OVST.Threads"), "INFERENCE_NUM_THREADS" },
+	{ TEXT("r.OVST.Precision"), "INFERENCE_PRECISION_HINT" },
+	{ TEXT("r.OVST.CpuPinning"), "AFFINITY" },
+	{ TEXT("r.OVST.NumRequests"), "PERFORMANCE_HINT_NUM_REQUESTS" },
+};
+
 /*
  * @brief Tests if file passed exists, and logs error if it doesn't
  * @param filePath to be tested
@@ -62,7 +148,10 @@ UOpenVinoStyleTransfer::UOpenVinoStyleTransfer()
 	, debug_flag(false)
 	, dialog(nullptr)
 	, window(nullptr)
+	, transfer_style(nullptr)
 {
+	pipeline = MakeShared<FStyleTransferPipeline, ESPMode::ThreadSafe>();
+
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = true;
@@ -72,9 +161,18 @@ UOpenVinoStyleTransfer::UOpenVinoStyleTransfer()
 	transfer_height = IConsoleManager::Get().FindConsoleVariable(TEXT("r.OVST.Height"));
 	transfer_mode = IConsoleManager::Get().FindConsoleVariable(TEXT("r.OVST.Enabled"));
 	transfer_device = IConsoleManager::Get().FindConsoleVariable(TEXT("r.OVST.Device"));
+	transfer_style = IConsoleManager::Get().FindConsoleVariable(TEXT("r.OVST.Style"));
 
-	input_size.X = input_size.Y = 0;
 	last_input_size.X = last_input_size.Y = 0;
+	session_size.X = session_size.Y = 0;
+	loading_size.X = loading_size.Y = 0;
+	is_session_loading = false;
+	applied_change_threshold = -1.0f;
+	skip_window_begin = 0.0;
+	skip_window_checked = 0;
+	skip_window_skipped = 0;
+	applied_frame_budget = -1.0f;
+	rung_publish_time = 0.0;
 
 	is_intel = false;
 #if PLATFORM_WINDOWS
@@ -119,11 +217,11 @@ UOpenVinoStyleTransfer::Initialize(
 	is_openvino_creating = false;
 	is_openvino_releasing = false;
 
-	tmp_buffer.Reset(0);
-	tmp_buffer.SetNum(0);
-
 	xml_file_path = xmlFilePath;
 	bin_file_path = binFilePath;
+	style = TEXT("default");
+	style_files.Add(style, TPair<FString, FString>(xmlFilePath, binFilePath));
+	OpenVino_RegisterStyle(TCHAR_TO_ANSI(*style), TCHAR_TO_ANSI(*xmlFilePath), TCHAR_TO_ANSI(*binFilePath));
 
 	// bind callback
 	BindBackbufferCallback();
@@ -144,6 +242,101 @@ void UOpenVinoStyleTransfer::Release()
 	ReleaseWithMode(transfer_mode->GetInt(), true);
 }
 
+bool UOpenVinoStyleTransfer::RegisterStyle(FString styleName, FString xmlFilePath, FString binFilePath)
+{
+	if (!TestFileExists(xmlFilePath) ||
+		!TestFileExists(binFilePath))
+	{
+		return false;
+	}
+
+	if (!OpenVino_RegisterStyle(TCHAR_TO_ANSI(*styleName), TCHAR_TO_ANSI(*xmlFilePath), TCHAR_TO_ANSI(*binFilePath)))
+	{
+		GetAndLogLastError();
+		return false;
+	}
+	style_files.Add(styleName, TPair<FString, FString>(xmlFilePath, binFilePath));
+
+	UE_LOG(LogStyleTransfer, Log, TEXT("Style %s registered!"), *styleName);
+	return true;
+}
+
+bool UOpenVinoStyleTransfer::SelectModelVariant(TArray<FString> xmlFilePaths, TArray<FString> binFilePaths, FString framesFolder, float minPsnr, float minSsim)
+{
+	if (xmlFilePaths.Num() == 0 || xmlFilePaths.Num() != binFilePaths.Num())
+	{
+		UE_LOG(LogStyleTransfer, Error, TEXT("SelectModelVariant needs the weights of every model!"));
+		return false;
+	}
+
+	// the paths are passed as ANSI strings, they must outlive the call
+	vector<string> xml_paths, bin_paths;
+	for (int i = 0; i < xmlFilePaths.Num(); i++)
+	{
+		if (!TestFileExists(xmlFilePaths[i]) ||
+			!TestFileExists(binFilePaths[i]))
+		{
+			return false;
+		}
+		xml_paths.push_back(TCHAR_TO_ANSI(*xmlFilePaths[i]));
+		bin_paths.push_back(TCHAR_TO_ANSI(*binFilePaths[i]));
+	}
+	vector<const char*> xml_ptrs, bin_ptrs;
+	for (int i = 0; i < xmlFilePaths.Num(); i++)
+	{
+		xml_ptrs.push_back(xml_paths[i].c_str());
+		bin_ptrs.push_back(bin_paths[i].c_str());
+	}
+
+	FString probe_device = transfer_device->GetString();
+	// the reference precision first, then the faster ones the device supports
+	FString probe_precisions = CVarProbePrecisions.GetValueOnGameThread();
+	if (probe_precisions.IsEmpty())
+		probe_precisions = probe_device.StartsWith(TEXT("GPU")) ? TEXT("f32,f16") : TEXT("f32,bf16");
+	string precisions = TCHAR_TO_ANSI(*probe_precisions);
+	string frames_folder = TCHAR_TO_ANSI(*framesFolder);
+	int chosen_index = 0;
+	char chosen_precision[32] = {};
+	if (!OpenVino_SelectVariant(xml_ptrs.data(), bin_ptrs.data(), xmlFilePaths.Num(), precisions.c_str(),
+		transfer_width->GetInt(), transfer_height->GetInt(), TCHAR_TO_ANSI(*probe_device),
+		frames_folder.empty() ? nullptr : frames_folder.c_str(), minPsnr, minSsim,
+		&chosen_index, chosen_precision, sizeof(chosen_precision)))
+	{
+		GetAndLogLastError();
+		return false;
+	}
+
+	// OpenVino_SelectVariant applied the precision already, it is not forwarded again
+	FString precision = ANSI_TO_TCHAR(chosen_precision);
+	applied_properties.FindOrAdd(TEXT("r.OVST.Precision")) = precision;
+	IConsoleManager::Get().FindConsoleVariable(TEXT("r.OVST.Precision"))->Set(*precision, ECVF_SetByCode);
+
+	const FString default_style = TEXT("default");
+	style_files.Add(default_style, TPair<FString, FString>(xmlFilePaths[chosen_index], binFilePaths[chosen_index]));
+	OpenVino_RegisterStyle(TCHAR_TO_ANSI(*default_style), xml_ptrs[chosen_index], bin_ptrs[chosen_index]);
+	if (style == default_style)
+	{
+		xml_file_path = xmlFilePaths[chosen_index];
+		bin_file_path = binFilePaths[chosen_index];
+		// otherwise the next initialization loads the variant
+		if (mode == 1 && (session_size.X > 0 || is_session_loading))
+		{
+			if (!OpenVino_SetStyle(TCHAR_TO_ANSI(*default_style)))
+			{
+				GetAndLogLastError();
+			}
+			else if (!is_session_loading)
+			{
+				loading_size = session_size;
+				is_session_loading = true;
+			}
+		}
+	}
+
+	UE_LOG(LogStyleTransfer, Log, TEXT("Model variant %s with precision \"%s\" chosen!"), *xmlFilePaths[chosen_index], *precision);
+	return true;
+}
+
 UTexture2D* UOpenVinoStyleTransfer::GetTransferedTexture()
 {
 	return out_tex;
@@ -161,15 +354,18 @@ void UOpenVinoStyleTransfer::ReleaseWithMode(int inmode, bool force)
 		dialog = nullptr;
 	}
 
-	if (out_tex != nullptr)
-	{
-		//out_tex->RemoveFromRoot();
-		out_tex = nullptr;
-	}
+	// the dialog showing it is gone
+	ReleaseTexture(out_tex);
+	out_tex = nullptr;
 
 	if (inmode == 1 || force)
 	{
+		// the frame in progress is finished first
+		pipeline->Shutdown();
+		// also cancels a session loading in the background
 		OpenVino_Release();
+		session_size.X = session_size.Y = 0;
+		is_session_loading = false;
 	}
 	else
 	{
@@ -197,30 +393,20 @@ void UOpenVinoStyleTransfer::CreateWithMode(int width, int height, int inmode, F
 
 	if (inmode == 1)
 	{
-		if (!OpenVino_Initialize(TCHAR_TO_ANSI(*xml_file_path), TCHAR_TO_ANSI(*xml_file_path), width, height, TCHAR_TO_ANSI(*indevice)))
+		// read, compiled and warmed up on a worker thread, the running session keeps transferring meanwhile
+		if (!OpenVino_InitializeAsync(TCHAR_TO_ANSI(*xml_file_path), TCHAR_TO_ANSI(*bin_file_path), width, height, TCHAR_TO_ANSI(*indevice)))
 		{
 			UE_LOG(LogStyleTransfer, Log, TEXT("OpenVino initialize failed, width = %d, height = %d,  mode = %d, device = %s!"), width, height, inmode, TCHAR_TO_ANSI(*indevice));
+			GetAndLogLastError();
 			return;
 		}
 
-		// initialize buffer size
-		size_t size = width * height;
-		size_t buffer_size = size * 3;
-		buffer.Reset(buffer_size);
-		buffer.SetNum(buffer_size);
-		rgba_buffer.Reset(size);
-		rgba_buffer.SetNum(size);
-
-		UE_LOG(LogStyleTransfer, Log, TEXT("Style transfer buffer initialized!"));
+		loading_size.X = width;
+		loading_size.Y = height;
+		is_session_loading = true;
 
-		// new window
-		dialog = SStyleTransferResultDialog::ShowWindow(width, height, window);
-		window->SetOnWindowClosed(FOnWindowClosed::CreateLambda([this](const TSharedRef<SWindow>& Window)
-			{
-				this->ClearWindow();
-			}));
-
-		UE_LOG(LogStyleTransfer, Log, TEXT("Style transfer window created!"));
+		UE_LOG(LogStyleTransfer, Log, TEXT("OpenVino loading in the background, width = %d, height = %d, device = %s!"), width, height, *indevice);
+		return;
 	}
 	else if (inmode == 2)
 	{
@@ -233,7 +419,7 @@ void UOpenVinoStyleTransfer::CreateWithMode(int width, int height, int inmode, F
 			ENQUEUE_RENDER_COMMAND(CreateOCLOpenVino)(
 				[this, width, height](FRHICommandListImmediate& RHICmdList)
 				{
-					OpenVino_Initialize_BaseOCL(TCHAR_TO_ANSI(*xml_file_path), TCHAR_TO_ANSI(*xml_file_path), RHICmdList.GetNativeDevice(), width, height);
+					OpenVino_Initialize_BaseOCL(TCHAR_TO_ANSI(*xml_file_path), TCHAR_TO_ANSI(*bin_file_path), RHICmdList.GetNativeDevice(), width, height);
 					is_openvino_creating = false;
 				});
 		}
@@ -243,6 +429,232 @@ void UOpenVinoStyleTransfer::CreateWithMode(int width, int height, int inmode, F
 	UE_LOG(LogStyleTransfer, Log, TEXT("OpenVino initialize successful, width = %d, height = %d!"), width, height);
 }
 
+void UOpenVinoStyleTransfer::PollSessionReady()
+{
+	bool ready = false;
+	float progress = 0.0f;
+	if (!OpenVino_IsReady(&ready, &progress))
+	{
+		// the previous session, if any, keeps running
+		GetAndLogLastError();
+		is_session_loading = false;
+		return;
+	}
+
+	if (!ready)
+	{
+		return;
+	}
+	is_session_loading = false;
+
+	// the new session is in place from here on, outputs have its size; PresentResult replaces the
+	// texture once a result of the new size arrives
+	session_size = loading_size;
+	// results in flight keep their size, the texture follows them
+	pipeline->Start(session_size, debug_flag);
+	// the change threshold applies per session
+	applied_change_threshold = -1.0f;
+	skip_window_begin = 0.0;
+
+	if (window == nullptr)
+	{
+		// new window
+		dialog = SStyleTransferResultDialog::ShowWindow(session_size.X, session_size.Y, window);
+		window->SetOnWindowClosed(FOnWindowClosed::CreateLambda([this](const TSharedRef<SWindow>& Window)
+			{
+				this->ClearWindow();
+			}));
+
+		UE_LOG(LogStyleTransfer, Log, TEXT("Style transfer window created!"));
+	}
+
+	UE_LOG(LogStyleTransfer, Log, TEXT("OpenVino initialize successful, width = %d, height = %d!"), session_size.X, session_size.Y);
+}
+
+void UOpenVinoStyleTransfer::ApplyStyle()
+{
+	FString new_style = transfer_style->GetString();
+	if (new_style == style)
+	{
+		return;
+	}
+
+	const TPair<FString, FString>* files = style_files.Find(new_style);
+	if (files == nullptr)
+	{
+		UE_LOG(LogStyleTransfer, Error, TEXT("Style %s is not registered!"), *new_style);
+		// not retried every tick
+		style = new_style;
+		return;
+	}
+
+	style = new_style;
+	xml_file_path = files->Key;
+	bin_file_path = files->Value;
+
+	// otherwise the next initialization loads the style
+	if (mode == 1 && (session_size.X > 0 || is_session_loading))
+	{
+		// the running style keeps transferring until the new one is ready, styles used before are still loaded
+		if (!OpenVino_SetStyle(TCHAR_TO_ANSI(*style)))
+		{
+			GetAndLogLastError();
+			return;
+		}
+		if (!is_session_loading)
+		{
+			loading_size = session_size;
+			is_session_loading = true;
+		}
+	}
+
+	UE_LOG(LogStyleTransfer, Log, TEXT("Style transfer switches to style %s!"), *style);
+}
+
+void UOpenVinoStyleTransfer::UpdateChangeDetection()
+{
+	float threshold = FMath::Max(CVarChangeThreshold.GetValueOnGameThread(), 0.0f);
+	if (threshold != applied_change_threshold)
+	{
+		if (!OpenVino_SetChangeThreshold(threshold))
+		{
+			GetAndLogLastError();
+		}
+		// a rejected value is not retried every tick
+		applied_change_threshold = threshold;
+	}
+
+	double now = FPlatformTime::Seconds();
+	if (now - skip_window_begin < 1.0)
+	{
+		return;
+	}
+
+	OpenVinoStats stats;
+	if (!OpenVino_GetStats(&stats))
+	{
+		return;
+	}
+	// counters of a session that was just swapped in start the window
+	if (skip_window_begin > 0.0 && stats.frames_checked >= skip_window_checked)
+	{
+		unsigned long long checked = stats.frames_checked - skip_window_checked;
+		unsigned long long skipped = stats.frames_skipped - skip_window_skipped;
+		float ratio = checked > 0 ? static_cast<float>(skipped) / checked : 0.0f;
+		CVarSkipRatio->Set(ratio, ECVF_SetByCode);
+	}
+	skip_window_begin = now;
+	skip_window_checked = stats.frames_checked;
+	skip_window_skipped = stats.frames_skipped;
+}
+
+void UOpenVinoStyleTransfer::UpdateResolutionLadder()
+{
+	FString scales_value = CVarResolutionScales.GetValueOnGameThread();
+	if (scales_value != applied_resolution_scales)
+	{
+		TArray<FString> parts;
+		scales_value.ParseIntoArray(parts, TEXT(","));
+		TArray<float> scales;
+		for (const FString& part : parts)
+		{
+			scales.Add(FCString::Atof(*part.TrimStartAndEnd()));
+		}
+		if (!OpenVino_SetResolutionLadder(scales.GetData(), scales.Num()))
+		{
+			GetAndLogLastError();
+		}
+		// a rejected value is not retried every tick
+		applied_resolution_scales = scales_value;
+	}
+
+	float budget = FMath::Max(CVarFrameBudget.GetValueOnGameThread(), 0.0f);
+	if (budget != applied_frame_budget)
+	{
+		if (!OpenVino_SetFrameBudget(budget))
+		{
+			GetAndLogLastError();
+		}
+		applied_frame_budget = budget;
+	}
+
+	double now = FPlatformTime::Seconds();
+	if (now - rung_publish_time < 1.0)
+	{
+		return;
+	}
+	rung_publish_time = now;
+
+	OpenVinoStats stats;
+	if (OpenVino_GetStats(&stats))
+	{
+		CVarResolutionRung->Set(stats.resolution_rung, ECVF_SetByCode);
+	}
+}
+
+void UOpenVinoStyleTransfer::ApplyCoreSet()
+{
+	FString core_set = CVarCoreSet.GetValueOnGameThread();
+	if (core_set == applied_core_set)
+	{
+		return;
+	}
+	// a rejected value is not retried every tick
+	applied_core_set = core_set;
+
+	if (!OpenVino_SetCoreSet(TCHAR_TO_ANSI(*core_set)))
+	{
+		GetAndLogLastError();
+		return;
+	}
+	UE_LOG(LogStyleTransfer, Log, TEXT("OpenVino core set \"%s\"!"), *core_set);
+
+	// the running style is loaded again on the new cores, it keeps transferring until then
+	if (mode == 1 && (session_size.X > 0 || is_session_loading))
+	{
+		if (!OpenVino_SetStyle(TCHAR_TO_ANSI(*style)))
+		{
+			GetAndLogLastError();
+			return;
+		}
+		if (!is_session_loading)
+		{
+			loading_size = session_size;
+			is_session_loading = true;
+		}
+	}
+}
+
+void UOpenVinoStyleTransfer::ApplyPerformanceProperties()
+{
+	for (const auto& performance_property : performance_properties)
+	{
+		IConsoleVariable* cvar = IConsoleManager::Get().FindConsoleVariable(performance_property.cvar);
+		FString value = cvar->GetString();
+		if (value == TEXT("0"))
+		{
+			value.Empty();
+		}
+
+		FString& applied = applied_properties.FindOrAdd(performance_property.cvar);
+		if (value == applied)
+		{
+			continue;
+		}
+
+		if (OpenVino_SetProperty(performance_property.property, TCHAR_TO_ANSI(*value)))
+		{
+			UE_LOG(LogStyleTransfer, Log, TEXT("OpenVino property %s set to \"%s\"!"), ANSI_TO_TCHAR(performance_property.property), *value);
+		}
+		else
+		{
+			GetAndLogLastError();
+		}
+		// a rejected value is not retried every tick
+		applied = value;
+	}
+}
+
 void UOpenVinoStyleTransfer::UpdateWidthHeight(int inmode)
 {
 	if (inmode == 1)
@@ -271,12 +683,21 @@ void UOpenVinoStyleTransfer::TickComponent(float DeltaTime, enum ELevelTick Tick
 	switch (state)
 	{
 	case IDLE:
+		// applied at the next initialization, or recompiled in the background while running
+		ApplyPerformanceProperties();
+		ApplyCoreSet();
+		ApplyStyle();
+
 		new_mode = transfer_mode->GetInt();
 		new_device = transfer_device->GetString();
 
 		if (new_mode != mode || (new_device != device && mode == 1))
 		{
-			ReleaseWithMode(mode);
+			// a device switch in cpu mode loads the new session next to the running one
+			if (new_mode != 1 || mode != 1)
+			{
+				ReleaseWithMode(mode);
+			}
 			if (is_openvino_releasing)
 			{
 				state = RELEASING;
@@ -297,17 +718,6 @@ void UOpenVinoStyleTransfer::TickComponent(float DeltaTime, enum ELevelTick Tick
 		// only cpu mode use buffer copy
 		if (mode == 1)
 		{
-			// reset input tmp process buffer	
-			if (input_size.X != 0 && input_size.Y != 0 && input_size != last_input_size)
-			{
-				UE_LOG(LogStyleTransfer, Log, TEXT("Style transfer resize input from %d*%d to %d*%d!"), last_input_size.X, last_input_size.Y, input_size.X, input_size.Y);
-
-				size_t buffer_size = input_size.X * input_size.Y * 3;
-				tmp_buffer.Reset(buffer_size);
-				tmp_buffer.SetNum(buffer_size);
-			}
-			last_input_size = input_size;
-
 			// output buffer change
 			if (transfer_width->GetInt() != last_out_width || transfer_height->GetInt() != last_out_height)
 			{
@@ -315,15 +725,25 @@ void UOpenVinoStyleTransfer::TickComponent(float DeltaTime, enum ELevelTick Tick
 
 				last_out_width = transfer_width->GetInt();
 				last_out_height = transfer_height->GetInt();
-				ReleaseWithMode(mode);
 				CreateWithMode(last_out_width, last_out_height, mode, device);
 			}
 
-			// begin transfer from captured data to texture via cpu pass
-			if (tmp_buffer.Num() > 0 && StyleTransferToTexture(this, fb_data, input_size.X, input_size.Y))
+			if (is_session_loading)
+			{
+				PollSessionReady();
+			}
+
+			if (session_size.X > 0)
+			{
+				UpdateChangeDetection();
+				UpdateResolutionLadder();
+			}
+
+			// the newest frame the inference thread finished, if any; frames pass unstyled until a session runs
+			const FTransferredFrame* result = pipeline->TakeResult();
+			if (result != nullptr)
 			{
-				// show texture in dialog
-				dialog->UpdateTexture(out_tex);
+				PresentResult(*result);
 			}
 		}
 		break;
@@ -379,6 +799,10 @@ void UOpenVinoStyleTransfer::OnBackBufferReady_RenderThread(SWindow& SlateWindow
 	if (mode != 1)	// only cpu mode use buffer copy
 		return;
 
+	// nothing transfers captures until a session runs
+	if (!pipeline.IsValid() || !pipeline->IsRunning())
+		return;
+
 	UGameViewportClient* gameViewport = GetWorld()->GetGameViewport();
 	if (gameViewport == nullptr)
 		return;
@@ -395,91 +819,83 @@ void UOpenVinoStyleTransfer::OnBackBufferReady_RenderThread(SWindow& SlateWindow
 	FVector2D gameWinPos = gameWin->GetPositionInScreen();
 	FVector2D vpPos = vp->GetCachedGeometry().GetAbsolutePosition();
 
-	// get input and reset tmp process buffer
-	input_origin = vpPos - gameWinPos;
-	input_size = vp->GetSize();
-	
+	// get input
+	FVector2D input_origin = vpPos - gameWinPos;
+	FIntPoint input_size = vp->GetSize();
+	if (input_size.X <= 0 || input_size.Y <= 0)
+		return;
+
 	FIntRect Rect(input_origin.X, input_origin.Y, input_origin.X + input_size.X, input_origin.Y + input_size.Y);
 	FRHICommandListImmediate& RHICmdList = FRHICommandListExecutor::GetImmediateCommandList();
 
-	// Get out data
-	RHICmdList.ReadSurfaceData(BackBuffer, Rect, fb_data, FReadSurfaceDataFlags(RCM_UNorm));
+	// Get out data, into a pooled buffer the inference thread borrows; a capture it did not take yet is replaced
+	pipeline->Capture_RenderThread(RHICmdList, BackBuffer, Rect);
 }
 
-bool UOpenVinoStyleTransfer::StyleTransferToTexture(UObject* Outer, TArray<FColor>& TextureData, int inwidth, int inheight)
+void UOpenVinoStyleTransfer::PresentResult(const FTransferredFrame& result)
 {
-	TPromise<FColor*> Result;
-	FString resultlog;
-	
-	// Read the size we need
-	int width = transfer_width->GetInt();
-	int height = transfer_height->GetInt();
-
-	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Outer, TextureData, inwidth, inheight, width, height, &resultlog, &Result, this]()
-		{
-			
-			int index = 0;
-			for (FColor color : TextureData)
-			{
-				tmp_buffer[index] = color.B;
-				tmp_buffer[index + 1] = color.G;
-				tmp_buffer[index + 2] = color.R;
-				index = index + 3;
-			}
+	if (!result.bSuccess || !result.Pixels.IsValid())
+	{
+		this->OnStyleTransferComplete.Broadcast(result.Log, nullptr);
+		return;
+	}
 
-			if( OpenVino_Infer_FromTexture(tmp_buffer.GetData(), inwidth, inheight, buffer.GetData(), debug_flag) )
-			{
-				index = 0;
-				for(int i = 0; i < width * height; i++)
-				{
-					rgba_buffer[i].B = buffer[index];
-					rgba_buffer[i].G = buffer[index + 1];
-					rgba_buffer[i].R = buffer[index + 2];
-					rgba_buffer[i].A = 255;
-					index = index + 3;
-				}
-				Result.SetValue(rgba_buffer.GetData());
-				resultlog = FString::Format(TEXT("Success:Width({0}), Height({1})"), { FString::FromInt(width), FString::FromInt(height) });
-			}
-			else
-			{
-				Result.SetValue(nullptr);
-				resultlog = GetAndLogLastError();
-			}
-		}
-	);
-	
-	Future = Result.GetFuture();
-	bool ret = false;
-	if (Future.IsValid())
-	{
-		FColor* transfered = Future.Get();
-		if (transfered != nullptr)
+	// captured frames are handed to OpenVINO as BGRA, no repack buffer is needed
+	if (result.InputSize != last_input_size)
+	{
+		if (last_input_size.X != 0 && last_input_size.Y != 0)
 		{
-			if (out_tex == nullptr)
-			{
-				out_tex = CreateTexture(transfered, width, height);
-				out_tex->AddToRoot();
+			UE_LOG(LogStyleTransfer, Log, TEXT("Style transfer resize input from %d*%d to %d*%d!"), last_input_size.X, last_input_size.Y, result.InputSize.X, result.InputSize.Y);
+		}
+		last_input_size = result.InputSize;
+	}
 
-				// texture created
-				ret = true;
-			}
-			else
-			{
-				// update
-				UpdateTexture(out_tex, transfered);
-			}
-			this->OnStyleTransferComplete.Broadcast(resultlog, out_tex);
+	// results inferred before a session of another size was swapped in still have the old size
+	FIntPoint size = result.Pixels->GetSize();
+	UTexture2D* replaced = nullptr;
+	if (out_tex != nullptr && (out_tex->GetSizeX() != size.X || out_tex->GetSizeY() != size.Y))
+	{
+		replaced = out_tex;
+		out_tex = nullptr;
+	}
+
+	if (out_tex == nullptr)
+	{
+		out_tex = CreateTexture(result.Pixels->GetData(), size.X, size.Y);
+		if (out_tex == nullptr)
+		{
+			// the dialog keeps showing the previous one
+			out_tex = replaced;
+			return;
 		}
-		else
+		out_tex->AddToRoot();
+
+		// show texture in dialog
+		if (dialog != nullptr)
 		{
-			this->OnStyleTransferComplete.Broadcast(resultlog, nullptr);
+			dialog->UpdateTexture(out_tex);
 		}
+		// unrooted once the dialog shows its replacement
+		ReleaseTexture(replaced);
+	}
+	else
+	{
+		// update
+		UpdateTexture(out_tex, result.Pixels->GetData());
+	}
+	this->OnStyleTransferComplete.Broadcast(result.Log, out_tex);
+}
+
+void UOpenVinoStyleTransfer::ReleaseTexture(UTexture2D* tex)
+{
+	// at engine exit it may be purged already
+	if (tex != nullptr && tex->IsValidLowLevel() && tex->IsRooted())
+	{
+		tex->RemoveFromRoot();
 	}
-	return ret;
 }
 
-UTexture2D* UOpenVinoStyleTransfer::CreateTexture(FColor* data, int width, int height)
+UTexture2D* UOpenVinoStyleTransfer::CreateTexture(const FColor* data, int width, int height)
 {
 	UTexture2D* Texture;
 
@@ -506,7 +922,7 @@ UTexture2D* UOpenVinoStyleTransfer::CreateTexture(FColor* data, int width, int h
 	return Texture;
 }
 
-void UOpenVinoStyleTransfer::UpdateTexture(UTexture2D* tex, FColor* data)
+void UOpenVinoStyleTransfer::UpdateTexture(UTexture2D* tex, const FColor* data)
 {
 	FTexture2DMipMap& Mip = tex->PlatformData->Mips[0];
 	void* Data = Mip.BulkData.Lock(LOCK_READ_WRITE);
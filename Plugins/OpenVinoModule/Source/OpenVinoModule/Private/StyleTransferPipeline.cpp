@@ -0,0 +1,273 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "StyleTransferPipeline.h"
+#include "OpenVinoStyleTransfer.h"
+#include "ThirdParty\OpenVinoWrapper\OpenVinoWrapper.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "RHICommandList.h"
+
+// how long the inference thread sleeps without captures before it looks for a stop request
+static const uint32 CaptureWaitMs = 100;
+
+static uint64 PackSize(FIntPoint Size)
+{
+	return (static_cast<uint64>(static_cast<uint32>(Size.X)) << 32) | static_cast<uint32>(Size.Y);
+}
+
+static FIntPoint UnpackSize(uint64 Packed)
+{
+	return FIntPoint(static_cast<int32>(Packed >> 32), static_cast<int32>(Packed & 0xffffffff));
+}
+
+FStyleTransferPipeline::FStyleTransferPipeline()
+	: Pool(MakeShared<FFrameBufferPool, ESPMode::ThreadSafe>())
+	, CaptureEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	, Thread(nullptr)
+	, bStopping(false)
+	, bRunning(false)
+	, PackedOutputSize(0)
+	, bDebug(false)
+	, StagingHead(0)
+	, StagingSequence(0)
+{
+}
+
+FStyleTransferPipeline::~FStyleTransferPipeline()
+{
+	Shutdown();
+	FPlatformProcess::ReturnSynchEventToPool(CaptureEvent);
+}
+
+void FStyleTransferPipeline::Start(FIntPoint OutputSize, bool bInDebug)
+{
+	SetOutputSize(OutputSize);
+	if (Thread != nullptr)
+	{
+		return;
+	}
+
+	bDebug = bInDebug;
+	bStopping = false;
+	bRunning = true;
+	Thread = FRunnableThread::Create(this, TEXT("OVST Inference"), 0, TPri_Normal);
+	if (Thread == nullptr)
+	{
+		bRunning = false;
+		UE_LOG(LogStyleTransfer, Error, TEXT("Style transfer inference thread could not be created!"));
+		return;
+	}
+
+	UE_LOG(LogStyleTransfer, Log, TEXT("Style transfer inference thread started, output %d*%d!"), OutputSize.X, OutputSize.Y);
+}
+
+void FStyleTransferPipeline::Shutdown()
+{
+	if (Thread == nullptr)
+	{
+		return;
+	}
+
+	// calls Stop and waits for the frame in progress
+	Thread->Kill(true);
+	delete Thread;
+	Thread = nullptr;
+	bRunning = false;
+
+	// the game thread reads both buffers now, nothing is left for the next session
+	if (Captures.IsDirty())
+	{
+		Captures.SwapReadBuffers();
+	}
+	if (Results.IsDirty())
+	{
+		Results.SwapReadBuffers();
+	}
+	// pooled buffers are freed, a capture the render thread still holds is freed when it comes back
+	Results.Read().Pixels.SafeRelease();
+	Pool->Trim();
+}
+
+void FStyleTransferPipeline::SetOutputSize(FIntPoint Size)
+{
+	PackedOutputSize = PackSize(Size);
+}
+
+void FStyleTransferPipeline::Capture_RenderThread(FRHICommandListImmediate& RHICmdList, FRHITexture2D* BackBuffer, FIntRect Rect)
+{
+	Rect.Clip(FIntRect(FIntPoint::ZeroValue, BackBuffer->GetSizeXY()));
+	if (Rect.Width() <= 0 || Rect.Height() <= 0)
+	{
+		return;
+	}
+
+	if (BackBuffer->GetFormat() == PF_B8G8R8A8 && BackBuffer->GetNumSamples() <= 1)
+	{
+		// copies of earlier captures are read before this one is issued, no map waits for the GPU
+		PublishStaging_RenderThread(RHICmdList);
+		CopyToStaging_RenderThread(RHICmdList, BackBuffer, Rect);
+		return;
+	}
+
+	// the previous capture in this slot, if any, was taken or is dropped and goes back to the pool
+	TRefCountPtr<FFrameBuffer>& Buffer = Captures.GetWriteBuffer();
+	Buffer = Pool->Acquire(Rect.Size());
+	// converts HDR and multisampled back buffers, waits for the GPU
+	RHICmdList.ReadSurfaceData(BackBuffer, Rect, ConvertedCapture, FReadSurfaceDataFlags(RCM_UNorm));
+	if (ConvertedCapture.Num() != Buffer->Num())
+	{
+		Buffer.SafeRelease();
+		return;
+	}
+	FMemory::Memcpy(Buffer->GetData(), ConvertedCapture.GetData(), Buffer->Num() * sizeof(FColor));
+
+	Captures.SwapWriteBuffers();
+	CaptureEvent->Trigger();
+}
+
+void FStyleTransferPipeline::CopyToStaging_RenderThread(FRHICommandListImmediate& RHICmdList, FRHITexture2D* BackBuffer, FIntRect Rect)
+{
+	// the oldest slot; a copy still pending in it is dropped
+	FStagingCopy& Copy = StagingRing[StagingHead];
+	StagingHead = (StagingHead + 1) % StagingRingSize;
+
+	// kept until the capture size changes
+	if (!Copy.Texture.IsValid() || Copy.Texture->GetSizeXY() != Rect.Size())
+	{
+		FRHIResourceCreateInfo CreateInfo(TEXT("OVSTCapture"));
+		Copy.Texture = RHICreateTexture2D(Rect.Width(), Rect.Height(), PF_B8G8R8A8, 1, 1, TexCreate_CPUReadback, CreateInfo);
+	}
+	if (!Copy.Fence.IsValid())
+	{
+		Copy.Fence = RHICreateGPUFence(TEXT("OVSTCaptureFence"));
+	}
+	Copy.Fence->Clear();
+
+	FRHICopyTextureInfo CopyInfo;
+	CopyInfo.Size = FIntVector(Rect.Width(), Rect.Height(), 1);
+	CopyInfo.SourcePosition = FIntVector(Rect.Min.X, Rect.Min.Y, 0);
+	RHICmdList.CopyTexture(BackBuffer, Copy.Texture, CopyInfo);
+	RHICmdList.WriteGPUFence(Copy.Fence);
+
+	Copy.Size = Rect.Size();
+	Copy.Sequence = ++StagingSequence;
+	Copy.bPending = true;
+}
+
+bool FStyleTransferPipeline::PublishStaging_RenderThread(FRHICommandListImmediate& RHICmdList)
+{
+	// the newest finished copy; older ones would be replaced in the triple buffer anyway
+	FStagingCopy* Newest = nullptr;
+	for (FStagingCopy& Copy : StagingRing)
+	{
+		if (Copy.bPending && (Newest == nullptr || Copy.Sequence > Newest->Sequence) && Copy.Fence->Poll())
+		{
+			Newest = &Copy;
+		}
+	}
+	if (Newest == nullptr)
+	{
+		return false;
+	}
+	for (FStagingCopy& Copy : StagingRing)
+	{
+		if (Copy.Sequence <= Newest->Sequence)
+		{
+			Copy.bPending = false;
+		}
+	}
+
+	// the fence signaled, the map does not wait
+	void* Data = nullptr;
+	int32 RowPixels = 0;
+	int32 Rows = 0;
+	RHICmdList.MapStagingSurface(Newest->Texture, Newest->Fence, Data, RowPixels, Rows);
+	if (Data == nullptr)
+	{
+		return false;
+	}
+
+	// the previous capture in this slot, if any, was taken or is dropped and goes back to the pool
+	TRefCountPtr<FFrameBuffer>& Buffer = Captures.GetWriteBuffer();
+	Buffer = Pool->Acquire(Newest->Size);
+	// rows of the staging texture may be padded, those of the buffer are not
+	const FColor* Source = static_cast<const FColor*>(Data);
+	for (int32 Y = 0; Y < Newest->Size.Y; Y++)
+	{
+		FMemory::Memcpy(Buffer->GetData() + Y * Newest->Size.X, Source + Y * RowPixels, Newest->Size.X * sizeof(FColor));
+	}
+	RHICmdList.UnmapStagingSurface(Newest->Texture);
+
+	Captures.SwapWriteBuffers();
+	CaptureEvent->Trigger();
+	return true;
+}
+
+const FTransferredFrame* FStyleTransferPipeline::TakeResult()
+{
+	if (!Results.IsDirty())
+	{
+		return nullptr;
+	}
+	Results.SwapReadBuffers();
+	return &Results.Read();
+}
+
+uint32 FStyleTransferPipeline::Run()
+{
+	while (!bStopping)
+	{
+		CaptureEvent->Wait(CaptureWaitMs);
+		if (bStopping || !Captures.IsDirty())
+		{
+			continue;
+		}
+
+		// borrowed until the frame is transferred, then it goes back to the pool
+		Captures.SwapReadBuffers();
+		TRefCountPtr<FFrameBuffer> Capture = MoveTemp(Captures.Read());
+		FIntPoint OutputSize = UnpackSize(PackedOutputSize);
+		if (!Capture.IsValid() || OutputSize.X <= 0 || OutputSize.Y <= 0)
+		{
+			continue;
+		}
+
+		// the result this slot held last, if the game thread did not take it, goes back to the pool
+		FTransferredFrame& Result = Results.GetWriteBuffer();
+		Result.Pixels = Pool->Acquire(OutputSize);
+		Result.InputSize = Capture->GetSize();
+
+		// FColor is laid out as BGRA, which is what the fused pre/post processing consumes and produces
+		const unsigned char* Input = reinterpret_cast<const unsigned char*>(Capture->GetData());
+		unsigned char* Output = reinterpret_cast<unsigned char*>(Result.Pixels->GetData());
+		Result.bSuccess = OpenVino_Infer_FromBGRAToSize(Input, Capture->GetSize().X, Capture->GetSize().Y, Capture->GetPitch(),
+			Output, OutputSize.X, OutputSize.Y, Result.Pixels->GetPitch(), bDebug);
+		if (Result.bSuccess)
+		{
+			// no string is formatted per frame unless debugging, Reset keeps the slot's allocation
+			Result.Log.Reset();
+			if (bDebug)
+			{
+				Result.Log = FString::Printf(TEXT("Success:Width(%d), Height(%d)"), OutputSize.X, OutputSize.Y);
+			}
+		}
+		else
+		{
+			// errors are kept per thread, this one is read here
+			char Error[512] = {};
+			Result.Log = OpenVino_GetLastError(Error, sizeof(Error)) ? FString(ANSI_TO_TCHAR(Error)) : TEXT("Failed to read OpenVino_GetLastError");
+			UE_LOG(LogStyleTransfer, Error, TEXT("OpenVino_GetLastError: %s"), *Result.Log);
+		}
+		Results.SwapWriteBuffers();
+	}
+	return 0;
+}
+
+void FStyleTransferPipeline::Stop()
+{
+	bStopping = true;
+	CaptureEvent->Trigger();
+}
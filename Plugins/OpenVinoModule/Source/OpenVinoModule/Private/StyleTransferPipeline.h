@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/TripleBuffer.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "RHI.h"
+#include "FrameBufferPool.h"
+
+#include <atomic>
+
+class FRHICommandListImmediate;
+class FRunnableThread;
+
+/** A captured frame after style transfer */
+struct FTransferredFrame
+{
+	TRefCountPtr<FFrameBuffer> Pixels;
+	// size of the capture it was transferred from
+	FIntPoint InputSize = FIntPoint::ZeroValue;
+	bool bSuccess = false;
+	// the error if the transfer failed, empty after a success unless debugging
+	FString Log;
+};
+
+/**
+ * Moves cpu mode frames between threads without blocking any of them. The render thread publishes captures,
+ * an inference thread always takes the newest one and publishes its result, and the game thread takes the
+ * newest result. Captures and results each pass through a lock-free triple buffer: a frame that is not taken
+ * in time is replaced by the next one, so inference never queues up behind the game.
+ */
+class FStyleTransferPipeline : public FRunnable
+{
+public:
+	FStyleTransferPipeline();
+	virtual ~FStyleTransferPipeline();
+
+	/**
+	 * @brief Start the inference thread, if it does not run yet
+	 * @param OutputSize, size of the results
+	 */
+	void Start(FIntPoint OutputSize, bool bInDebug);
+
+	/**
+	 * @brief Stop the inference thread, after the frame it is transferring. Captures and results not taken are dropped.
+	 */
+	void Shutdown();
+
+	bool IsRunning() const { return bRunning; }
+
+	/**
+	 * @brief Size of later results, e.g. once a session of another size was swapped in. Game thread.
+	 */
+	void SetOutputSize(FIntPoint Size);
+
+	/**
+	 * @brief Read a rectangle of the back buffer into a pooled buffer and hand it to the inference thread, it
+	 * replaces a capture that was not taken yet. 8 bit BGRA back buffers are copied into a ring of staging
+	 * textures and handed over a few captures later, once the GPU finished the copy, so the render thread
+	 * does not wait for it. Render thread only.
+	 */
+	void Capture_RenderThread(FRHICommandListImmediate& RHICmdList, FRHITexture2D* BackBuffer, FIntRect Rect);
+
+	/**
+	 * @brief The newest result since the last call, or nullptr. Valid until the next call, game thread only.
+	 */
+	const FTransferredFrame* TakeResult();
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	// copy into the next staging texture of the ring, for 8 bit BGRA back buffers
+	void CopyToStaging_RenderThread(FRHICommandListImmediate& RHICmdList, FRHITexture2D* BackBuffer, FIntRect Rect);
+	// publish the newest staging copy the GPU finished and drop older ones, false if none is finished
+	bool PublishStaging_RenderThread(FRHICommandListImmediate& RHICmdList);
+
+	TSharedRef<FFrameBufferPool, ESPMode::ThreadSafe> Pool;
+	TTripleBuffer<TRefCountPtr<FFrameBuffer>> Captures;
+	TTripleBuffer<FTransferredFrame> Results;
+	// signaled by every published capture
+	FEvent* CaptureEvent;
+	FRunnableThread* Thread;
+	FThreadSafeBool bStopping;
+	FThreadSafeBool bRunning;
+	// width in the upper and height in the lower half, so both change at once
+	std::atomic<uint64> PackedOutputSize;
+	bool bDebug;
+
+	/** A copy of the back buffer into a CPU readable texture, read once its fence signaled */
+	struct FStagingCopy
+	{
+		FTexture2DRHIRef Texture;
+		FGPUFenceRHIRef Fence;
+		FIntPoint Size = FIntPoint::ZeroValue;
+		// order the copies were issued in
+		uint64 Sequence = 0;
+		bool bPending = false;
+	};
+	// a copy still pending after this many captures is dropped, the GPU runs a whole ring behind
+	static constexpr int32 StagingRingSize = 3;
+
+	// render thread only
+	FStagingCopy StagingRing[StagingRingSize];
+	int32 StagingHead;
+	uint64 StagingSequence;
+	// back buffers of other formats are converted into it by ReadSurfaceData
+	TArray<FColor> ConvertedCapture;
+};
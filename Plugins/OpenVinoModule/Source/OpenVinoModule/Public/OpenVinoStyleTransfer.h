@@ -8,6 +8,9 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogStyleTransfer, Log, All);
 
+class FStyleTransferPipeline;
+struct FTransferredFrame;
+
 /** Delegate for the event fired when style transfer completes */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FStyleTransferComplete, const FString&, result, UTexture2D*, StyleTexture);
 
@@ -35,12 +38,38 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "OpenVINO Plugin")
 		void Release();
 
+	/**
+	 * @brief Registers another style IR, selected by setting r.OVST.Style to its name. The model passed
+	 * to Initialize is the style "default".
+	 * @param styleName
+	 * @param xmlFilePath
+	 * @param binFilePath
+	 * @return true if the files exist and the style was registered
+	 */
+	UFUNCTION(BlueprintCallable, Category = "OpenVINO Plugin")
+		bool RegisterStyle(FString styleName, FString xmlFilePath, FString binFilePath);
+
+	/**
+	 * @brief Picks the fastest variant of the style "default" (e.g. its FP32, FP16 and INT8 IRs, each with the
+	 * precision hints of r.OVST.ProbePrecisions) whose output stays within a PSNR/SSIM tolerance of the first IR, at
+	 * r.OVST.Width x r.OVST.Height. Probing takes a while the first time, call it after Initialize from a
+	 * loading screen; later calls on the same machine return the cached choice. Sets r.OVST.Precision.
+	 * @param xmlFilePaths, IRs of the style, the highest precision first
+	 * @param binFilePaths, weights of each IR
+	 * @param framesFolder, folder of representative screenshots, empty for synthetic frames
+	 * @param minPsnr, lowest PSNR in dB against the first IR, e.g. 30
+	 * @param minSsim, lowest SSIM against the first IR, e.g. 0.95
+	 * @return true if a variant was chosen
+	 */
+	UFUNCTION(BlueprintCallable, Category = "OpenVINO Plugin")
+		bool SelectModelVariant(TArray<FString> xmlFilePaths, TArray<FString> binFilePaths, FString framesFolder, float minPsnr, float minSsim);
+
 	UFUNCTION(BlueprintCallable, Category = "OpenVINO Plugin")
 		UTexture2D* GetTransferedTexture();
 
 	/**
 	* @brief This Blueprint event will be fired once classification has completed
-	* @param classification result
+	* @param classification result, the error if the transfer failed; empty after a success unless debugging
 	*/
 	UPROPERTY(BlueprintAssignable, Category = "OpenVINO Plugin")
 		FStyleTransferComplete OnStyleTransferComplete;
@@ -55,13 +84,13 @@ public:
 private:
 
 	/** Helper function to dynamically create a new texture from raw pixel data. */
-	UTexture2D* CreateTexture(FColor* data, int width, int height);
-	void UpdateTexture(UTexture2D* tex, FColor* data);
+	UTexture2D* CreateTexture(const FColor* data, int width, int height);
+	void UpdateTexture(UTexture2D* tex, const FColor* data);
+	// take a texture CreateTexture made off the root set, the garbage collector frees it
+	void ReleaseTexture(UTexture2D* tex);
 
-	// transfer style to utexture
-	// if texture created, return true
-	// else return false
-	bool StyleTransferToTexture(UObject* Outer, TArray<FColor>& TextureData, int Inwidth, int Inheight);
+	// show a frame the inference thread transferred, and broadcast it
+	void PresentResult(const FTransferredFrame& result);
 
 	// bind callback for frame buffer capture
 	void BindBackbufferCallback();
@@ -71,6 +100,19 @@ private:
 	void UpdateWidthHeight(int inmode);
 	void ReleaseWithMode(int inmode, bool force = false);
 	void CreateWithMode(int width, int height, int inmode, FString& indevice);
+	// swap in the session loading in the background once it is ready, cpu mode only
+	void PollSessionReady();
+
+	// forward changed r.OVST performance properties to OpenVINO
+	void ApplyPerformanceProperties();
+	// forward r.OVST.CoreSet, the running cpu mode session is loaded again on the new cores
+	void ApplyCoreSet();
+	// switch to the style r.OVST.Style names
+	void ApplyStyle();
+	// forward r.OVST.ChangeThreshold and publish r.OVST.SkipRatio, cpu mode only
+	void UpdateChangeDetection();
+	// forward r.OVST.FrameBudget and r.OVST.ResolutionScales and publish r.OVST.ResolutionRung, cpu mode only
+	void UpdateResolutionLadder();
 
 	/**
 	 * @brief Returns last error from OpenVino, logging it first to UE's log system
@@ -78,8 +120,8 @@ private:
 	 */
 	FString GetAndLogLastError();
 
-	/** Holds the future value which represents the asynchronous loading operation. */
-	TFuture<FColor*> Future;
+	/** Captures of the render thread, transferred on an inference thread, cpu mode only */
+	TSharedPtr<FStyleTransferPipeline, ESPMode::ThreadSafe> pipeline;
 
 	// mode
 	IConsoleVariable* transfer_mode;
@@ -94,26 +136,41 @@ private:
 	// output
 	IConsoleVariable* transfer_width;
 	IConsoleVariable* transfer_height;
+	// last value forwarded for each performance property console variable
+	TMap<FString, FString> applied_properties;
+	// core set forwarded last, empty (all cores) to begin with
+	FString applied_core_set;
 	int last_out_width;
 	int last_out_height;
-
-	// input
-	FVector2D input_origin;
+	// output size of the running session, 0 while none runs
+	FIntPoint session_size;
+	// output size of the session loading in the background
+	FIntPoint loading_size;
+	bool is_session_loading;
+	// change detection: threshold forwarded to the running session, negative if none was yet
+	float applied_change_threshold;
+	double skip_window_begin;
+	unsigned long long skip_window_checked;
+	unsigned long long skip_window_skipped;
+	// resolution ladder: values forwarded last, negative budget if none was yet
+	float applied_frame_budget;
+	FString applied_resolution_scales;
+	double rung_publish_time;
+
+	// input size of the last result
 	FIntPoint last_input_size;
-	FIntPoint input_size;
 
 	bool debug_flag;
 
-	TArray<FColor> fb_data;  // captured Texture data
-	TArray<BYTE> tmp_buffer; // captured RGB data for the readiness of AI inference
-	TArray<BYTE> buffer;     // style transfered RGB data from AI inference
-	TArray<FColor> rgba_buffer; // style transfered Texture data 
-
 	UTexture2D* out_tex;
 
 	class SStyleTransferResultDialog* dialog;
 	SWindow* window;
 
+	// files of the active style, see RegisterStyle
+	IConsoleVariable* transfer_style;
+	FString style;
+	TMap<FString, TPair<FString, FString>> style_files;
 	FString xml_file_path;
 	FString bin_file_path;
 
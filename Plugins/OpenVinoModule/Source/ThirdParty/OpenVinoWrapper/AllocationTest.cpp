@@ -0,0 +1,180 @@
+// AllocationTest.cpp : Checks that CPU mode frames do not allocate once the session is warm. Global operator
+// new/delete and the default OpenCV Mat allocator are replaced by counting versions, a few frames warm the
+// session up and the following frames through "OpenVino_Infer_FromBGRA" must not allocate at all.
+//
+// usage: ovst_alloc_test model.xml [frames] [width] [height]
+//
+// The wrapper sources are compiled into the test, so their allocations go through the operators replaced here.
+// Allocations inside the OpenVINO and OpenCV libraries are not seen, only those of the wrapper and of the Mats
+// it creates.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "OpenVinoWrapper.h"
+
+using namespace std;
+
+// frames before counting starts: lazy allocations, kernel selection and the first results
+static const int kWarmUpFrames = 8;
+
+static atomic<bool> counting(false);
+static atomic<unsigned long long> allocations(0);
+
+static void* CountedAlloc(size_t size)
+{
+	if (counting.load(memory_order_relaxed))
+		allocations.fetch_add(1, memory_order_relaxed);
+	void* p = malloc(size > 0 ? size : 1);
+	if (p == nullptr)
+		throw bad_alloc();
+	return p;
+}
+
+static void* CountedAlignedAlloc(size_t size, align_val_t alignment)
+{
+	if (counting.load(memory_order_relaxed))
+		allocations.fetch_add(1, memory_order_relaxed);
+#if defined _WIN32 || defined _WIN64
+	void* p = _aligned_malloc(size > 0 ? size : 1, static_cast<size_t>(alignment));
+#else
+	void* p = nullptr;
+	if (posix_memalign(&p, max(static_cast<size_t>(alignment), sizeof(void*)), size > 0 ? size : 1) != 0)
+		p = nullptr;
+#endif
+	if (p == nullptr)
+		throw bad_alloc();
+	return p;
+}
+
+static void CountedAlignedFree(void* p)
+{
+#if defined _WIN32 || defined _WIN64
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+// the array and nothrow forms of the standard library call these
+void* operator new(size_t size) { return CountedAlloc(size); }
+void* operator new[](size_t size) { return CountedAlloc(size); }
+void* operator new(size_t size, align_val_t alignment) { return CountedAlignedAlloc(size, alignment); }
+void* operator new[](size_t size, align_val_t alignment) { return CountedAlignedAlloc(size, alignment); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, align_val_t) noexcept { CountedAlignedFree(p); }
+void operator delete[](void* p, align_val_t) noexcept { CountedAlignedFree(p); }
+void operator delete(void* p, size_t, align_val_t) noexcept { CountedAlignedFree(p); }
+void operator delete[](void* p, size_t, align_val_t) noexcept { CountedAlignedFree(p); }
+
+/**
+ * @class CountingMatAllocator
+ * @brief Counts the Mats allocated while counting, the memory itself comes from the standard allocator of OpenCV
+ */
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+	cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+		cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override
+	{
+		if (counting.load(memory_order_relaxed))
+			allocations.fetch_add(1, memory_order_relaxed);
+		return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+	}
+
+	bool allocate(cv::UMatData* data, cv::AccessFlag accessflags, cv::UMatUsageFlags usageFlags) const override
+	{
+		return cv::Mat::getStdAllocator()->allocate(data, accessflags, usageFlags);
+	}
+
+	void deallocate(cv::UMatData* data) const override
+	{
+		cv::Mat::getStdAllocator()->deallocate(data);
+	}
+};
+
+/*
+ * @brief Fill a BGRA frame with a pattern that moves with "frame", so no frame is the same as the one before
+ */
+static void FillFrame(vector<unsigned char>& pixels, int width, int height, int frame)
+{
+	for (int y = 0; y < height; y++)
+	{
+		unsigned char* row = pixels.data() + static_cast<size_t>(y) * width * 4;
+		for (int x = 0; x < width; x++)
+		{
+			row[x * 4 + 0] = static_cast<unsigned char>(x + frame * 3);
+			row[x * 4 + 1] = static_cast<unsigned char>(y + frame * 5);
+			row[x * 4 + 2] = static_cast<unsigned char>(x + y + frame * 7);
+			row[x * 4 + 3] = 255;
+		}
+	}
+}
+
+static void PrintLastError(const char* call)
+{
+	char error[512] = {};
+	OpenVino_GetLastError(error, sizeof(error));
+	printf("%s failed: %s\n", call, error);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printf("usage: %s model.xml [frames] [width] [height]\n", argv[0]);
+		return 1;
+	}
+	string xml = argv[1];
+	string bin = xml.substr(0, xml.rfind('.')) + ".bin";
+	int frames = argc > 2 ? atoi(argv[2]) : 32;
+	int width = argc > 3 ? atoi(argv[3]) : 320;
+	int height = argc > 4 ? atoi(argv[4]) : 180;
+
+	// Mats the session creates from here on are counted
+	CountingMatAllocator mat_allocator;
+	cv::Mat::setDefaultAllocator(&mat_allocator);
+
+	if (!OpenVino_Initialize(xml.c_str(), bin.c_str(), width, height, "CPU"))
+	{
+		PrintLastError("OpenVino_Initialize");
+		return 1;
+	}
+
+	int pitch = width * 4;
+	vector<unsigned char> input(static_cast<size_t>(pitch) * height);
+	vector<unsigned char> output(static_cast<size_t>(pitch) * height);
+	bool passed = true;
+	for (int frame = 0; frame < kWarmUpFrames + frames && passed; frame++)
+	{
+		FillFrame(input, width, height, frame);
+		if (frame == kWarmUpFrames)
+			counting = true;
+		if (!OpenVino_Infer_FromBGRA(input.data(), width, height, pitch, output.data(), pitch, false))
+		{
+			counting = false;
+			PrintLastError("OpenVino_Infer_FromBGRA");
+			passed = false;
+		}
+	}
+	counting = false;
+
+	unsigned long long counted = allocations;
+	printf("%s at %dx%d: %llu allocations in %d frames after %d warm-up frames\n",
+		xml.c_str(), width, height, counted, frames, kWarmUpFrames);
+
+	OpenVino_Release();
+	cv::Mat::setDefaultAllocator(nullptr);
+
+	return passed && counted == 0 ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Nearest-rank percentile of the samples, 0 if there are none
+ * @param percent, percentile in (0,100], e.g. 99
+ */
+inline double Percentile(std::vector<double> samples, double percent)
+{
+	if (samples.empty())
+		return 0.0;
+	size_t rank = static_cast<size_t>(percent / 100.0 * samples.size() + 0.5);
+	rank = std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0);
+	std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+	return samples[rank];
+}
+
+/**
+ * @brief Median of the samples, the lower one of the middle two of an even count
+ */
+inline double Median(const std::vector<double>& samples)
+{
+	return Percentile(samples, 50.0);
+}
+
+/**
+ * @brief Mean of the samples, 0 if there are none
+ */
+inline double Mean(const std::vector<double>& samples)
+{
+	double sum = 0.0;
+	for (double sample : samples)
+		sum += sample;
+	return samples.empty() ? 0.0 : sum / samples.size();
+}
@@ -0,0 +1,333 @@
+#include "CpuAffinity.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <Windows.h>
+
+// arenas constrained to a NUMA node
+#define TBB_PREVIEW_NUMA_SUPPORT 1
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_observer.h>
+
+using namespace std;
+
+static const int kMaskBits = static_cast<int>(sizeof(KAFFINITY) * 8);
+
+/*
+ * @brief Global index of the first processor of each active processor group, and the processor count last
+ */
+static vector<int>
+GroupOffsets()
+{
+	vector<int> offsets;
+	int offset = 0;
+	WORD groups = GetActiveProcessorGroupCount();
+	for (WORD group = 0; group < groups; group++)
+	{
+		offsets.push_back(offset);
+		offset += static_cast<int>(GetActiveProcessorCount(group));
+	}
+	offsets.push_back(offset);
+	return offsets;
+}
+
+static void
+AddProcessors(const GROUP_AFFINITY& affinity, const vector<int>& offsets, vector<int>* processors)
+{
+	if (affinity.Group + 1 >= static_cast<int>(offsets.size()))
+		return;
+	for (int bit = 0; bit < kMaskBits; bit++)
+	{
+		if (affinity.Mask & (static_cast<KAFFINITY>(1) << bit))
+			processors->push_back(offsets[affinity.Group] + bit);
+	}
+}
+
+/*
+ * @brief Logical processors of the performance cores, those of the highest efficiency class, or of the
+ * efficiency cores, all others. Every core of a CPU that is not hybrid counts as a performance core.
+ */
+static vector<int>
+CoreTypeProcessors(bool performance, const vector<int>& offsets)
+{
+	DWORD length = 0;
+	GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &length);
+	vector<char> buffer(length);
+	if (!GetLogicalProcessorInformationEx(RelationProcessorCore,
+		reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data()), &length))
+		throw std::runtime_error("Can't read the processor topology");
+
+	vector<const PROCESSOR_RELATIONSHIP*> cores;
+	BYTE highest = 0;
+	for (DWORD offset = 0; offset < length;)
+	{
+		auto info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+		cores.push_back(&info->Processor);
+		highest = max(highest, info->Processor.EfficiencyClass);
+		offset += info->Size;
+	}
+
+	vector<int> processors;
+	for (const PROCESSOR_RELATIONSHIP* core : cores)
+	{
+		if ((core->EfficiencyClass == highest) != performance)
+			continue;
+		for (WORD group = 0; group < core->GroupCount; group++)
+			AddProcessors(core->GroupMask[group], offsets, &processors);
+	}
+	return processors;
+}
+
+static vector<int>
+NumaProcessors(int node, const vector<int>& offsets)
+{
+	vector<int> processors;
+	GROUP_AFFINITY affinity = {};
+	if (node >= 0 && node <= USHRT_MAX && GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity))
+		AddProcessors(affinity, offsets, &processors);
+	sort(processors.begin(), processors.end());
+	return processors;
+}
+
+CoreSet
+CoreSet::Parse(const std::string& spec)
+{
+	CoreSet set;
+	set.spec = spec;
+	if (spec.empty())
+		return set;
+
+	vector<int> offsets = GroupOffsets();
+	int total = offsets.back();
+	int node = -1;
+	if (spec == "P" || spec == "E")
+	{
+		set.processors = CoreTypeProcessors(spec == "P", offsets);
+		if (set.processors.empty())
+			throw std::invalid_argument("This CPU has no efficiency cores");
+	}
+	else if (sscanf(spec.c_str(), "numa:%d", &node) == 1)
+	{
+		set.processors = NumaProcessors(node, offsets);
+		if (set.processors.empty())
+			throw std::invalid_argument("No processors on NUMA node " + to_string(node));
+	}
+	else
+	{
+		stringstream list(spec);
+		string item;
+		while (getline(list, item, ','))
+		{
+			int first = -1;
+			int last = -1;
+			int fields = sscanf(item.c_str(), "%d-%d", &first, &last);
+			if (fields == 1)
+				last = first;
+			if (fields < 1 || first < 0 || last < first || last >= total)
+				throw std::invalid_argument("Invalid core set " + spec + ", logical processors are 0 to " + to_string(total - 1));
+			for (int processor = first; processor <= last; processor++)
+				set.processors.push_back(processor);
+		}
+	}
+	sort(set.processors.begin(), set.processors.end());
+	set.processors.erase(unique(set.processors.begin(), set.processors.end()), set.processors.end());
+
+	ULONG highest_node = 0;
+	GetNumaHighestNodeNumber(&highest_node);
+	for (ULONG candidate = 0; candidate <= highest_node; candidate++)
+	{
+		vector<int> node_processors = NumaProcessors(static_cast<int>(candidate), offsets);
+		if (includes(node_processors.begin(), node_processors.end(), set.processors.begin(), set.processors.end()))
+		{
+			set.numa_node = static_cast<int>(candidate);
+			break;
+		}
+	}
+	return set;
+}
+
+bool
+CoreSet::PinCurrentThread() const
+{
+	GROUP_AFFINITY affinity = {};
+	if (processors.empty())
+	{
+		GROUP_AFFINITY current = {};
+		if (!GetThreadGroupAffinity(GetCurrentThread(), &current))
+			return false;
+		int count = static_cast<int>(GetActiveProcessorCount(current.Group));
+		affinity.Group = current.Group;
+		affinity.Mask = count >= kMaskBits ? ~static_cast<KAFFINITY>(0) : (static_cast<KAFFINITY>(1) << count) - 1;
+		return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+	}
+
+	// a thread runs in one group, the one holding most processors of the set
+	vector<int> offsets = GroupOffsets();
+	int best_count = 0;
+	for (size_t group = 0; group + 1 < offsets.size(); group++)
+	{
+		KAFFINITY mask = 0;
+		int count = 0;
+		for (int processor : processors)
+		{
+			if (processor >= offsets[group] && processor < offsets[group + 1])
+			{
+				mask |= static_cast<KAFFINITY>(1) << (processor - offsets[group]);
+				count++;
+			}
+		}
+		if (count > best_count)
+		{
+			best_count = count;
+			affinity.Group = static_cast<WORD>(group);
+			affinity.Mask = mask;
+		}
+	}
+	return best_count > 0 && SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+}
+
+/*
+ * @class WorkerPinning
+ * @brief Pins every TBB worker thread to a core set when it enters the scheduler. Workers already running
+ * are told about a new observer on their next arena entry.
+ */
+class WorkerPinning : public tbb::task_scheduler_observer
+{
+public:
+	explicit WorkerPinning(const CoreSet& set)
+		: set(set)
+	{
+		observe(true);
+	}
+
+	void on_scheduler_entry(bool is_worker) override
+	{
+		// threads of the caller, e.g. the game thread running a kernel, keep their own affinity
+		if (is_worker)
+			set.PinCurrentThread();
+	}
+
+	const CoreSet& Set() const { return set; }
+
+private:
+	CoreSet set;
+};
+
+static mutex workerPinningMutex;
+static unique_ptr<WorkerPinning> workerPinning;
+// core sets of the live CPU sessions, oldest first
+static vector<CoreSet> workerPinningSessions;
+
+/*
+ * @brief Pin the workers to "set" unless they are already there; callers hold workerPinningMutex
+ */
+static void
+ApplyWorkerPinning(const CoreSet& set)
+{
+	if (workerPinning ? workerPinning->Set().Spec() == set.Spec() : set.Empty())
+		return;
+
+	// the observer replaced is not called any more, the new one pins or releases every worker
+	workerPinning = make_unique<WorkerPinning>(set);
+	if (set.Empty())
+		clog << "TBB workers run on every processor" << endl;
+	else
+		clog << "TBB workers pinned to " << set.Count() << " processors (" << set.Spec() << "), NUMA node " << set.NumaNode() << endl;
+}
+
+void
+CoreSet::PinTbbWorkers(const CoreSet& set)
+{
+	lock_guard<mutex> lock(workerPinningMutex);
+	string pinned = workerPinning ? workerPinning->Set().Spec() : string();
+	bool pinned_in_use = any_of(workerPinningSessions.begin(), workerPinningSessions.end(),
+		[&](const CoreSet& session) { return session.Spec() == pinned; });
+	workerPinningSessions.push_back(set);
+	if (pinned_in_use && pinned != set.Spec())
+	{
+		// moving the workers would take the other sessions' streams off their cores
+		clog << "Warning: TBB workers stay on core set \"" << pinned << "\" of a live CPU session, core set \""
+			<< set.Spec() << "\" applies to them once those sessions are released" << endl;
+		return;
+	}
+	ApplyWorkerPinning(set);
+}
+
+void
+CoreSet::ReleaseTbbWorkers(const CoreSet& set)
+{
+	lock_guard<mutex> lock(workerPinningMutex);
+	auto session = find_if(workerPinningSessions.rbegin(), workerPinningSessions.rend(),
+		[&](const CoreSet& candidate) { return candidate.Spec() == set.Spec(); });
+	if (session == workerPinningSessions.rend())
+		return;
+	workerPinningSessions.erase(next(session).base());
+
+	// without sessions the workers keep their pinning until the next one
+	string pinned = workerPinning ? workerPinning->Set().Spec() : string();
+	bool pinned_in_use = any_of(workerPinningSessions.begin(), workerPinningSessions.end(),
+		[&](const CoreSet& candidate) { return candidate.Spec() == pinned; });
+	if (!pinned_in_use && !workerPinningSessions.empty())
+		ApplyWorkerPinning(workerPinningSessions.back());
+}
+
+ScopedThreadAffinity::ScopedThreadAffinity(const CoreSet& set)
+	: pinned(false), previous_mask(0), previous_group(0)
+{
+	GROUP_AFFINITY previous = {};
+	if (set.Empty() || !GetThreadGroupAffinity(GetCurrentThread(), &previous))
+		return;
+	pinned = set.PinCurrentThread();
+	previous_mask = previous.Mask;
+	previous_group = previous.Group;
+}
+
+ScopedThreadAffinity::~ScopedThreadAffinity()
+{
+	if (!pinned)
+		return;
+	GROUP_AFFINITY previous = {};
+	previous.Mask = static_cast<KAFFINITY>(previous_mask);
+	previous.Group = previous_group;
+	SetThreadGroupAffinity(GetCurrentThread(), &previous, nullptr);
+}
+
+struct KernelArena::Arena
+{
+	template <typename... Args>
+	explicit Arena(Args... args)
+		: arena(args...)
+	{
+	}
+
+	tbb::task_arena arena;
+};
+
+KernelArena::KernelArena(const CoreSet& set)
+{
+	if (set.Empty())
+		return;
+	if (set.NumaNode() >= 0)
+		arena = make_unique<Arena>(tbb::task_arena::constraints(set.NumaNode(), set.Count()));
+	else
+		arena = make_unique<Arena>(set.Count());
+}
+
+KernelArena::~KernelArena()
+{
+}
+
+void
+KernelArena::Execute(const std::function<void()>& work)
+{
+	if (arena)
+		arena->arena.execute(work);
+	else
+		work();
+}
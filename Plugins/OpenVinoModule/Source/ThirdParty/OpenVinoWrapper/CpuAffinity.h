@@ -0,0 +1,94 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @class CoreSet
+ * @brief Logical processors CPU inference is kept on, so its threads leave the cores of the game, render
+ * and RHI threads alone. Processors are numbered across processor groups, group 0 first.
+ */
+class CoreSet
+{
+public:
+	/**
+	 * @brief Parse a core set
+	 * @param spec, "" for no restriction, "P" or "E" for the performance or efficiency cores of a hybrid
+	 * CPU, "numa:N" for the processors of NUMA node N, or logical processors and ranges such as "0-7,16"
+	 */
+	static CoreSet Parse(const std::string& spec);
+
+	/**
+	 * @brief Restrict TBB worker threads of the process to the core set of a CPU session as they enter the
+	 * scheduler. They run the host kernels and the streams of OpenVINO's CPU plugin. Process wide: while
+	 * sessions of another core set are live the workers stay where they are and a warning is logged, an
+	 * empty set lets the workers run anywhere. Balanced by "ReleaseTbbWorkers" when the session goes away.
+	 */
+	static void PinTbbWorkers(const CoreSet& set);
+
+	/**
+	 * @brief A session that pinned the workers to "set" is gone; once no live session uses the set the
+	 * workers move to the core set of the newest session left
+	 */
+	static void ReleaseTbbWorkers(const CoreSet& set);
+
+	bool Empty() const { return processors.empty(); }
+	int Count() const { return static_cast<int>(processors.size()); }
+	const std::string& Spec() const { return spec; }
+	/**
+	 * @brief NUMA node every processor of the set belongs to, -1 if they span nodes or the set is empty
+	 */
+	int NumaNode() const { return numa_node; }
+
+	/**
+	 * @brief Restrict the calling thread to the set, or to every processor of its group for an empty set.
+	 * A thread runs in one processor group, the group holding most processors of the set is used.
+	 * @return false if the system refused
+	 */
+	bool PinCurrentThread() const;
+
+private:
+	std::string spec;
+	std::vector<int> processors;
+	int numa_node = -1;
+};
+
+/**
+ * @class ScopedThreadAffinity
+ * @brief Keeps the calling thread on a core set for its lifetime. Memory first touched meanwhile, e.g. the
+ * weights and tensors allocated by compiling a model and creating its requests, lands on the NUMA node of the set.
+ */
+class ScopedThreadAffinity
+{
+public:
+	explicit ScopedThreadAffinity(const CoreSet& set);
+	~ScopedThreadAffinity();
+
+	ScopedThreadAffinity(const ScopedThreadAffinity&) = delete;
+	ScopedThreadAffinity& operator=(const ScopedThreadAffinity&) = delete;
+
+private:
+	bool pinned;
+	unsigned long long previous_mask;
+	unsigned short previous_group;
+};
+
+/**
+ * @class KernelArena
+ * @brief TBB arena the host kernels of a session run in: as many threads as its core set has processors,
+ * on the NUMA node of the set. Without a core set work runs in the default arena.
+ */
+class KernelArena
+{
+public:
+	explicit KernelArena(const CoreSet& set);
+	~KernelArena();
+
+	void Execute(const std::function<void()>& work);
+
+private:
+	struct Arena;
+	std::unique_ptr<Arena> arena;
+};
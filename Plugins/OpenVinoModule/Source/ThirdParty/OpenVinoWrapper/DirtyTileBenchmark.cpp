@@ -0,0 +1,152 @@
+// DirtyTileBenchmark.cpp : Replays recorded gameplay through tiled inference, once running every tile and
+// once running only the tiles whose window changed, and reports the tiles inferred again per frame and the
+// time saved.
+//
+// usage: ovst_dirty_tiles_bench model.xml gameplay.mp4 [frames] [tile size] [halo] [threshold]
+//
+// The model runs at the resolution of the recording; frames are decoded before each pass so decoding is
+// not timed.
+
+#if defined _WIN32 || defined _WIN64
+#define DLLEXPORT __declspec(dllimport)
+#else
+#define DLLEXPORT
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "BenchmarkUtil.h"
+#include "OpenVinoWrapper.h"
+
+using namespace std;
+
+/*
+ * @struct PassResult
+ * @brief Times and tile counts of one pass over the recording
+ */
+struct PassResult
+{
+	vector<double> times;       // ms per frame
+	vector<double> tiles;       // tiles inferred per frame
+	double tiles_per_frame = 0; // tiles of a frame
+};
+
+/*
+ * @brief Decode up to "maxFrames" frames of the recording as BGRA
+ */
+static vector<cv::Mat> DecodeFrames(const char* video, int maxFrames)
+{
+	vector<cv::Mat> frames;
+	cv::VideoCapture capture(video);
+	cv::Mat frame;
+	while (static_cast<int>(frames.size()) < maxFrames && capture.read(frame))
+	{
+		cv::Mat bgra;
+		cv::cvtColor(frame, bgra, cv::COLOR_BGR2BGRA);
+		frames.push_back(bgra);
+	}
+	return frames;
+}
+
+/*
+ * @brief Initialize tiled inference, run all frames and collect times and tiles inferred per frame
+ * @return false if initialization or inference failed
+ */
+static bool RunPass(const char* model, const vector<cv::Mat>& frames, int tileSize, int halo, float threshold, PassResult* result)
+{
+	int width = frames[0].cols;
+	int height = frames[0].rows;
+	string weights = string(model).substr(0, string(model).find_last_of('.')) + ".bin";
+	char error[512] = {};
+	OpenVino_SetTiling(tileSize, halo);
+	if (!OpenVino_Initialize(model, weights.c_str(), width, height, "CPU") || !OpenVino_SetDirtyTileThreshold(threshold))
+	{
+		OpenVino_GetLastError(error, sizeof(error));
+		printf("%s failed: %s\n", threshold > 0.0f ? "dirty tiles" : "all tiles", error);
+		OpenVino_Release();
+		return false;
+	}
+
+	vector<unsigned char> output(static_cast<size_t>(width) * height * 4);
+	// warm-up, and the first frame of the dirty pass runs every tile
+	OpenVino_Infer_FromBGRA(frames[0].data, width, height, static_cast<int>(frames[0].step), output.data(), width * 4, false);
+
+	OpenVinoStats stats = {};
+	OpenVino_GetStats(&stats);
+	unsigned long long inferred = stats.tiles_inferred;
+	int tiles_x = (width + tileSize - 1) / tileSize;
+	int tiles_y = (height + tileSize - 1) / tileSize;
+	result->tiles_per_frame = tiles_x * tiles_y;
+
+	for (size_t i = 1; i < frames.size(); i++)
+	{
+		chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+		bool done = OpenVino_Infer_FromBGRA(frames[i].data, width, height, static_cast<int>(frames[i].step),
+			output.data(), width * 4, false);
+		chrono::steady_clock::time_point end = chrono::steady_clock::now();
+		if (!done)
+		{
+			OpenVino_GetLastError(error, sizeof(error));
+			printf("frame %d failed: %s\n", static_cast<int>(i), error);
+			OpenVino_Release();
+			return false;
+		}
+		result->times.push_back(chrono::duration<double, milli>(end - begin).count());
+
+		// all tiles run without a threshold, they are not counted then
+		OpenVino_GetStats(&stats);
+		result->tiles.push_back(threshold > 0.0f ? static_cast<double>(stats.tiles_inferred - inferred) : result->tiles_per_frame);
+		inferred = stats.tiles_inferred;
+	}
+	OpenVino_Release();
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		printf("usage: %s model.xml gameplay.mp4 [frames] [tile size] [halo] [threshold]\n", argv[0]);
+		return 1;
+	}
+	const char* model = argv[1];
+	int max_frames = argc > 3 ? atoi(argv[3]) : 600;
+	int tile_size = argc > 4 ? atoi(argv[4]) : 256;
+	int halo = argc > 5 ? atoi(argv[5]) : -1;
+	float threshold = argc > 6 ? static_cast<float>(atof(argv[6])) : 2.0f;
+
+	vector<cv::Mat> frames = DecodeFrames(argv[2], max(2, max_frames));
+	if (frames.size() < 2)
+	{
+		printf("%s: less than two frames decoded\n", argv[2]);
+		return 1;
+	}
+	printf("%s: %d frames of %dx%d, tiles %d, threshold %.1f\n",
+		argv[2], static_cast<int>(frames.size()), frames[0].cols, frames[0].rows, tile_size, threshold);
+
+	PassResult all_tiles, dirty_tiles;
+	if (!RunPass(model, frames, tile_size, halo, 0.0f, &all_tiles) ||
+		!RunPass(model, frames, tile_size, halo, threshold, &dirty_tiles))
+		return 1;
+
+	vector<double> sorted_tiles = dirty_tiles.tiles;
+	sort(sorted_tiles.begin(), sorted_tiles.end());
+	printf("%-12s %10s %10s %14s\n", "", "mean ms", "median ms", "tiles/frame");
+	printf("%-12s %10.2f %10.2f %14.1f\n", "all tiles", Mean(all_tiles.times), Median(all_tiles.times), all_tiles.tiles_per_frame);
+	printf("%-12s %10.2f %10.2f %14.1f\n", "dirty tiles", Mean(dirty_tiles.times), Median(dirty_tiles.times), Mean(dirty_tiles.tiles));
+	printf("tiles inferred per frame: min %.0f, median %.0f, max %.0f of %.0f\n",
+		sorted_tiles.front(), Median(dirty_tiles.tiles), sorted_tiles.back(), dirty_tiles.tiles_per_frame);
+	double saved_ms = Mean(all_tiles.times) - Mean(dirty_tiles.times);
+	printf("time saved: %.2f ms per frame (%.0f%%)\n", saved_ms, 100.0 * saved_ms / Mean(all_tiles.times));
+	return 0;
+}
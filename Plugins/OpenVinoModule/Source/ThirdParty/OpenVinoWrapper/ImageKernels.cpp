@@ -0,0 +1,594 @@
+#include "ImageKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/blocked_range.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OVST_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define OVST_X86 0
+#endif
+
+// MSVC compiles intrinsics for any instruction set, gcc/clang need the target per function
+#if OVST_X86 && (defined(__GNUC__) || defined(__clang__))
+#define OVST_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define OVST_TARGET_AVX2
+#endif
+
+// rows handed to one TBB task
+static const int kRowGrain = 8;
+
+// (-1,1) normalization of 8 bit values
+static const float kNormScale = 2.0f / 255.0f;
+
+bool CpuSupportsAVX2()
+{
+#if OVST_X86
+#if defined(_MSC_VER)
+	static const bool supported = []()
+	{
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	}();
+	return supported;
+#else
+	static const bool supported = __builtin_cpu_supports("avx2");
+	return supported;
+#endif
+#else
+	return false;
+#endif
+}
+
+/*
+ * @brief Build the taps of one axis the way cv::resize INTER_LINEAR does (pixel centers aligned)
+ */
+static void BuildTaps(int srcSize, int dstSize, std::vector<int32_t>& i0, std::vector<int32_t>& i1, std::vector<float>& w)
+{
+	i0.resize(dstSize);
+	i1.resize(dstSize);
+	w.resize(dstSize);
+
+	double scale = static_cast<double>(srcSize) / dstSize;
+	for (int d = 0; d < dstSize; d++)
+	{
+		double f = (d + 0.5) * scale - 0.5;
+		int s = static_cast<int>(std::floor(f));
+		float frac = static_cast<float>(f - s);
+		if (s < 0)
+		{
+			s = 0;
+			frac = 0.0f;
+		}
+		if (s >= srcSize - 1)
+		{
+			s = srcSize - 1;
+			frac = 0.0f;
+		}
+		i0[d] = s;
+		i1[d] = std::min(s + 1, srcSize - 1);
+		w[d] = frac;
+	}
+}
+
+void PreprocessKernel::Configure(int srcWidth, int srcHeight, int dstWidth, int dstHeight)
+{
+	if (srcWidth == src_width && srcHeight == src_height &&
+		dstWidth == dst_width && dstHeight == dst_height)
+		return;
+
+	BuildTaps(srcWidth, dstWidth, x0, x1, wx);
+	BuildTaps(srcHeight, dstHeight, y0, y1, wy);
+
+	src_width = srcWidth;
+	src_height = srcHeight;
+	dst_width = dstWidth;
+	dst_height = dstHeight;
+}
+
+/*
+ * Row converters: each one handles as many pixels as its vector width allows and returns
+ * the first column left for the scalar tail.
+ */
+typedef int (*PreprocessRowFn)(const uint32_t* r0, const uint32_t* r1, float wy,
+	const int32_t* x0, const int32_t* x1, const float* wx, int width, float* b, float* g, float* r);
+
+static inline float LerpChannel(uint32_t p00, uint32_t p01, uint32_t p10, uint32_t p11, int shift, float wx, float wy)
+{
+	float a = static_cast<float>((p00 >> shift) & 0xFF);
+	float c = static_cast<float>((p01 >> shift) & 0xFF);
+	float d = static_cast<float>((p10 >> shift) & 0xFF);
+	float e = static_cast<float>((p11 >> shift) & 0xFF);
+	float top = a + (c - a) * wx;
+	float bottom = d + (e - d) * wx;
+	return (top + (bottom - top) * wy) * kNormScale - 1.0f;
+}
+
+static void PreprocessRowTail(const uint32_t* r0, const uint32_t* r1, float wy,
+	const int32_t* x0, const int32_t* x1, const float* wx, int begin, int width, float* b, float* g, float* r)
+{
+	for (int x = begin; x < width; x++)
+	{
+		uint32_t p00 = r0[x0[x]], p01 = r0[x1[x]];
+		uint32_t p10 = r1[x0[x]], p11 = r1[x1[x]];
+		b[x] = LerpChannel(p00, p01, p10, p11, 0, wx[x], wy);
+		g[x] = LerpChannel(p00, p01, p10, p11, 8, wx[x], wy);
+		r[x] = LerpChannel(p00, p01, p10, p11, 16, wx[x], wy);
+	}
+}
+
+#if OVST_X86
+static inline __m128 LerpChannelSSE2(__m128i p00, __m128i p01, __m128i p10, __m128i p11, int shift, __m128 wx, __m128 wy)
+{
+	const __m128i mask = _mm_set1_epi32(0xFF);
+	const __m128i count = _mm_cvtsi32_si128(shift);
+	__m128 a = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(p00, count), mask));
+	__m128 c = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(p01, count), mask));
+	__m128 d = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(p10, count), mask));
+	__m128 e = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(p11, count), mask));
+	__m128 top = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(c, a), wx));
+	__m128 bottom = _mm_add_ps(d, _mm_mul_ps(_mm_sub_ps(e, d), wx));
+	__m128 v = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), wy));
+	return _mm_sub_ps(_mm_mul_ps(v, _mm_set1_ps(kNormScale)), _mm_set1_ps(1.0f));
+}
+
+static int PreprocessRowSSE2(const uint32_t* r0, const uint32_t* r1, float wy,
+	const int32_t* x0, const int32_t* x1, const float* wx, int width, float* b, float* g, float* r)
+{
+	const __m128 vwy = _mm_set1_ps(wy);
+	int x = 0;
+	for (; x + 4 <= width; x += 4)
+	{
+		const int32_t* i0 = x0 + x;
+		const int32_t* i1 = x1 + x;
+		__m128i p00 = _mm_setr_epi32(r0[i0[0]], r0[i0[1]], r0[i0[2]], r0[i0[3]]);
+		__m128i p01 = _mm_setr_epi32(r0[i1[0]], r0[i1[1]], r0[i1[2]], r0[i1[3]]);
+		__m128i p10 = _mm_setr_epi32(r1[i0[0]], r1[i0[1]], r1[i0[2]], r1[i0[3]]);
+		__m128i p11 = _mm_setr_epi32(r1[i1[0]], r1[i1[1]], r1[i1[2]], r1[i1[3]]);
+		__m128 vwx = _mm_loadu_ps(wx + x);
+		_mm_storeu_ps(b + x, LerpChannelSSE2(p00, p01, p10, p11, 0, vwx, vwy));
+		_mm_storeu_ps(g + x, LerpChannelSSE2(p00, p01, p10, p11, 8, vwx, vwy));
+		_mm_storeu_ps(r + x, LerpChannelSSE2(p00, p01, p10, p11, 16, vwx, vwy));
+	}
+	return x;
+}
+
+OVST_TARGET_AVX2
+static inline __m256 LerpChannelAVX2(__m256i p00, __m256i p01, __m256i p10, __m256i p11, int shift, __m256 wx, __m256 wy)
+{
+	const __m256i mask = _mm256_set1_epi32(0xFF);
+	const __m128i count = _mm_cvtsi32_si128(shift);
+	__m256 a = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(p00, count), mask));
+	__m256 c = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(p01, count), mask));
+	__m256 d = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(p10, count), mask));
+	__m256 e = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(p11, count), mask));
+	__m256 top = _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(c, a), wx));
+	__m256 bottom = _mm256_add_ps(d, _mm256_mul_ps(_mm256_sub_ps(e, d), wx));
+	__m256 v = _mm256_add_ps(top, _mm256_mul_ps(_mm256_sub_ps(bottom, top), wy));
+	return _mm256_sub_ps(_mm256_mul_ps(v, _mm256_set1_ps(kNormScale)), _mm256_set1_ps(1.0f));
+}
+
+OVST_TARGET_AVX2
+static int PreprocessRowAVX2(const uint32_t* r0, const uint32_t* r1, float wy,
+	const int32_t* x0, const int32_t* x1, const float* wx, int width, float* b, float* g, float* r)
+{
+	const __m256 vwy = _mm256_set1_ps(wy);
+	const int* row0 = reinterpret_cast<const int*>(r0);
+	const int* row1 = reinterpret_cast<const int*>(r1);
+	int x = 0;
+	for (; x + 8 <= width; x += 8)
+	{
+		__m256i i0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x0 + x));
+		__m256i i1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x1 + x));
+		__m256i p00 = _mm256_i32gather_epi32(row0, i0, 4);
+		__m256i p01 = _mm256_i32gather_epi32(row0, i1, 4);
+		__m256i p10 = _mm256_i32gather_epi32(row1, i0, 4);
+		__m256i p11 = _mm256_i32gather_epi32(row1, i1, 4);
+		__m256 vwx = _mm256_loadu_ps(wx + x);
+		_mm256_storeu_ps(b + x, LerpChannelAVX2(p00, p01, p10, p11, 0, vwx, vwy));
+		_mm256_storeu_ps(g + x, LerpChannelAVX2(p00, p01, p10, p11, 8, vwx, vwy));
+		_mm256_storeu_ps(r + x, LerpChannelAVX2(p00, p01, p10, p11, 16, vwx, vwy));
+	}
+	return x;
+}
+#endif
+
+static PreprocessRowFn SelectPreprocessRow()
+{
+#if OVST_X86
+	return CpuSupportsAVX2() ? PreprocessRowAVX2 : PreprocessRowSSE2;
+#else
+	return nullptr;
+#endif
+}
+
+void PreprocessKernel::RunRows(const unsigned char* src, int srcPitch, float* dst, int rowBegin, int rowEnd) const
+{
+	static const PreprocessRowFn row_fn = SelectPreprocessRow();
+
+	size_t plane = static_cast<size_t>(dst_width) * dst_height;
+	for (int y = rowBegin; y < rowEnd; y++)
+	{
+		const uint32_t* r0 = reinterpret_cast<const uint32_t*>(src + static_cast<size_t>(y0[y]) * srcPitch);
+		const uint32_t* r1 = reinterpret_cast<const uint32_t*>(src + static_cast<size_t>(y1[y]) * srcPitch);
+		float* b = dst + static_cast<size_t>(y) * dst_width;
+		float* g = b + plane;
+		float* r = g + plane;
+
+		int done = row_fn ? row_fn(r0, r1, wy[y], x0.data(), x1.data(), wx.data(), dst_width, b, g, r) : 0;
+		PreprocessRowTail(r0, r1, wy[y], x0.data(), x1.data(), wx.data(), done, dst_width, b, g, r);
+	}
+}
+
+void PreprocessKernel::Run(const unsigned char* src, int srcPitch, float* dst) const
+{
+	tbb::parallel_for(tbb::blocked_range<int>(0, dst_height, kRowGrain),
+		[this, src, srcPitch, dst](const tbb::blocked_range<int>& rows)
+		{
+			RunRows(src, srcPitch, dst, rows.begin(), rows.end());
+		});
+}
+
+/*
+ * Postprocessing row converters, same convention as the preprocessing ones. When minmax is not null
+ * the raw model values of the row are folded into minmax[0]/minmax[1].
+ */
+typedef int (*PostprocessRowFn)(const float* r, const float* g, const float* b, int width,
+	float scale, float bias, uint32_t* dst, float* minmax);
+
+static inline uint32_t MapChannel(float v, float scale, float bias)
+{
+	float m = std::min(std::max(v * scale + bias, 0.0f), 255.0f);
+	return static_cast<uint32_t>(std::lrint(m));
+}
+
+static void PostprocessRowTail(const float* r, const float* g, const float* b, int begin, int width,
+	float scale, float bias, uint32_t* dst, float* minmax)
+{
+	for (int x = begin; x < width; x++)
+	{
+		dst[x] = MapChannel(b[x], scale, bias) |
+			(MapChannel(g[x], scale, bias) << 8) |
+			(MapChannel(r[x], scale, bias) << 16) |
+			0xFF000000u;
+		if (minmax)
+		{
+			minmax[0] = std::min(minmax[0], std::min(r[x], std::min(g[x], b[x])));
+			minmax[1] = std::max(minmax[1], std::max(r[x], std::max(g[x], b[x])));
+		}
+	}
+}
+
+#if OVST_X86
+static inline __m128i MapChannelSSE2(__m128 v, __m128 scale, __m128 bias)
+{
+	__m128 m = _mm_add_ps(_mm_mul_ps(v, scale), bias);
+	m = _mm_min_ps(_mm_max_ps(m, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+	return _mm_cvtps_epi32(m);
+}
+
+static int PostprocessRowSSE2(const float* r, const float* g, const float* b, int width,
+	float scale, float bias, uint32_t* dst, float* minmax)
+{
+	const __m128 vscale = _mm_set1_ps(scale);
+	const __m128 vbias = _mm_set1_ps(bias);
+	const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+	__m128 vmin = _mm_set1_ps(std::numeric_limits<float>::max());
+	__m128 vmax = _mm_set1_ps(std::numeric_limits<float>::lowest());
+	int x = 0;
+	for (; x + 4 <= width; x += 4)
+	{
+		__m128 vr = _mm_loadu_ps(r + x);
+		__m128 vg = _mm_loadu_ps(g + x);
+		__m128 vb = _mm_loadu_ps(b + x);
+		__m128i pixel = _mm_or_si128(
+			_mm_or_si128(MapChannelSSE2(vb, vscale, vbias), _mm_slli_epi32(MapChannelSSE2(vg, vscale, vbias), 8)),
+			_mm_or_si128(_mm_slli_epi32(MapChannelSSE2(vr, vscale, vbias), 16), alpha));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), pixel);
+		if (minmax)
+		{
+			vmin = _mm_min_ps(vmin, _mm_min_ps(vr, _mm_min_ps(vg, vb)));
+			vmax = _mm_max_ps(vmax, _mm_max_ps(vr, _mm_max_ps(vg, vb)));
+		}
+	}
+	if (minmax && x > 0)
+	{
+		float lanes_min[4], lanes_max[4];
+		_mm_storeu_ps(lanes_min, vmin);
+		_mm_storeu_ps(lanes_max, vmax);
+		for (int i = 0; i < 4; i++)
+		{
+			minmax[0] = std::min(minmax[0], lanes_min[i]);
+			minmax[1] = std::max(minmax[1], lanes_max[i]);
+		}
+	}
+	return x;
+}
+
+OVST_TARGET_AVX2
+static inline __m256i MapChannelAVX2(__m256 v, __m256 scale, __m256 bias)
+{
+	__m256 m = _mm256_add_ps(_mm256_mul_ps(v, scale), bias);
+	m = _mm256_min_ps(_mm256_max_ps(m, _mm256_setzero_ps()), _mm256_set1_ps(255.0f));
+	return _mm256_cvtps_epi32(m);
+}
+
+OVST_TARGET_AVX2
+static int PostprocessRowAVX2(const float* r, const float* g, const float* b, int width,
+	float scale, float bias, uint32_t* dst, float* minmax)
+{
+	const __m256 vscale = _mm256_set1_ps(scale);
+	const __m256 vbias = _mm256_set1_ps(bias);
+	const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+	__m256 vmin = _mm256_set1_ps(std::numeric_limits<float>::max());
+	__m256 vmax = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+	int x = 0;
+	for (; x + 8 <= width; x += 8)
+	{
+		__m256 vr = _mm256_loadu_ps(r + x);
+		__m256 vg = _mm256_loadu_ps(g + x);
+		__m256 vb = _mm256_loadu_ps(b + x);
+		__m256i pixel = _mm256_or_si256(
+			_mm256_or_si256(MapChannelAVX2(vb, vscale, vbias), _mm256_slli_epi32(MapChannelAVX2(vg, vscale, vbias), 8)),
+			_mm256_or_si256(_mm256_slli_epi32(MapChannelAVX2(vr, vscale, vbias), 16), alpha));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), pixel);
+		if (minmax)
+		{
+			vmin = _mm256_min_ps(vmin, _mm256_min_ps(vr, _mm256_min_ps(vg, vb)));
+			vmax = _mm256_max_ps(vmax, _mm256_max_ps(vr, _mm256_max_ps(vg, vb)));
+		}
+	}
+	if (minmax && x > 0)
+	{
+		float lanes_min[8], lanes_max[8];
+		_mm256_storeu_ps(lanes_min, vmin);
+		_mm256_storeu_ps(lanes_max, vmax);
+		for (int i = 0; i < 8; i++)
+		{
+			minmax[0] = std::min(minmax[0], lanes_min[i]);
+			minmax[1] = std::max(minmax[1], lanes_max[i]);
+		}
+	}
+	return x;
+}
+#endif
+
+static PostprocessRowFn SelectPostprocessRow()
+{
+#if OVST_X86
+	return CpuSupportsAVX2() ? PostprocessRowAVX2 : PostprocessRowSSE2;
+#else
+	return nullptr;
+#endif
+}
+
+void PostprocessKernel::SetFixedRange(float minValue, float maxValue)
+{
+	range_min = minValue;
+	range_max = maxValue;
+	smoothing = 0.0f;
+	has_estimate = false;
+}
+
+void PostprocessKernel::SetRunningRange(float newestWeight)
+{
+	smoothing = std::min(std::max(newestWeight, 0.0f), 1.0f);
+	has_estimate = false;
+}
+
+void PostprocessKernel::Run(const float* src, int width, int height, unsigned char* dst, int dstPitch)
+{
+	static const PostprocessRowFn row_fn = SelectPostprocessRow();
+
+	const bool track = smoothing > 0.0f;
+	float scale = range_max > range_min ? 255.0f / (range_max - range_min) : 0.0f;
+	float bias = -range_min * scale;
+	size_t plane = static_cast<size_t>(width) * height;
+
+	typedef std::pair<float, float> MinMax;
+	const MinMax empty(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+	MinMax measured = tbb::parallel_reduce(tbb::blocked_range<int>(0, height, kRowGrain), empty,
+		[=](const tbb::blocked_range<int>& rows, MinMax acc)
+		{
+			float minmax[2] = { acc.first, acc.second };
+			for (int y = rows.begin(); y < rows.end(); y++)
+			{
+				const float* r = src + static_cast<size_t>(y) * width;
+				const float* g = r + plane;
+				const float* b = g + plane;
+				uint32_t* out = reinterpret_cast<uint32_t*>(dst + static_cast<size_t>(y) * dstPitch);
+
+				int done = row_fn ? row_fn(r, g, b, width, scale, bias, out, track ? minmax : nullptr) : 0;
+				PostprocessRowTail(r, g, b, done, width, scale, bias, out, track ? minmax : nullptr);
+			}
+			return MinMax(minmax[0], minmax[1]);
+		},
+		[](const MinMax& a, const MinMax& b)
+		{
+			return MinMax(std::min(a.first, b.first), std::max(a.second, b.second));
+		});
+
+	// the range measured on this frame is applied from the next one on
+	if (track && measured.first <= measured.second)
+	{
+		float weight = has_estimate ? smoothing : 1.0f;
+		range_min += (measured.first - range_min) * weight;
+		range_max += (measured.second - range_max) * weight;
+		has_estimate = true;
+	}
+}
+
+// grid spacing of the change detector in pixels, both directions
+static const int kChangeStep = 4;
+
+/*
+ * Sum of absolute differences of two byte arrays, same convention as the row converters.
+ */
+typedef int (*SadFn)(const uint8_t* a, const uint8_t* b, int size, uint64_t* sum);
+
+#if OVST_X86
+static int SadSSE2(const uint8_t* a, const uint8_t* b, int size, uint64_t* sum)
+{
+	__m128i acc = _mm_setzero_si128();
+	int i = 0;
+	for (; i + 16 <= size; i += 16)
+	{
+		__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+		__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+	}
+	uint64_t lanes[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+	*sum += lanes[0] + lanes[1];
+	return i;
+}
+
+OVST_TARGET_AVX2
+static int SadAVX2(const uint8_t* a, const uint8_t* b, int size, uint64_t* sum)
+{
+	__m256i acc = _mm256_setzero_si256();
+	int i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		__m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+		__m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+		acc = _mm256_add_epi64(acc, _mm256_sad_epu8(va, vb));
+	}
+	uint64_t lanes[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+	*sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	return i;
+}
+#endif
+
+static SadFn SelectSad()
+{
+#if OVST_X86
+	return CpuSupportsAVX2() ? SadAVX2 : SadSSE2;
+#else
+	return nullptr;
+#endif
+}
+
+/*
+ * @brief Sum of absolute differences of two luma rows
+ */
+static uint64_t SumAbsDiff(const uint8_t* a, const uint8_t* b, int size)
+{
+	static const SadFn sad_fn = SelectSad();
+
+	uint64_t sum = 0;
+	int done = sad_fn ? sad_fn(a, b, size, &sum) : 0;
+	for (int i = done; i < size; i++)
+	{
+		sum += static_cast<uint64_t>(std::abs(a[i] - b[i]));
+	}
+	return sum;
+}
+
+float ChangeDetector::Measure(const unsigned char* src, int frameWidth, int frameHeight, int pitch)
+{
+	int grid_width = (frameWidth + kChangeStep - 1) / kChangeStep;
+	int grid_height = (frameHeight + kChangeStep - 1) / kChangeStep;
+	current.resize(static_cast<size_t>(grid_width) * grid_height);
+	for (int gy = 0; gy < grid_height; gy++)
+	{
+		const uint32_t* row = reinterpret_cast<const uint32_t*>(src + static_cast<size_t>(gy) * kChangeStep * pitch);
+		uint8_t* luma = current.data() + static_cast<size_t>(gy) * grid_width;
+		for (int gx = 0; gx < grid_width; gx++)
+		{
+			uint32_t p = row[gx * kChangeStep];
+			// BT.601 weights in 8 bit fixed point
+			luma[gx] = static_cast<uint8_t>((29 * (p & 0xFF) + 150 * ((p >> 8) & 0xFF) + 77 * ((p >> 16) & 0xFF)) >> 8);
+		}
+	}
+
+	if (!has_reference || frameWidth != width || frameHeight != height)
+	{
+		width = frameWidth;
+		height = frameHeight;
+		has_reference = false;
+		return 255.0f;
+	}
+
+	int size = static_cast<int>(current.size());
+	uint64_t sum = SumAbsDiff(current.data(), reference.data(), size);
+	return static_cast<float>(static_cast<double>(sum) / size);
+}
+
+float ChangeDetector::MeasureRegion(int x, int y, int regionWidth, int regionHeight) const
+{
+	if (!has_reference)
+		return 255.0f;
+
+	int grid_width = (width + kChangeStep - 1) / kChangeStep;
+	int grid_height = (height + kChangeStep - 1) / kChangeStep;
+	int gx_begin = std::max(0, x / kChangeStep);
+	int gx_end = std::min(grid_width, (x + regionWidth + kChangeStep - 1) / kChangeStep);
+	int gy_begin = std::max(0, y / kChangeStep);
+	int gy_end = std::min(grid_height, (y + regionHeight + kChangeStep - 1) / kChangeStep);
+	if (gx_end <= gx_begin || gy_end <= gy_begin)
+		return 0.0f;
+
+	uint64_t sum = 0;
+	for (int gy = gy_begin; gy < gy_end; gy++)
+	{
+		size_t offset = static_cast<size_t>(gy) * grid_width + gx_begin;
+		sum += SumAbsDiff(current.data() + offset, reference.data() + offset, gx_end - gx_begin);
+	}
+	return static_cast<float>(static_cast<double>(sum) / (static_cast<double>(gx_end - gx_begin) * (gy_end - gy_begin)));
+}
+
+void ChangeDetector::Accept()
+{
+	std::swap(reference, current);
+	has_reference = true;
+}
+
+void ChangeDetector::AcceptRegion(int x, int y, int regionWidth, int regionHeight)
+{
+	if (!has_reference)
+	{
+		reference = current;
+		has_reference = true;
+		return;
+	}
+
+	int grid_width = (width + kChangeStep - 1) / kChangeStep;
+	int grid_height = (height + kChangeStep - 1) / kChangeStep;
+	int gx_begin = std::max(0, x / kChangeStep);
+	int gx_end = std::min(grid_width, (x + regionWidth + kChangeStep - 1) / kChangeStep);
+	int gy_begin = std::max(0, y / kChangeStep);
+	int gy_end = std::min(grid_height, (y + regionHeight + kChangeStep - 1) / kChangeStep);
+	for (int gy = gy_begin; gy < gy_end && gx_end > gx_begin; gy++)
+	{
+		size_t offset = static_cast<size_t>(gy) * grid_width + gx_begin;
+		memcpy(reference.data() + offset, current.data() + offset, gx_end - gx_begin);
+	}
+}
+
+void ChangeDetector::Reset()
+{
+	has_reference = false;
+}
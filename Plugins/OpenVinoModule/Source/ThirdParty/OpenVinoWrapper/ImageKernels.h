@@ -0,0 +1,136 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+/**
+ * @class PreprocessKernel
+ * @brief Fused conversion of a captured BGRA8 frame into the planar float input of the model:
+ * bilinear resize (same sampling as cv::resize INTER_LINEAR), (-1,1) normalization and
+ * interleaved to planar (B,G,R planes) in a single pass over the frame.
+ */
+class PreprocessKernel
+{
+	int src_width = 0;
+	int src_height = 0;
+	int dst_width = 0;
+	int dst_height = 0;
+
+	// Horizontal taps per output column: left/right source pixel and weight of the right one
+	std::vector<int32_t> x0, x1;
+	std::vector<float> wx;
+	// Vertical taps per output row
+	std::vector<int32_t> y0, y1;
+	std::vector<float> wy;
+
+public:
+	/**
+	 * @brief Precompute interpolation tables, tables are only rebuilt when a size changes
+	 * @param srcWidth, width of the captured frame
+	 * @param srcHeight, height of the captured frame
+	 * @param dstWidth, width of the model input
+	 * @param dstHeight, height of the model input
+	 */
+	void Configure(int srcWidth, int srcHeight, int dstWidth, int dstHeight);
+
+	/**
+	 * @brief Convert one frame, rows are processed in parallel chunks
+	 * @param src, BGRA8 pixels of srcWidth x srcHeight
+	 * @param srcPitch, distance in bytes between two source rows
+	 * @param dst, three planes of dstWidth x dstHeight floats in B,G,R order
+	 */
+	void Run(const unsigned char* src, int srcPitch, float* dst) const;
+
+private:
+	void RunRows(const unsigned char* src, int srcPitch, float* dst, int rowBegin, int rowEnd) const;
+};
+
+/**
+ * @class PostprocessKernel
+ * @brief Fused conversion of the planar float output of the model (R,G,B planes) into interleaved
+ * BGRA8 rows of a caller provided buffer, ready to be uploaded to a texture.
+ * Values are mapped with a fixed affine transform; optionally the transform follows a running
+ * estimate of the output range, measured while writing so no extra pass over the frame is needed.
+ */
+class PostprocessKernel
+{
+	// output range of the model mapped onto (0,255)
+	float range_min = -1.0f;
+	float range_max = 1.0f;
+	// weight of the newest frame in the running range estimate, 0 keeps the range fixed
+	float smoothing = 0.0f;
+	bool has_estimate = false;
+
+public:
+	/**
+	 * @brief Map a fixed range of model output values onto (0,255)
+	 */
+	void SetFixedRange(float minValue, float maxValue);
+
+	/**
+	 * @brief Follow the range of the model output with an exponential moving average of per-frame min/max
+	 * @param newestWeight, weight of the newest frame in (0,1]
+	 */
+	void SetRunningRange(float newestWeight);
+
+	/**
+	 * @brief Convert one frame, rows are processed in parallel chunks
+	 * @param src, three planes of width x height floats in R,G,B order
+	 * @param dst, BGRA8 rows of width pixels
+	 * @param dstPitch, distance in bytes between two destination rows
+	 */
+	void Run(const float* src, int width, int height, unsigned char* dst, int dstPitch);
+};
+
+/**
+ * @class ChangeDetector
+ * @brief Cheap measure of how much a captured BGRA8 frame differs from a reference frame: the luma of
+ * every 4th pixel of every 4th row is compared by mean absolute difference, without a pass over the
+ * whole frame.
+ */
+class ChangeDetector
+{
+	int width = 0;
+	int height = 0;
+	// luma grid of the reference frame, and of the frame measured last
+	std::vector<uint8_t> reference;
+	std::vector<uint8_t> current;
+	bool has_reference = false;
+
+public:
+	/**
+	 * @brief Sample the luma grid of a frame and compare it with the reference
+	 * @param src, BGRA8 pixels of width x height
+	 * @param pitch, distance in bytes between two rows
+	 * @return mean absolute luma difference in (0,255), 255 without a reference of the same size
+	 */
+	float Measure(const unsigned char* src, int width, int height, int pitch);
+
+	/**
+	 * @brief Compare a rectangle of the frame measured last with the same rectangle of the reference
+	 * @param x, y, regionWidth, regionHeight, rectangle in pixels of the frame
+	 * @return mean absolute luma difference in (0,255), 255 without a reference
+	 */
+	float MeasureRegion(int x, int y, int regionWidth, int regionHeight) const;
+
+	/**
+	 * @brief Make the frame measured last the reference
+	 */
+	void Accept();
+
+	/**
+	 * @brief Make a rectangle of the frame measured last part of the reference, the rest is kept;
+	 * without a reference the whole frame becomes the reference
+	 */
+	void AcceptRegion(int x, int y, int regionWidth, int regionHeight);
+
+	/**
+	 * @brief Forget the reference, the next frame measures as changed
+	 */
+	void Reset();
+};
+
+/**
+ * @brief Check once whether the running CPU and OS support AVX2
+ */
+bool CpuSupportsAVX2();
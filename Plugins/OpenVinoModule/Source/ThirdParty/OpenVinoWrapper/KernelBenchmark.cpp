@@ -0,0 +1,163 @@
+// KernelBenchmark.cpp : Compares the fused CPU pre/post processing kernels with the OpenCV sequence
+// they replace, at the capture resolutions we ship with.
+//
+// usage: ovst_kernel_bench [iterations]
+
+#include "BenchmarkUtil.h"
+#include "ImageKernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+using namespace std;
+
+struct Resolution
+{
+	const char* name;
+	int width;
+	int height;
+};
+
+static const Resolution kCaptureSizes[] = {
+	{ "720p", 1280, 720 },
+	{ "1080p", 1920, 1080 },
+	{ "4K", 3840, 2160 },
+};
+
+/*
+ * @brief Median time in ms of one call of fn
+ */
+static double MedianMs(int iterations, const function<void()>& fn)
+{
+	// warm-up, lets scratch buffers and the TBB arena settle
+	fn();
+
+	vector<double> times(iterations);
+	for (int i = 0; i < iterations; i++)
+	{
+		chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+		fn();
+		chrono::steady_clock::time_point end = chrono::steady_clock::now();
+		times[i] = chrono::duration<double, milli>(end - begin).count();
+	}
+	return Median(times);
+}
+
+static void BenchPreprocess(const Resolution& capture, int modelWidth, int modelHeight, int iterations)
+{
+	cv::Mat bgra(capture.height, capture.width, CV_8UC4);
+	cv::randu(bgra, cv::Scalar::all(0), cv::Scalar::all(255));
+
+	vector<float> planar(3 * static_cast<size_t>(modelWidth) * modelHeight);
+	size_t plane = static_cast<size_t>(modelWidth) * modelHeight;
+
+	// Previous CPU path: repack to BGR, convert, resize, split to planes
+	cv::Mat bgr(capture.height, capture.width, CV_8UC3), float_image, resized_image;
+	double opencv_ms = MedianMs(iterations, [&]()
+		{
+			for (int y = 0; y < capture.height; y++)
+			{
+				const unsigned char* src = bgra.ptr<unsigned char>(y);
+				unsigned char* dst = bgr.ptr<unsigned char>(y);
+				for (int x = 0; x < capture.width; x++)
+				{
+					dst[3 * x] = src[4 * x];
+					dst[3 * x + 1] = src[4 * x + 1];
+					dst[3 * x + 2] = src[4 * x + 2];
+				}
+			}
+			bgr.convertTo(float_image, CV_32F, 2.0 / 255, -1.0);
+			cv::resize(float_image, resized_image, cv::Size(modelWidth, modelHeight));
+			cv::Mat planes[3] = {
+				cv::Mat(modelHeight, modelWidth, CV_32FC1, planar.data()),
+				cv::Mat(modelHeight, modelWidth, CV_32FC1, planar.data() + plane),
+				cv::Mat(modelHeight, modelWidth, CV_32FC1, planar.data() + 2 * plane) };
+			cv::split(resized_image, planes);
+		});
+
+	PreprocessKernel kernel;
+	kernel.Configure(capture.width, capture.height, modelWidth, modelHeight);
+	double fused_ms = MedianMs(iterations, [&]()
+		{
+			kernel.Run(bgra.data, static_cast<int>(bgra.step), planar.data());
+		});
+
+	printf("preprocess  %-6s -> %4dx%-4d  opencv %7.2f ms  fused %7.2f ms  speedup %5.2fx\n",
+		capture.name, modelWidth, modelHeight, opencv_ms, fused_ms, opencv_ms / fused_ms);
+}
+
+static void BenchPostprocess(const Resolution& output, int iterations)
+{
+	int width = output.width, height = output.height;
+	size_t plane = static_cast<size_t>(width) * height;
+	vector<float> blob(3 * plane);
+	cv::Mat blob_mat(1, static_cast<int>(blob.size()), CV_32FC1, blob.data());
+	cv::randu(blob_mat, cv::Scalar::all(-1.0), cv::Scalar::all(1.0));
+
+	vector<unsigned char> bgr(3 * plane);
+	vector<unsigned char> bgra(4 * plane);
+
+	// Previous CPU path: copy blob, merge planes, min/max normalize, convert, copy out, expand to BGRA
+	cv::Mat output_image;
+	double opencv_ms = MedianMs(iterations, [&]()
+		{
+			vector<float> output_data(blob.begin(), blob.end());
+			cv::Mat channelR(height, width, CV_32FC1, output_data.data());
+			cv::Mat channelG(height, width, CV_32FC1, output_data.data() + plane);
+			cv::Mat channelB(height, width, CV_32FC1, output_data.data() + 2 * plane);
+			vector<cv::Mat> channels{ channelB, channelG, channelR };
+			cv::merge(channels, output_image);
+			cv::normalize(output_image, output_image, 0, 255, cv::NORM_MINMAX);
+			output_image.convertTo(output_image, CV_8U);
+			memcpy(bgr.data(), output_image.data, bgr.size());
+			for (size_t i = 0, index = 0; i < plane; i++, index += 3)
+			{
+				bgra[4 * i] = bgr[index];
+				bgra[4 * i + 1] = bgr[index + 1];
+				bgra[4 * i + 2] = bgr[index + 2];
+				bgra[4 * i + 3] = 255;
+			}
+		});
+
+	PostprocessKernel kernel;
+	double fused_ms = MedianMs(iterations, [&]()
+		{
+			kernel.Run(blob.data(), width, height, bgra.data(), width * 4);
+		});
+	kernel.SetRunningRange(0.1f);
+	double running_ms = MedianMs(iterations, [&]()
+		{
+			kernel.Run(blob.data(), width, height, bgra.data(), width * 4);
+		});
+
+	printf("postprocess %-6s               opencv %7.2f ms  fused %7.2f ms  speedup %5.2fx  (running range %7.2f ms)\n",
+		output.name, opencv_ms, fused_ms, opencv_ms / fused_ms, running_ms);
+}
+
+int main(int argc, char* argv[])
+{
+	int iterations = argc > 1 ? atoi(argv[1]) : 50;
+	if (iterations < 1)
+		iterations = 1;
+
+	printf("AVX2: %s, %d iterations\n", CpuSupportsAVX2() ? "yes" : "no", iterations);
+	for (const Resolution& capture : kCaptureSizes)
+	{
+		// r.OVST.Width/Height default and the full-resolution size used by the upscaler path
+		BenchPreprocess(capture, 512, 512, iterations);
+		BenchPreprocess(capture, capture.width, capture.height, iterations);
+	}
+	for (const Resolution& output : kCaptureSizes)
+	{
+		BenchPostprocess(output, iterations);
+	}
+	return 0;
+}
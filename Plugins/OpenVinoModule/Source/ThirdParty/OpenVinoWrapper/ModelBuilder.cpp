@@ -0,0 +1,207 @@
+#include "ModelBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+
+#include "openvino/opsets/opset8.hpp"
+#include "openvino/runtime/intel_gpu/properties.hpp"
+
+using namespace std;
+using namespace ov::opset8;
+
+/*
+ * @brief Map (-1,1) network output onto rounded, clamped 8 bit values and append an opaque alpha plane
+ * @param node, NCHW f32 R,G,B planes
+ * @param swapRB, reorder planes to B,G,R
+ */
+static ov::Output<ov::Node> MapToPixels(const ov::Output<ov::Node>& node, bool swapRB)
+{
+	// (x+1)/2*255
+	auto half_range = Constant::create(ov::element::f32, ov::Shape{}, { 127.5f });
+	auto pixels = make_shared<Add>(make_shared<Multiply>(node, half_range), half_range);
+	auto rounded = make_shared<Round>(pixels, Round::RoundMode::HALF_TO_EVEN);
+	shared_ptr<ov::Node> mapped = make_shared<Clamp>(rounded, 0.0, 255.0);
+
+	if (swapRB)
+	{
+		auto order = Constant::create(ov::element::i64, ov::Shape{ 3 }, { 2, 1, 0 });
+		auto channel_axis = Constant::create(ov::element::i64, ov::Shape{}, { 1 });
+		mapped = make_shared<Gather>(mapped, order, channel_axis);
+	}
+
+	auto pads_begin = Constant::create(ov::element::i64, ov::Shape{ 4 }, { 0, 0, 0, 0 });
+	auto pads_end = Constant::create(ov::element::i64, ov::Shape{ 4 }, { 0, 1, 0, 0 });
+	auto alpha = Constant::create(ov::element::f32, ov::Shape{}, { 255.0f });
+	return make_shared<Pad>(mapped, pads_begin, pads_end, alpha, ov::op::PadMode::CONSTANT);
+}
+
+std::shared_ptr<ov::Model> BuildStyleModel(
+	ov::Core& core,
+	const std::string& modelXmlFilePath,
+	const ModelIO& io)
+{
+	if (io.width <= 0 || io.height <= 0)
+		throw invalid_argument("Invalid model resolution");
+	if (io.batch <= 0)
+		throw invalid_argument("Invalid batch size");
+
+	//1) Reading network and reshape it to model resolution
+	auto model = core.read_model(modelXmlFilePath);
+	model->reshape(ov::PartialShape{ io.batch, 3, io.height, io.width });
+
+	ov::preprocess::PrePostProcessor ppp(model);
+
+	// 2)Setting input info and explicit preprocessing steps
+	ov::preprocess::InputTensorInfo& input_tensor = ppp.input().tensor();
+	switch (io.input)
+	{
+	case ModelInput::PLANAR_U8:
+		input_tensor.set_layout("NCHW")
+			.set_element_type(ov::element::u8)
+			.set_color_format(ov::preprocess::ColorFormat::BGR);
+		ppp.input().preprocess()
+			.convert_element_type(ov::element::f16)
+			.mean(127.5)
+			.scale(127.5);
+		break;
+	case ModelInput::PLANAR_F32:
+		input_tensor.set_layout("NCHW")
+			.set_element_type(ov::element::f32);
+		break;
+	case ModelInput::BGRX_U8:
+		input_tensor.set_layout("NHWC")
+			.set_element_type(ov::element::u8)
+			.set_color_format(ov::preprocess::ColorFormat::BGRX);
+		ppp.input().preprocess()
+			.convert_color(ov::preprocess::ColorFormat::BGR);
+		if (io.resize)
+		{
+			// frames keep their capture size, the graph resizes them to model resolution
+			input_tensor.set_spatial_dynamic_shape();
+			ppp.input().preprocess()
+				.resize(ov::preprocess::ResizeAlgorithm::RESIZE_LINEAR);
+		}
+		ppp.input().preprocess()
+			.convert_element_type(ov::element::f32)
+			.mean(127.5)
+			.scale(127.5);
+		break;
+	}
+	if (io.gpu_buffers)
+		input_tensor.set_memory_type(ov::intel_gpu::memory_type::buffer);
+	ppp.input().model().set_layout("NCHW");
+
+	// 3)Setting output info and explicit postprocessing steps
+	ppp.output().model().set_layout("NCHW");
+	switch (io.output)
+	{
+	case ModelOutput::PLANAR_F32:
+		ppp.output().tensor().set_element_type(ov::element::f32);
+		break;
+	case ModelOutput::RGBA_U8:
+	case ModelOutput::BGRA_U8:
+	{
+		bool swapRB = io.output == ModelOutput::BGRA_U8;
+		ppp.output().postprocess()
+			.convert_element_type(ov::element::f32)
+			.custom([swapRB](const ov::Output<ov::Node>& node) { return MapToPixels(node, swapRB); });
+		ppp.output().tensor()
+			.set_layout("NHWC")
+			.set_element_type(ov::element::u8);
+		break;
+	}
+	}
+
+	return ppp.build();
+}
+
+/*
+ * @brief Largest spatial size of a kernel given by the weights shape, the last two dimensions
+ */
+static double KernelSize(const ov::Output<ov::Node>& weights)
+{
+	const ov::PartialShape& shape = weights.get_partial_shape();
+	size_t rank = shape.rank().get_length();
+	return static_cast<double>(std::max(shape[rank - 2].get_length(), shape[rank - 1].get_length()));
+}
+
+ReceptiveField EstimateReceptiveField(
+	ov::Core& core,
+	const std::string& modelXmlFilePath)
+{
+	auto model = core.read_model(modelXmlFilePath);
+
+	// per activation: reach in input pixels, and distance in input pixels between neighbouring values
+	struct Extent
+	{
+		double radius;
+		double jump;
+	};
+	map<const ov::Node*, Extent> extents;
+	double radius = 0.0;
+	double max_jump = 1.0;
+
+	for (const shared_ptr<ov::Node>& node : model->get_ordered_ops())
+	{
+		// weights and other constant subgraphs never reach an extent
+		Extent extent{ 0.0, 1.0 };
+		bool on_data_path = ov::is_type<Parameter>(node);
+		for (const ov::Output<ov::Node>& input : node->input_values())
+		{
+			auto it = extents.find(input.get_node());
+			if (it == extents.end())
+				continue;
+			extent.radius = on_data_path ? max(extent.radius, it->second.radius) : it->second.radius;
+			extent.jump = on_data_path ? max(extent.jump, it->second.jump) : it->second.jump;
+			on_data_path = true;
+		}
+		if (!on_data_path)
+			continue;
+
+		if (auto conv = ov::as_type_ptr<Convolution>(node))
+		{
+			extent.radius += (KernelSize(node->input_value(1)) - 1) * conv->get_dilations()[0] / 2 * extent.jump;
+			extent.jump *= conv->get_strides()[0];
+		}
+		else if (auto group_conv = ov::as_type_ptr<GroupConvolution>(node))
+		{
+			extent.radius += (KernelSize(node->input_value(1)) - 1) * group_conv->get_dilations()[0] / 2 * extent.jump;
+			extent.jump *= group_conv->get_strides()[0];
+		}
+		else if (auto deconv = ov::as_type_ptr<ConvolutionBackpropData>(node))
+		{
+			extent.jump /= deconv->get_strides()[0];
+			extent.radius += (KernelSize(node->input_value(1)) - 1) * deconv->get_dilations()[0] / 2 * extent.jump;
+		}
+		else if (auto max_pool = ov::as_type_ptr<ov::op::v1::MaxPool>(node))
+		{
+			extent.radius += (max_pool->get_kernel()[0] - 1) / 2.0 * extent.jump;
+			extent.jump *= max_pool->get_strides()[0];
+		}
+		else if (auto avg_pool = ov::as_type_ptr<AvgPool>(node))
+		{
+			extent.radius += (avg_pool->get_kernel()[0] - 1) / 2.0 * extent.jump;
+			extent.jump *= avg_pool->get_strides()[0];
+		}
+		else if (auto depth_to_space = ov::as_type_ptr<DepthToSpace>(node))
+		{
+			extent.jump /= depth_to_space->get_block_size();
+		}
+		else if (auto space_to_depth = ov::as_type_ptr<SpaceToDepth>(node))
+		{
+			extent.jump *= space_to_depth->get_block_size();
+		}
+
+		max_jump = max(max_jump, extent.jump);
+		if (ov::is_type<Result>(node))
+			radius = max(radius, extent.radius);
+		extents[node.get()] = extent;
+	}
+
+	ReceptiveField field;
+	field.radius = static_cast<int>(ceil(radius));
+	field.downsampling = max(1, static_cast<int>(lround(max_jump)));
+	return field;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "openvino/openvino.hpp"
+
+/**
+ * @brief Input tensor the host feeds into a compiled style transfer model
+ */
+enum class ModelInput
+{
+	PLANAR_U8,  // NCHW u8 B,G,R planes at model resolution (OpenCL path)
+	PLANAR_F32, // NCHW f32 B,G,R planes in range (-1,1) at model resolution (fused CPU kernels)
+	BGRX_U8,    // NHWC u8 BGRA frames, resized to model resolution inside the graph unless ModelIO::resize is off
+};
+
+/**
+ * @brief Output tensor the host reads back from a compiled style transfer model
+ */
+enum class ModelOutput
+{
+	PLANAR_F32, // raw NCHW f32 R,G,B planes in range (-1,1)
+	RGBA_U8,    // NHWC u8 RGBA pixels, same layout as DXGI_FORMAT_R8G8B8A8 textures
+	BGRA_U8,    // NHWC u8 BGRA pixels, same layout as PF_B8G8R8A8 textures and FColor
+};
+
+/**
+ * @struct ModelIO
+ * @brief Host side tensors of a compiled model; everything between them and the NCHW float
+ * network is baked into the graph
+ */
+struct ModelIO
+{
+	ModelInput input = ModelInput::PLANAR_F32;
+	ModelOutput output = ModelOutput::PLANAR_F32;
+	// model resolution
+	int width = 0;
+	int height = 0;
+	// frames per inference, views of one frame stacked along N
+	int batch = 1;
+	// input is bound to OpenCL buffers of a remote context
+	bool gpu_buffers = false;
+	// BGRX_U8 frames of any size are resized in the graph, off for frames already at model resolution (tiles)
+	bool resize = true;
+};
+
+/**
+ * @struct ReceptiveField
+ * @brief Spatial extent of the network, used to size the halo around tiles
+ */
+struct ReceptiveField
+{
+	// input pixels on each side of an output pixel that contribute to it
+	int radius = 0;
+	// largest downsampling inside the network, input sizes have to be multiples of it
+	int downsampling = 1;
+};
+
+/**
+ * @brief Revision of the graphs BuildStyleModel builds around an IR, part of the key of cached compiled
+ * models; increment it whenever a change to BuildStyleModel changes the compiled graph
+ */
+const int kStyleModelRevision = 1;
+
+/**
+ * @brief Read a style transfer IR, reshape it to the model resolution and batch and add the conversion
+ * between host tensors and network (layout, channel order, mean/scale, resize, 8 bit mapping)
+ * to the graph with a PrePostProcessor, so the plugin runs it with its own optimized kernels
+ * @param core, OpenVINO core used to read the model
+ * @param modelXmlFilePath, path to the IR xml, bin file is expected next to it
+ * @param io, host side tensors
+ */
+std::shared_ptr<ov::Model> BuildStyleModel(
+	ov::Core& core,
+	const std::string& modelXmlFilePath,
+	const ModelIO& io);
+
+/**
+ * @brief Walk the convolutions, poolings and depth/space shuffles of a style transfer IR and
+ * accumulate the receptive field of its output
+ * @param core, OpenVINO core used to read the model
+ * @param modelXmlFilePath, path to the IR xml
+ */
+ReceptiveField EstimateReceptiveField(
+	ov::Core& core,
+	const std::string& modelXmlFilePath);
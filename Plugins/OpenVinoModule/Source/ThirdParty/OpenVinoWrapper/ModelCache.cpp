@@ -0,0 +1,285 @@
+#include "ModelCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// blob layout: magic, format, key size, key, payload size, payload hash, payload
+static const char kMagic[8] = { 'O', 'V', 'S', 'T', 'B', 'L', 'O', 'B' };
+static const uint32_t kFormat = 1;
+static const char* kExtension = ".ovst";
+
+/*
+ * @brief 64 bit FNV-1a over 8 byte words with a shift so high bits reach the low ones, fast enough to
+ * check blobs of tens of MB on every import
+ */
+static uint64_t HashBytes(const char* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	const uint64_t prime = 1099511628211ull;
+	size_t words = size / 8;
+	for (size_t i = 0; i < words; i++)
+	{
+		uint64_t word;
+		memcpy(&word, data + i * 8, 8);
+		hash = (hash ^ word) * prime;
+		hash ^= hash >> 29;
+	}
+	for (size_t i = words * 8; i < size; i++)
+	{
+		hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+	}
+	return hash;
+}
+
+static string Hex(uint64_t value)
+{
+	char text[17];
+	snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+	return text;
+}
+
+/*
+ * @brief Read only stream over a blob in memory, so the payload is imported without another copy
+ */
+struct MemoryBuffer : std::streambuf
+{
+	MemoryBuffer(char* data, size_t size)
+	{
+		setg(data, data, data + size);
+	}
+};
+
+/*
+ * @brief Check magic, format, key and payload of a blob
+ * @return nullptr if the blob is valid, otherwise why it is not
+ */
+static const char* ValidateBlob(const string& blob, const string& key, size_t* payloadOffset)
+{
+	size_t offset = 0;
+	auto read = [&blob, &offset](void* value, size_t size)
+	{
+		if (blob.size() - offset < size)
+			return false;
+		memcpy(value, blob.data() + offset, size);
+		offset += size;
+		return true;
+	};
+
+	char magic[sizeof(kMagic)];
+	uint32_t format = 0;
+	uint32_t key_size = 0;
+	if (!read(magic, sizeof(magic)) || memcmp(magic, kMagic, sizeof(kMagic)) != 0)
+		return "not a model cache blob";
+	if (!read(&format, sizeof(format)) || format != kFormat)
+		return "written by another version of the cache";
+	if (!read(&key_size, sizeof(key_size)) || key_size != key.size() ||
+		blob.size() - offset < key_size || blob.compare(offset, key_size, key) != 0)
+		return "compiled for another model or configuration";
+	offset += key_size;
+
+	uint64_t payload_size = 0;
+	uint64_t payload_hash = 0;
+	if (!read(&payload_size, sizeof(payload_size)) || !read(&payload_hash, sizeof(payload_hash)) ||
+		blob.size() - offset != payload_size)
+		return "truncated";
+	if (HashBytes(blob.data() + offset, blob.size() - offset) != payload_hash)
+		return "corrupted";
+
+	*payloadOffset = offset;
+	return nullptr;
+}
+
+ModelCache::ModelCache(std::string folder)
+	: folder(folder), size_limit(1024ull * 1024 * 1024)
+{
+}
+
+void ModelCache::SetSizeLimit(uint64_t bytes)
+{
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	size_limit = bytes;
+}
+
+uint64_t ModelCache::GetSizeLimit() const
+{
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	return size_limit;
+}
+
+ov::CompiledModel ModelCache::Load(
+	const std::string& key,
+	const std::function<ov::CompiledModel()>& compile,
+	const std::function<ov::CompiledModel(std::istream&)>& import,
+	CacheResult* result)
+{
+	*result = CacheResult::UNKNOWN;
+	if (GetSizeLimit() == 0)
+		return compile();
+
+	// blobs of one OpenVINO version can't be imported by another
+	string full_key = "openvino " + string(ov::get_openvino_version().buildNumber) + "\n" + key;
+	string name = Hex(HashBytes(full_key.data(), full_key.size())) + kExtension;
+	fs::path path = fs::path(folder) / name;
+
+	string blob;
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		ifstream file(path, ios::binary | ios::ate);
+		if (file)
+		{
+			blob.resize(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(&blob[0], blob.size());
+			if (!file)
+				blob.clear();
+		}
+	}
+
+	if (!blob.empty())
+	{
+		size_t payload_offset = 0;
+		string reason;
+		const char* invalid = ValidateBlob(blob, full_key, &payload_offset);
+		if (invalid == nullptr)
+		{
+			try
+			{
+				MemoryBuffer buffer(&blob[payload_offset], blob.size() - payload_offset);
+				istream stream(&buffer);
+				ov::CompiledModel model = import(stream);
+
+				// the modification time orders blobs for eviction, a hit makes a blob the most recently used
+				std::lock_guard<std::mutex> lock(cache_mutex);
+				error_code ignored;
+				fs::last_write_time(path, fs::file_time_type::clock::now(), ignored);
+				*result = CacheResult::HIT;
+				return model;
+			}
+			catch (std::exception& ex)
+			{
+				reason = ex.what();
+			}
+		}
+		else
+		{
+			reason = invalid;
+		}
+
+		clog << "Cached model " << name << " is compiled again, " << reason << endl;
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		error_code ignored;
+		fs::remove(path, ignored);
+	}
+
+	ov::CompiledModel model = compile();
+	*result = CacheResult::MISS;
+
+	try
+	{
+		ostringstream payload_stream(ios::binary);
+		model.export_model(payload_stream);
+		string payload = payload_stream.str();
+		uint32_t key_size = static_cast<uint32_t>(full_key.size());
+		uint64_t payload_size = payload.size();
+		uint64_t payload_hash = HashBytes(payload.data(), payload.size());
+
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		// a blob is only visible once it is complete
+		fs::path temporary = path;
+		temporary += ".tmp";
+		{
+			ofstream file(temporary, ios::binary | ios::trunc);
+			file.write(kMagic, sizeof(kMagic));
+			file.write(reinterpret_cast<const char*>(&kFormat), sizeof(kFormat));
+			file.write(reinterpret_cast<const char*>(&key_size), sizeof(key_size));
+			file.write(full_key.data(), full_key.size());
+			file.write(reinterpret_cast<const char*>(&payload_size), sizeof(payload_size));
+			file.write(reinterpret_cast<const char*>(&payload_hash), sizeof(payload_hash));
+			file.write(payload.data(), payload.size());
+			if (!file)
+				throw std::runtime_error("Can't write " + temporary.string());
+		}
+		fs::rename(temporary, path);
+		Evict(name);
+	}
+	catch (std::exception& ex)
+	{
+		// the model runs, it is compiled again next time
+		clog << "Compiled model is not cached: " << ex.what() << endl;
+	}
+	return model;
+}
+
+std::string ModelCache::ModelFilesKey(const std::string& modelXmlFilePath)
+{
+	fs::path bin_path = fs::path(modelXmlFilePath).replace_extension(".bin");
+	return "model " + Hex(HashFile(modelXmlFilePath)) + " " + Hex(HashFile(bin_path.string()));
+}
+
+uint64_t ModelCache::HashFile(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	uintmax_t size = fs::file_size(path);
+	long long modified = static_cast<long long>(fs::last_write_time(path).time_since_epoch().count());
+	auto known = file_hashes.find(path);
+	if (known != file_hashes.end() && known->second.size == size && known->second.modified == modified)
+		return known->second.hash;
+
+	ifstream file(path, ios::binary);
+	if (!file)
+		throw std::runtime_error("Can't read " + path);
+	uint64_t hash = 14695981039346656037ull;
+	// chunks are multiples of 8 bytes, so the hash is the same as over the whole file at once
+	vector<char> chunk(1 << 20);
+	while (file)
+	{
+		file.read(chunk.data(), chunk.size());
+		hash = HashBytes(chunk.data(), static_cast<size_t>(file.gcount()), hash);
+	}
+	file_hashes[path] = FileHash{ size, modified, hash };
+	return hash;
+}
+
+void ModelCache::Evict(const std::string& keep)
+{
+	struct Blob
+	{
+		fs::path path;
+		uintmax_t size;
+		fs::file_time_type used;
+	};
+	vector<Blob> blobs;
+	uintmax_t total = 0;
+	error_code error;
+	for (const fs::directory_entry& entry : fs::directory_iterator(folder, error))
+	{
+		if (entry.path().extension() != kExtension)
+			continue;
+		Blob blob = { entry.path(), entry.file_size(error), entry.last_write_time(error) };
+		total += blob.size;
+		blobs.push_back(blob);
+	}
+
+	sort(blobs.begin(), blobs.end(), [](const Blob& a, const Blob& b) { return a.used < b.used; });
+	for (const Blob& blob : blobs)
+	{
+		if (total <= size_limit)
+			break;
+		if (blob.path.filename() == keep)
+			continue;
+		if (fs::remove(blob.path, error))
+		{
+			total -= blob.size;
+			clog << "Evicted cached model " << blob.path.filename().string() << endl;
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <string>
+#include "openvino/openvino.hpp"
+#include "PipelineStats.h"
+
+/**
+ * @class ModelCache
+ * @brief Folder of exported compiled models. A blob is keyed by everything its compilation depends on:
+ * the content of the model files, the graph built around them, input shape, device, properties and the
+ * OpenVINO version. Blobs are validated before they are imported, the least recently used ones are
+ * evicted when the folder grows over its size limit.
+ */
+class ModelCache
+{
+public:
+	/**
+	 * @param folder, existing folder the blobs are kept in
+	 */
+	explicit ModelCache(std::string folder);
+
+	/**
+	 * @brief Size of all blobs together before the least recently used ones are deleted, 0 disables the cache
+	 */
+	void SetSizeLimit(uint64_t bytes);
+	uint64_t GetSizeLimit() const;
+
+	/**
+	 * @brief Import the compiled model of "key", or compile and export it
+	 * @param key, description of everything the compilation depends on, see "ModelFilesKey"
+	 * @param compile, compiles the model on a miss
+	 * @param import, imports an exported model for the device it was compiled for
+	 * @param result, HIT if the model was imported, MISS if it was compiled
+	 */
+	ov::CompiledModel Load(
+		const std::string& key,
+		const std::function<ov::CompiledModel()>& compile,
+		const std::function<ov::CompiledModel(std::istream&)>& import,
+		CacheResult* result);
+
+	/**
+	 * @brief Part of a key identifying the IR by the content of its xml and bin files
+	 * @param modelXmlFilePath, path to the IR xml, bin file is expected next to it
+	 */
+	std::string ModelFilesKey(const std::string& modelXmlFilePath);
+
+private:
+	// Hash of a file, remembered while its size and modification time stay the same
+	uint64_t HashFile(const std::string& path);
+	// Delete the least recently used blobs until the folder fits the size limit, "keep" is never deleted
+	void Evict(const std::string& keep);
+
+	std::string folder;
+	uint64_t size_limit;
+	struct FileHash
+	{
+		uintmax_t size;
+		long long modified;
+		uint64_t hash;
+	};
+	std::map<std::string, FileHash> file_hashes;
+	// Guards the files of the folder and file_hashes, compilation runs outside of it
+	mutable std::mutex cache_mutex;
+};
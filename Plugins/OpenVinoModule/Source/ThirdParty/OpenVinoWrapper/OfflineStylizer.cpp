@@ -0,0 +1,475 @@
+// OfflineStylizer.cpp : Applies a style transfer model to a video file or a directory of images,
+// e.g. captured gameplay, at full machine throughput.
+//
+// usage: ovst_batch model.xml input output [device] [width height] [requests]
+//
+// input is a video file or a directory of images, output is a video file (.mp4, .avi, .mkv, .mov) or a
+// directory. Decode, preprocess, inference, postprocess and encode run as pipelined stages connected by
+// bounded queues, inference keeps several asynchronous requests in flight. Only OpenVINO and the OpenCV
+// core, imgproc, imgcodecs and videoio modules are needed, no window system or graphics device.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <initializer_list>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include "openvino/openvino.hpp"
+
+#include "ModelBuilder.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/**
+ * @struct Frame
+ * @brief One frame on its way through the pipeline, every stage fills the next image
+ */
+struct Frame
+{
+	long long index = 0;
+	// file name within an image directory
+	string name;
+	// BGR frame as decoded
+	cv::Mat decoded;
+	// BGRA frame, input tensor of the model: at decoded size if the graph resizes, else at model resolution
+	cv::Mat input;
+	// BGRA frame at model resolution, output tensor of the model
+	cv::Mat output;
+	// BGR frame at decoded size, handed to the encoder
+	cv::Mat encoded;
+};
+
+/**
+ * @class BoundedQueue
+ * @brief Queue between two stages; Push blocks while the queue is full, so a fast stage can not run
+ * ahead of a slow one and buffer the whole capture
+ */
+template <typename T>
+class BoundedQueue
+{
+	deque<T> items;
+	size_t capacity;
+	bool closed = false;
+	mutex lock;
+	condition_variable not_empty;
+	condition_variable not_full;
+
+public:
+	explicit BoundedQueue(size_t capacity) : capacity(max<size_t>(1, capacity)) {}
+
+	/*
+	 * @brief Append an item, false if the queue was closed because a later stage stopped
+	 */
+	bool Push(T item)
+	{
+		unique_lock<mutex> guard(lock);
+		not_full.wait(guard, [this] { return items.size() < capacity || closed; });
+		if (closed)
+			return false;
+		items.push_back(move(item));
+		not_empty.notify_one();
+		return true;
+	}
+
+	/*
+	 * @brief Take the oldest item, false once the queue is closed and drained
+	 */
+	bool Pop(T& item)
+	{
+		unique_lock<mutex> guard(lock);
+		not_empty.wait(guard, [this] { return !items.empty() || closed; });
+		if (items.empty())
+			return false;
+		item = move(items.front());
+		items.pop_front();
+		not_full.notify_one();
+		return true;
+	}
+
+	/*
+	 * @brief No more items follow; consumers drain the queue, producers stop
+	 */
+	void Close()
+	{
+		lock_guard<mutex> guard(lock);
+		closed = true;
+		not_empty.notify_all();
+		not_full.notify_all();
+	}
+};
+
+typedef BoundedQueue<Frame> FrameQueue;
+
+/**
+ * @struct StageStats
+ * @brief Frames a stage handled and the time it spent on them, waiting on queues excluded
+ */
+struct StageStats
+{
+	const char* name;
+	long long frames = 0;
+	double busy_ms = 0.0;
+};
+
+/*
+ * @brief Milliseconds since "begin"
+ */
+static double ElapsedMs(chrono::steady_clock::time_point begin)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+}
+
+static bool HasExtension(const fs::path& path, initializer_list<const char*> extensions)
+{
+	string extension = path.extension().string();
+	transform(extension.begin(), extension.end(), extension.begin(),
+		[](unsigned char c) { return static_cast<char>(tolower(c)); });
+	for (const char* candidate : extensions)
+	{
+		if (extension == candidate)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * @class FrameSource
+ * @brief Frames of a video file, or the images of a directory in file name order
+ */
+class FrameSource
+{
+	cv::VideoCapture video;
+	vector<fs::path> images;
+	size_t next_image = 0;
+	bool is_video = false;
+
+public:
+	double fps = 30.0;
+
+	void Open(const string& path)
+	{
+		if (fs::is_directory(path))
+		{
+			for (const fs::directory_entry& entry : fs::directory_iterator(path))
+			{
+				if (entry.is_regular_file() && HasExtension(entry.path(), { ".png", ".jpg", ".jpeg", ".bmp", ".tif", ".tiff" }))
+					images.push_back(entry.path());
+			}
+			sort(images.begin(), images.end());
+			if (images.empty())
+				throw runtime_error("No images in " + path);
+			return;
+		}
+
+		is_video = true;
+		if (!video.open(path))
+			throw runtime_error("Can not open video " + path);
+		double video_fps = video.get(cv::CAP_PROP_FPS);
+		if (video_fps > 0.0)
+			fps = video_fps;
+	}
+
+	/*
+	 * @brief Decode the next frame, false at the end of the input
+	 */
+	bool Read(Frame& frame)
+	{
+		if (is_video)
+			return video.read(frame.decoded) && !frame.decoded.empty();
+
+		if (next_image == images.size())
+			return false;
+		const fs::path& path = images[next_image++];
+		frame.decoded = cv::imread(path.string(), cv::IMREAD_COLOR);
+		if (frame.decoded.empty())
+			throw runtime_error("Can not read image " + path.string());
+		frame.name = path.filename().string();
+		return true;
+	}
+};
+
+/**
+ * @class FrameSink
+ * @brief Writes frames into a video file, or as images into a directory
+ */
+class FrameSink
+{
+	cv::VideoWriter video;
+	fs::path path;
+	double fps;
+	bool is_video;
+
+public:
+	FrameSink(const string& outputPath, double sourceFps)
+		: path(outputPath), fps(sourceFps)
+	{
+		is_video = HasExtension(path, { ".mp4", ".avi", ".mkv", ".mov" });
+		if (!is_video)
+			fs::create_directories(path);
+	}
+
+	void Write(const Frame& frame)
+	{
+		if (!is_video)
+		{
+			string name = frame.name;
+			if (name.empty())
+			{
+				char numbered[32];
+				snprintf(numbered, sizeof(numbered), "frame_%06lld.png", frame.index);
+				name = numbered;
+			}
+			if (!cv::imwrite((path / name).string(), frame.encoded))
+				throw runtime_error("Can not write image " + (path / name).string());
+			return;
+		}
+
+		// the writer takes its size from the first frame
+		if (!video.isOpened())
+		{
+			int fourcc = HasExtension(path, { ".avi" }) ? cv::VideoWriter::fourcc('M', 'J', 'P', 'G') : cv::VideoWriter::fourcc('m', 'p', '4', 'v');
+			if (!video.open(path.string(), fourcc, fps, frame.encoded.size()))
+				throw runtime_error("Can not open video " + path.string() + " for writing");
+		}
+		video.write(frame.encoded);
+	}
+};
+
+/*
+ * @brief Keep "count" asynchronous requests in flight, frames leave in the order they arrived
+ */
+static void RunInference(ov::CompiledModel& compiled, size_t count, int width, int height,
+	FrameQueue& in, FrameQueue& out, StageStats& stats)
+{
+	// frame i runs on request i % count, which is free once frame i - count completed
+	deque<Frame> in_flight;
+	// declared after the frames, so on an early return the requests stop before the buffers they use go away
+	vector<ov::InferRequest> requests;
+	for (size_t i = 0; i < count; i++)
+		requests.push_back(compiled.create_infer_request());
+
+	auto complete_oldest = [&]() {
+		chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+		Frame done = move(in_flight.front());
+		in_flight.pop_front();
+		requests[done.index % count].wait();
+		done.input.release();
+		stats.busy_ms += ElapsedMs(begin);
+		stats.frames++;
+		return out.Push(move(done));
+	};
+
+	Frame frame;
+	while (in.Pop(frame))
+	{
+		if (in_flight.size() == count && !complete_oldest())
+			return;
+
+		chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+		ov::InferRequest& request = requests[frame.index % count];
+		frame.output.create(height, width, CV_8UC4);
+		request.set_input_tensor(ov::Tensor(ov::element::u8,
+			ov::Shape{ 1, static_cast<size_t>(frame.input.rows), static_cast<size_t>(frame.input.cols), 4 }, frame.input.data));
+		request.set_output_tensor(ov::Tensor(ov::element::u8,
+			ov::Shape{ 1, static_cast<size_t>(height), static_cast<size_t>(width), 4 }, frame.output.data));
+		request.start_async();
+		in_flight.push_back(move(frame));
+		stats.busy_ms += ElapsedMs(begin);
+	}
+	while (!in_flight.empty())
+	{
+		if (!complete_oldest())
+			return;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 4)
+	{
+		printf("usage: %s model.xml input output [device] [width height] [requests]\n", argv[0]);
+		printf("  input, video file or directory of images\n");
+		printf("  output, video file (.mp4, .avi, .mkv, .mov) or directory\n");
+		return 1;
+	}
+	string model_path = argv[1];
+	string input_path = argv[2];
+	string output_path = argv[3];
+	string device = argc > 4 ? argv[4] : "CPU";
+	int width = argc > 6 ? atoi(argv[5]) : 0;
+	int height = argc > 6 ? atoi(argv[6]) : 0;
+	size_t request_count = argc > 7 ? static_cast<size_t>(max(1, atoi(argv[7]))) : 0;
+
+	StageStats stats[] = { { "decode" }, { "preprocess" }, { "inference" }, { "postprocess" }, { "encode" } };
+	string error;
+	mutex error_mutex;
+	chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+
+	try
+	{
+		FrameSource source;
+		source.Open(input_path);
+		Frame first;
+		if (!source.Read(first))
+			throw runtime_error("No frames in " + input_path);
+
+		ov::Core core;
+		// without a resolution the model runs at the size of the input, fitted to the network's downsampling
+		if (width <= 0 || height <= 0)
+		{
+			int downsampling = max(1, EstimateReceptiveField(core, model_path).downsampling);
+			width = max(downsampling, first.decoded.cols - first.decoded.cols % downsampling);
+			height = max(downsampling, first.decoded.rows - first.decoded.rows % downsampling);
+		}
+
+		// only the CPU plugin compiles the dynamic input that resizes frames of any size in the graph,
+		// other devices get frames resized to model resolution on the host
+		ModelIO io;
+		io.input = ModelInput::BGRX_U8;
+		io.output = ModelOutput::BGRA_U8;
+		io.width = width;
+		io.height = height;
+		io.resize = device.rfind("CPU", 0) == 0;
+		bool resize_in_graph = io.resize;
+		ov::AnyMap properties = { ov::hint::performance_mode(ov::hint::PerformanceMode::THROUGHPUT) };
+		if (request_count > 0)
+			properties.emplace(ov::hint::num_requests(static_cast<uint32_t>(request_count)));
+		ov::CompiledModel compiled = core.compile_model(BuildStyleModel(core, model_path, io), device, properties);
+		if (request_count == 0)
+			request_count = max<uint32_t>(1, compiled.get_property(ov::optimal_number_of_infer_requests));
+
+		printf("%s on %s, model %dx%d, %zu requests\n", model_path.c_str(), device.c_str(), width, height, request_count);
+		fflush(stdout);
+
+		// enough room for every request to have a frame in flight and the next one waiting
+		size_t queue_depth = 2 * request_count;
+		FrameQueue decoded(queue_depth), preprocessed(queue_depth), inferred(queue_depth), postprocessed(queue_depth);
+		FrameSink sink(output_path, source.fps);
+
+		// a stage closes both its queues when it ends: later stages drain and end, and after a failure
+		// earlier ones stop on their next push
+		auto run_stage = [&](FrameQueue* in, FrameQueue* out, auto body) {
+			return thread([&, in, out, body]() {
+				try
+				{
+					body();
+				}
+				catch (std::exception& ex)
+				{
+					lock_guard<mutex> guard(error_mutex);
+					if (error.empty())
+						error = ex.what();
+				}
+				if (in)
+					in->Close();
+				if (out)
+					out->Close();
+			});
+		};
+
+		begin = chrono::steady_clock::now();
+		vector<thread> stages;
+		stages.push_back(run_stage(nullptr, &decoded, [&]() {
+			Frame frame = move(first);
+			do
+			{
+				frame.index = stats[0].frames++;
+				if (!decoded.Push(move(frame)))
+					return;
+				frame = Frame();
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				bool more = source.Read(frame);
+				stats[0].busy_ms += ElapsedMs(start);
+				if (!more)
+					return;
+			} while (true);
+		}));
+		stages.push_back(run_stage(&decoded, &preprocessed, [&]() {
+			Frame frame;
+			while (decoded.Pop(frame))
+			{
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				cv::cvtColor(frame.decoded, frame.input, cv::COLOR_BGR2BGRA);
+				if (!resize_in_graph && (frame.input.cols != width || frame.input.rows != height))
+					cv::resize(frame.input, frame.input, cv::Size(width, height), 0, 0, cv::INTER_LINEAR);
+				stats[1].busy_ms += ElapsedMs(start);
+				stats[1].frames++;
+				if (!preprocessed.Push(move(frame)))
+					return;
+			}
+		}));
+		stages.push_back(run_stage(&preprocessed, &inferred, [&]() {
+			RunInference(compiled, request_count, width, height, preprocessed, inferred, stats[2]);
+		}));
+		stages.push_back(run_stage(&inferred, &postprocessed, [&]() {
+			Frame frame;
+			while (inferred.Pop(frame))
+			{
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				cv::cvtColor(frame.output, frame.encoded, cv::COLOR_BGRA2BGR);
+				// frames go out at the size they came in
+				if (frame.encoded.size() != frame.decoded.size())
+					cv::resize(frame.encoded, frame.encoded, frame.decoded.size(), 0, 0, cv::INTER_LINEAR);
+				frame.decoded.release();
+				frame.output.release();
+				stats[3].busy_ms += ElapsedMs(start);
+				stats[3].frames++;
+				if (!postprocessed.Push(move(frame)))
+					return;
+			}
+		}));
+		stages.push_back(run_stage(&postprocessed, nullptr, [&]() {
+			Frame frame;
+			while (postprocessed.Pop(frame))
+			{
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				sink.Write(frame);
+				stats[4].busy_ms += ElapsedMs(start);
+				stats[4].frames++;
+				if (stats[4].frames % 500 == 0)
+				{
+					printf("%lld frames\n", stats[4].frames);
+					fflush(stdout);
+				}
+			}
+		}));
+		for (thread& stage : stages)
+			stage.join();
+	}
+	catch (std::exception& ex)
+	{
+		error = ex.what();
+	}
+
+	if (!error.empty())
+	{
+		printf("failed: %s\n", error.c_str());
+		return 1;
+	}
+
+	// the slowest stage bounds the pipeline, the others overlap with it
+	double total_ms = ElapsedMs(begin);
+	for (const StageStats& stage : stats)
+	{
+		printf("%-12s %8lld frames  %8.2f fps  busy %5.1f%%\n", stage.name, stage.frames,
+			stage.busy_ms > 0.0 ? stage.frames * 1000.0 / stage.busy_ms : 0.0, 100.0 * stage.busy_ms / total_ms);
+	}
+	printf("%-12s %8lld frames  %8.2f fps  %.1f s\n", "pipeline", stats[4].frames,
+		stats[4].frames * 1000.0 / total_ms, total_ms / 1000.0);
+	return 0;
+}
@@ -457,6 +457,36 @@
         return true;
     }
 
+    bool SourceConversion::CopyRGBAbufferToSurface(cl_mem in_rgbaBuffer, ID3D11Texture2D* out_rgbaSurf, int cols, int rows) {
+        cl_mem out_hdlRGBA = m_env->CreateSharedSurface(out_rgbaSurf, 0, false);
+        if (!out_hdlRGBA) {
+            return false;
+        }
+
+        cl_command_queue cmdQueue = m_env->GetCommandQueue();
+        if (!cmdQueue) {
+            return false;
+        }
+
+        if (!m_env->EnqueueAcquireSurfaces(&out_hdlRGBA, 1, false)) {
+            return false;
+        }
+
+        // the model already wrote 8 bit RGBA pixels, a plain copy fills the texture
+        size_t origin[3] = { 0, 0, 0 };
+        size_t region[3] = { static_cast<size_t>(cols), static_cast<size_t>(rows), 1 };
+        cl_int error = clEnqueueCopyBufferToImage(cmdQueue, in_rgbaBuffer, out_hdlRGBA, 0, origin, region, 0, NULL, NULL);
+        if (error) {
+            std::cerr << "clEnqueueCopyBufferToImage failed. Error code: " << error << std::endl;
+        }
+
+        // flush & finish the command queue once the surface is handed back to D3D
+        if (!m_env->EnqueueReleaseSurfaces(&out_hdlRGBA, 1, true)) {
+            return false;
+        }
+        return (error == CL_SUCCESS);
+    }
+
     bool SourceConversion::Run() {
         std::vector<cl_mem> sharedSurfaces;
         std::vector<OCLKernelArg*>& args = m_RGBToRGBbuffer ? m_argsRGBtoRGBbuffer : m_argsRGBbuffertoRGBA;
@@ -172,6 +172,8 @@
 
         bool SetArgumentsRGBtoRGBbuffer(ID3D11Texture2D* in_nv12Surf, cl_mem out_rgbSurf, int cols, int rows);
         bool SetArgumentsRGBbuffertoRGBA(cl_mem in_rgbSurf, ID3D11Texture2D* out_rgbSurf, int cols, int rows);
+        // Copy interleaved RGBA8 pixels of a buffer into a shared D3D11 texture and wait for completion
+        bool CopyRGBAbufferToSurface(cl_mem in_rgbaBuffer, ID3D11Texture2D* out_rgbaSurf, int cols, int rows);
         void printClVector(cl_mem& clVector, int length, cl_command_queue& commands, int datatype, int printrowlen = -1);
 
         bool debug_flag = false;
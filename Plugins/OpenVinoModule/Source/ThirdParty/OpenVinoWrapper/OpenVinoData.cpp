@@ -30,26 +30,45 @@ embedded in Materials by Intel or Intel's suppliers or licensors in any way."
 #include <vector>
 #include <memory>
 #include <cstdlib>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <limits>
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <set>
 #include <d3d11.h>
 
 #include <opencv2/opencv.hpp>
-#include <ie/inference_engine.hpp>
 #include "openvino/openvino.hpp"
 #include "openvino/runtime/intel_gpu/properties.hpp"
 #include "openvino/runtime/intel_gpu/ocl/ocl.hpp"
 
 #include "OpenCLUtil.h"
+#include "ModelBuilder.h"
+#include "ModelCache.h"
 
 using namespace std;
-using namespace InferenceEngine;
+
+/*
+ * @brief OpenVINO runtime of all sessions, plugins are loaded once per process
+ */
+static ov::Core&
+SharedCore()
+{
+	static ov::Core core;
+	return core;
+}
 
 /*
  * @brief Initialize OpenVino with passed model files
  * @param modelXmlFilePath
  * @param modelBinFilePath
- * @param modelLabelFilePath
+ * @param inferWidth
+ * @param inferHeight
+ * @param devicename
+ * @param config, compilation and scheduling of the CPU path
  */
 void 
 OpenVinoData::Initialize(
@@ -57,252 +76,1749 @@ OpenVinoData::Initialize(
 	string modelBinFilePath,
 	int inferWidth,
 	int inferHeight,
-	string devicename)
+	string devicename,
+	const InferenceConfig& config)
+{
+	OpenLog("mode_normal_" + devicename + "_" + std::to_string(inferWidth) + "x" + std::to_string(inferHeight));
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	// --------------------------- 1. Read IR and bake pre/post processing into it --------------------------
+	ConfigureModel(modelXmlFilePath, inferWidth, inferHeight, devicename, config);
+	if (devicename.rfind("CPU", 0) == 0)
+		kernel_arena = std::make_unique<KernelArena>(core_set);
+
+	// --------------------------- 2. Loading model to the plugin ------------------------------------------
+	clog << "4. Loading model..." << endl;
+	// weights and request tensors are first touched here, on the NUMA node of the core set
+	ScopedThreadAffinity affinity(core_set);
+	compiled_model = CompileModel(config, model_io);
+	if (workers_pinned)
+	{
+		CoreSet::ReleaseTbbWorkers(pinned_core_set);
+		workers_pinned = false;
+	}
+	if (devicename.rfind("CPU", 0) == 0)
+	{
+		// TBB workers are shared by the process, a failed compile leaves them to the live sessions
+		CoreSet::PinTbbWorkers(core_set);
+		pinned_core_set = core_set;
+		workers_pinned = true;
+	}
+
+	// --------------------------- 3. Create persistent infer requests -------------------------------------
+	clog << "5. Creating request..." << endl;
+	if (tile_size > 0)
+	{
+		unsigned int request_count = compiled_model.get_property(ov::optimal_number_of_infer_requests);
+		tile_requests.clear();
+		for (unsigned int i = 0; i < std::max(1u, request_count); i++)
+		{
+			tile_requests.push_back(compiled_model.create_infer_request());
+		}
+	}
+	else
+	{
+		CreateSlotRequest(cpu_slot);
+		// one request per stream keeps every stream busy, a deeper queue only adds latency
+		int frames_in_flight = config.streams > 0 ? config.streams : 2;
+		SetFramesInFlight(config.queue_depth > 0 ? config.queue_depth : frames_in_flight);
+	}
+
+	clog << "Intialized." << endl;
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	loading_time = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count());
+	logfile_mode << "model input size:" << inferWidth << "," << inferHeight << "\n";
+	logfile_mode << "processing:" << (process_in_graph ? "graph" : "host kernels") << "\n";
+	if (tile_size > 0)
+		logfile_mode << "tiles:" << tile_size << ", halo " << tile_halo << ", " << tile_requests.size() << " requests\n";
+	else if (config.streams > 0)
+		logfile_mode << "throughput:" << compiled_model.get_property(ov::num_streams).num << " streams, "
+			<< infer_slots.size() << " frames in flight\n";
+	for (const auto& property : config.properties)
+		logfile_mode << property.first << ":" << property.second << "\n";
+	logfile_mode << "Loading model takes:" << loading_time << "ms\n";
+}
+
+/*
+ * @brief Compile the model "Initialize" would load into the compiled model cache, or find it there.
+ * No infer requests, log file or TBB pinning; the object is not usable for inference afterwards.
+ */
+void
+OpenVinoData::Precompile(
+	const string& modelXmlFilePath,
+	int inferWidth,
+	int inferHeight,
+	const string& devicename,
+	const InferenceConfig& config)
+{
+	// an empty device name is the OpenCL context of "Initialize_BaseOCL", which needs the Direct3D device
+	if (devicename.empty())
+		throw std::invalid_argument("The OpenCL path has no device name, it is cached by its first initialization");
+
+	ConfigureModel(modelXmlFilePath, inferWidth, inferHeight, devicename, config);
+	CompileModel(config, model_io);
+}
+
+/*
+ * @brief Model input and output, tiles and core set of a session, everything its compiled model depends on
+ */
+void
+OpenVinoData::ConfigureModel(
+	const string& modelXmlFilePath,
+	int inferWidth,
+	int inferHeight,
+	const string& devicename,
+	const InferenceConfig& config)
+{
+	clog << "2. Read IR..." << endl;
+
+	// frames of any capture size need a spatially dynamic input, only the CPU plugin compiles it
+	process_in_graph = config.process_in_graph && devicename.rfind("CPU", 0) == 0;
+	if (config.process_in_graph && !process_in_graph)
+	{
+		clog << "In-graph processing needs a CPU device, " << devicename << " uses the host kernels" << endl;
+	}
+
+	tile_size = 0;
+	tile_halo = 0;
+	if (config.tile_size > 0 && !process_in_graph)
+	{
+		clog << "Tiled inference needs in-graph processing, running whole frames" << endl;
+	}
+	else if (config.tile_size > 0)
+	{
+		// windows have to be multiples of the network's downsampling
+		ReceptiveField field = EstimateReceptiveField(SharedCore(), modelXmlFilePath);
+		int alignment = field.downsampling;
+		tile_halo = config.tile_halo >= 0 ? config.tile_halo : field.radius;
+		tile_halo = (tile_halo + alignment - 1) / alignment * alignment;
+		tile_size = (config.tile_size + alignment - 1) / alignment * alignment;
+		clog << "Tiles of " << tile_size << " pixels, halo " << tile_halo << " (receptive radius " << field.radius << ")" << endl;
+	}
+
+	clog << "3. Configure input/output..." << endl;
+	model_io = ModelIO();
+	model_io.input = process_in_graph ? ModelInput::BGRX_U8 : ModelInput::PLANAR_F32;
+	model_io.output = process_in_graph ? ModelOutput::BGRA_U8 : ModelOutput::PLANAR_F32;
+	model_io.width = inferWidth;
+	model_io.height = inferHeight;
+	if (tile_size > 0)
+	{
+		// the graph sees fixed size windows cut from the frame at model resolution
+		model_io.width = tile_size + 2 * tile_halo;
+		model_io.height = model_io.width;
+		model_io.resize = false;
+	}
+	model_width = inferWidth;
+	model_height = inferHeight;
+	model_xml_path = modelXmlFilePath;
+	device_name = devicename;
+	if (devicename.rfind("CPU", 0) == 0)
+		core_set = CoreSet::Parse(config.core_set);
+	{
+		std::lock_guard<std::mutex> lock(compile_mutex);
+		inference_config = config;
+	}
+}
+
+/*
+ * @brief OpenVINO properties that can be tuned at runtime
+ */
+bool
+OpenVinoData::IsTunableProperty(const std::string& name)
+{
+	static const std::string tunable[] = {
+		ov::hint::performance_mode.name(),
+		ov::num_streams.name(),
+		ov::inference_num_threads.name(),
+		ov::hint::inference_precision.name(),
+		ov::affinity.name(),
+		ov::hint::num_requests.name(),
+	};
+	return std::find(std::begin(tunable), std::end(tunable), name) != std::end(tunable);
+}
+
+/*
+ * @brief Change an OpenVINO property, the model is compiled again in the background and swapped in between two frames
+ * @param name, one of the tunable properties
+ * @param value, string form of the value, empty to go back to the plugin default
+ */
+void
+OpenVinoData::SetProperty(const std::string& name, const std::string& value)
+{
+	if (!IsTunableProperty(name))
+		throw std::invalid_argument("Unsupported property " + name);
+
+	std::lock_guard<std::mutex> lock(compile_mutex);
+	if (value.empty())
+		inference_config.properties.erase(name);
+	else
+		inference_config.properties[name] = value;
+
+	// a running recompilation picks the change up when it is done
+	if (compile_running)
+	{
+		compile_pending = true;
+		return;
+	}
+	if (compile_thread.joinable())
+		compile_thread.join();
+	compile_running = true;
+	compile_thread = std::thread(&OpenVinoData::RecompileLoop, this);
+}
+
+/*
+ * @brief Value of an OpenVINO property as the compiled model applies it, or as requested
+ * @param name, one of the tunable properties
+ */
+std::string
+OpenVinoData::GetProperty(const std::string& name)
+{
+	if (!IsTunableProperty(name))
+		throw std::invalid_argument("Unsupported property " + name);
+
+	ov::CompiledModel model;
+	{
+		std::lock_guard<std::mutex> submit_lock(submit_mutex);
+		model = compiled_model;
+	}
+	try
+	{
+		return model.get_property(name).as<std::string>();
+	}
+	catch (const std::exception&)
+	{
+		// not reported by this plugin, e.g. AFFINITY on GPU
+		std::lock_guard<std::mutex> lock(compile_mutex);
+		auto it = inference_config.properties.find(name);
+		if (it == inference_config.properties.end())
+			throw;
+		return it->second;
+	}
+}
+
+/*
+ * @brief Properties the model is compiled with, OpenVINO properties of the config override its scheduling settings
+ */
+ov::AnyMap
+OpenVinoData::CompileProperties(const InferenceConfig& config) const
+{
+	ov::AnyMap properties;
+	if (device_name.empty())
+	{
+		// the OpenCL path runs one frame at a time, only explicit properties apply
+	}
+	else if (tile_size > 0)
+	{
+		// tiles are independent, one stream per group of cores runs them in parallel
+		properties.emplace(ov::hint::performance_mode(ov::hint::PerformanceMode::THROUGHPUT));
+	}
+	else if (config.streams > 0)
+	{
+		// consecutive frames run side by side, one stream per group of cores
+		properties.emplace(ov::hint::performance_mode(ov::hint::PerformanceMode::THROUGHPUT));
+		properties.emplace(ov::num_streams(config.streams));
+	}
+
+	if (!core_set.Empty())
+	{
+		// streams are sized for the core set, and the plugin must not pin its threads to other cores
+		properties.emplace(ov::inference_num_threads(core_set.Count()));
+		properties.emplace(ov::affinity(ov::Affinity::NONE));
+	}
+
+	// string values are parsed by the plugin
+	for (const auto& property : config.properties)
+		properties[property.first] = property.second;
+	return properties;
+}
+
+/*
+ * @brief Compiled model cache of all sessions, they share one folder
+ */
+static ModelCache&
+SharedModelCache()
+{
+	static ModelCache cache(CreateCacheDir("ovgpu_cache"));
+	return cache;
+}
+
+/*
+ * @brief Size of the compiled model cache before the least recently used models are evicted, 0 disables it
+ */
+void
+OpenVinoData::SetModelCacheLimit(uint64_t bytes)
+{
+	SharedModelCache().SetSizeLimit(bytes);
+}
+
+/**
+ * @struct LogNames
+ * @brief Log files the live sessions write to
+ */
+struct LogNames
+{
+	std::mutex names_mutex;
+	std::set<std::string> names;
+};
+
+static LogNames&
+SharedLogNames()
+{
+	static LogNames log_names;
+	return log_names;
+}
+
+/*
+ * @brief Create the runtime shared by all sessions, so statics created later are destroyed first
+ */
+void
+OpenVinoData::CreateSharedRuntime()
+{
+	SharedCore();
+	SharedModelCache();
+	SharedLogNames();
+}
+
+/*
+ * @brief Open the log of the session; sessions of the same device and resolution, e.g. of two styles or of a
+ * variant probe, get numbered files instead of truncating each other's
+ */
+void
+OpenVinoData::OpenLog(const std::string& base)
+{
+	CloseLog();
+	LogNames& log_names = SharedLogNames();
+	{
+		std::lock_guard<std::mutex> lock(log_names.names_mutex);
+		log_name = base;
+		for (int i = 2; log_names.names.count(log_name) > 0; i++)
+			log_name = base + "_" + std::to_string(i);
+		log_names.names.insert(log_name);
+	}
+	logfile_mode.open(logFolder + "\\" + log_name + ".txt", std::ios::binary);
+}
+
+void
+OpenVinoData::CloseLog()
+{
+	logfile_mode.close();
+	if (log_name.empty())
+		return;
+	LogNames& log_names = SharedLogNames();
+	std::lock_guard<std::mutex> lock(log_names.names_mutex);
+	log_names.names.erase(log_name);
+	log_name.clear();
+}
+
+/*
+ * @brief Full name and capabilities of an OpenVINO device, with the OpenVINO version
+ */
+std::string
+OpenVinoData::DeviceDescription(const std::string& device)
+{
+	ov::Core& core = SharedCore();
+	std::ostringstream description;
+	description << "openvino " << ov::get_openvino_version().buildNumber << "\n"
+		<< "device " << device;
+	try
+	{
+		description << " " << core.get_property(device, ov::device::full_name) << "\ncapabilities";
+		for (const std::string& capability : core.get_property(device, ov::device::capabilities))
+			description << " " << capability;
+	}
+	catch (const ov::Exception&)
+	{
+		// virtual devices such as AUTO or MULTI have no full name of their own
+	}
+	description << "\n";
+	return description.str();
+}
+
+/*
+ * @brief Import the compiled model from the cache, or read the IR, bake pre/post processing into it,
+ * compile it for the device or the OpenCL context and export it to the cache
+ */
+ov::CompiledModel
+OpenVinoData::CompileModel(const InferenceConfig& config, const ModelIO& io)
+{
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	ov::Core& core = SharedCore();
+	ov::AnyMap properties = CompileProperties(config);
+	std::string device = device_name.empty() ? "GPU" : device_name;
+	auto compile = [&]()
+	{
+		shared_ptr<ov::Model> model = BuildStyleModel(core, model_xml_path, io);
+		if (device_name.empty())
+			return core.compile_model(model, ov::intel_gpu::ocl::ClContext(core, _oclCtx.get()), properties);
+		return core.compile_model(model, device_name, properties);
+	};
+
+	// only devices that import compiled models are cached
+	bool cacheable = false;
+	try
+	{
+		std::vector<std::string> capabilities = core.get_property(device, ov::device::capabilities);
+		cacheable = std::find(capabilities.begin(), capabilities.end(), ov::device::capability::EXPORT_IMPORT) != capabilities.end();
+	}
+	catch (std::exception&)
+	{
+	}
+
+	ov::CompiledModel compiled;
+	CacheResult cache = CacheResult::UNKNOWN;
+	if (!cacheable)
+	{
+		compiled = compile();
+	}
+	else
+	{
+		// everything the compiled model depends on, the cache adds the OpenVINO version
+		ModelCache& model_cache = SharedModelCache();
+		std::ostringstream key;
+		key << model_cache.ModelFilesKey(model_xml_path) << "\n"
+			<< "graph " << kStyleModelRevision << "\n"
+			<< "io " << static_cast<int>(io.input) << " " << static_cast<int>(io.output) << " " << io.width << "x" << io.height
+			<< " batch " << io.batch << " resize " << io.resize << " gpu_buffers " << io.gpu_buffers << "\n"
+			<< "device " << (device_name.empty() ? "GPU OpenCL context" : device_name) << "\n";
+		for (const auto& property : properties)
+		{
+			key << property.first << "=";
+			property.second.print(key);
+			key << "\n";
+		}
+
+		compiled = model_cache.Load(key.str(), compile,
+			[&](std::istream& blob)
+			{
+				if (device_name.empty())
+					return core.import_model(blob, ov::intel_gpu::ocl::ClContext(core, _oclCtx.get()), properties);
+				return core.import_model(blob, device_name, properties);
+			},
+			&cache);
+	}
+
+	pipeline_stats.RecordLoad(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count(), cache);
+	return compiled;
+}
+
+/*
+ * @brief Compile again until no property change is pending, runs on compile_thread
+ */
+void
+OpenVinoData::RecompileLoop()
+{
+	for (;;)
+	{
+		InferenceConfig config;
+		{
+			std::lock_guard<std::mutex> lock(compile_mutex);
+			config = inference_config;
+			compile_pending = false;
+		}
+
+		try
+		{
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			ScopedThreadAffinity affinity(core_set);
+			ov::CompiledModel model = CompileModel(config, model_io);
+			SwapCompiledModel(model);
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+			clog << "Model recompiled with new properties in "
+				<< std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "ms" << endl;
+		}
+		catch (std::exception& ex)
+		{
+			// the model keeps running with the properties it was compiled with
+			clog << "Recompiling with new properties failed: " << ex.what() << endl;
+		}
+
+		std::lock_guard<std::mutex> lock(compile_mutex);
+		if (!compile_pending)
+		{
+			compile_running = false;
+			return;
+		}
+	}
+}
+
+/*
+ * @brief Replace compiled_model between two frames. Frames in flight finish on the old model,
+ * their slots get requests of the new one when they are reused.
+ */
+void
+OpenVinoData::SwapCompiledModel(const ov::CompiledModel& model)
+{
+	std::lock_guard<std::mutex> submit_lock(submit_mutex);
+	std::lock_guard<std::mutex> result_lock(result_mutex);
+
+	compiled_model = model;
+	model_generation++;
+	// batched models are compiled again with the new properties when they are next used
+	batch_models.clear();
+	if (device_name.empty())
+	{
+		CreateOCLRequest();
+	}
+	else if (tile_size > 0)
+	{
+		unsigned int request_count = compiled_model.get_property(ov::optimal_number_of_infer_requests);
+		tile_requests.clear();
+		for (unsigned int i = 0; i < std::max(1u, request_count); i++)
+		{
+			tile_requests.push_back(compiled_model.create_infer_request());
+		}
+	}
+	else
+	{
+		CreateSlotRequest(cpu_slot);
+	}
+
+	logfile_mode << "recompiled:";
+	for (const auto& property : inference_config.properties)
+		logfile_mode << " " << property.first << "=" << property.second;
+	logfile_mode << "\n";
+}
+
+/*
+ * @brief Call infer using loaded model files
+ * @param filePath
+ * @param width of image after style transfer
+ * @param height of image after style transfer
+ * @param out, BGR float image raw data after style transfer, in range (0,255)
+ */
+bool
+OpenVinoData::Infer( 
+	std::string filePath, int* w, int* h, float* out)
+{
+	cv::Mat image = cv::imread(filePath);
+	if (image.empty())
+	{
+		throw std::runtime_error("Can't read image " + filePath);
+	}
+
+	cv::Mat outputImage(model_height, model_width, CV_8UC3);
+	Infer(image.data, image.cols, image.rows, outputImage.data, false);
+
+	cv::Mat out_image(model_height, model_width, CV_32FC3, out);
+	outputImage.convertTo(out_image, CV_32F);
+	*w = model_width;
+	*h = model_height;
+	return true;
+}
+
+/*
+ * @brief Call infer using image raw data
+ * @param inferdata, BGR image raw data
+ * @param inwidth, width of image
+ * @param inheight, height of image
+ * @param out, image raw data after style transfer
+ */
+bool
+OpenVinoData::Infer(
+	unsigned char* inferdata, int inwidth, int inheight, unsigned char* out, bool debug_flag)
+{
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> submit_lock(submit_mutex);
+	std::lock_guard<std::mutex> result_lock(result_mutex);
+
+	// BGR frames go through the same BGRA path as captured frames
+	cv::cvtColor(cv::Mat(inheight, inwidth, CV_8UC3, inferdata), bgra_image, cv::COLOR_BGR2BGRA);
+	result_image.create(model_height, model_width, CV_8UC4);
+	RunFrame(bgra_image.data, inwidth, inheight, static_cast<int>(bgra_image.step),
+		result_image.data, static_cast<int>(result_image.step), debug_flag, begin);
+	cv::Mat out_image(model_height, model_width, CV_8UC3, out);
+	cv::cvtColor(result_image, out_image, cv::COLOR_BGRA2BGR);
+
+	LogFrameTime(begin);
+	return true;
+}
+
+/*
+ * @brief Call infer using a BGRA frame as captured by the engine
+ * @param inferdata, BGRA image raw data
+ * @param inwidth, width of image
+ * @param inheight, height of image
+ * @param inpitch, distance in bytes between two rows of inferdata
+ * @param out, BGRA image raw data after style transfer
+ * @param outpitch, distance in bytes between two rows of out
+ */
+bool
+OpenVinoData::InferBGRA(
+	const unsigned char* inferdata, int inwidth, int inheight, int inpitch, unsigned char* out, int outpitch, bool debug_flag)
+{
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> submit_lock(submit_mutex);
+	std::lock_guard<std::mutex> result_lock(result_mutex);
+
+	size_t row_size = static_cast<size_t>(model_width) * 4;
+	if (change_threshold > 0.0f)
+	{
+		float change = change_detector.Measure(inferdata, inwidth, inheight, inpitch);
+		bool skipped = change < change_threshold && !unchanged_output.empty();
+		pipeline_stats.RecordChangeCheck(skipped);
+		if (skipped)
+		{
+			for (int y = 0; y < model_height; y++)
+				memcpy(out + static_cast<size_t>(y) * outpitch, unchanged_output.data() + y * row_size, row_size);
+			last_inference_ms = 0.0;
+			return true;
+		}
+	}
+
+	RunFrame(inferdata, inwidth, inheight, inpitch, out, outpitch, debug_flag, begin);
+
+	if (change_threshold > 0.0f)
+	{
+		// later frames are compared with this one, and answered with its result
+		change_detector.Accept();
+		unchanged_output.resize(row_size * model_height);
+		for (int y = 0; y < model_height; y++)
+			memcpy(unchanged_output.data() + y * row_size, out + static_cast<size_t>(y) * outpitch, row_size);
+	}
+
+	LogFrameTime(begin);
+	last_inference_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	return true;
+}
+
+/*
+ * @brief Call infer using a BGRA frame as captured by the engine, and rescale the result to the output size
+ * @param outwidth, width of out
+ * @param outheight, height of out
+ */
+bool
+OpenVinoData::InferBGRAScaled(
+	const unsigned char* inferdata, int inwidth, int inheight, int inpitch, unsigned char* out, int outwidth, int outheight, int outpitch, bool debug_flag)
+{
+	if (outwidth == model_width && outheight == model_height)
+		return InferBGRA(inferdata, inwidth, inheight, inpitch, out, outpitch, debug_flag);
+
+	std::lock_guard<std::mutex> scale_lock(scale_mutex);
+	scaled_output.create(model_height, model_width, CV_8UC4);
+	InferBGRA(inferdata, inwidth, inheight, inpitch, scaled_output.data, static_cast<int>(scaled_output.step), debug_flag);
+
+	std::chrono::steady_clock::time_point copy_begin = std::chrono::steady_clock::now();
+	cv::Mat out_image(outheight, outwidth, CV_8UC4, out, outpitch);
+	cv::resize(scaled_output, out_image, out_image.size(), 0, 0, cv::INTER_LINEAR);
+	pipeline_stats.Record(PipelineStage::OUTPUT_COPY, copy_begin);
+	return true;
+}
+
+/*
+ * @brief Run one mid-gray frame at model resolution, the first inferences of a compiled model allocate and select kernels
+ */
+void
+OpenVinoData::WarmUpFrame()
+{
+	cv::Mat input(model_height, model_width, CV_8UC4, cv::Scalar(128, 128, 128, 255));
+	cv::Mat output(model_height, model_width, CV_8UC4);
+	{
+		std::lock_guard<std::mutex> submit_lock(submit_mutex);
+		std::lock_guard<std::mutex> result_lock(result_mutex);
+		RunFrame(input.data, input.cols, input.rows, static_cast<int>(input.step), output.data, static_cast<int>(output.step), false,
+			std::chrono::steady_clock::now());
+	}
+	pipeline_stats.ResetStages();
+}
+
+/*
+ * @brief Synchronous inference of a strided BGRA frame, callers hold the submit and result locks
+ */
+void
+OpenVinoData::RunFrame(
+	const unsigned char* inferdata, int inwidth, int inheight, int inpitch, unsigned char* out, int outpitch, bool debug_flag,
+	std::chrono::steady_clock::time_point received)
+{
+	if (tile_size > 0)
+	{
+		RunTiled(inferdata, inwidth, inheight, inpitch, out, outpitch, debug_flag, received);
+		return;
+	}
+
+	PrepareInput(cpu_slot, inferdata, inwidth, inheight, inpitch, debug_flag, received);
+	BindOutput(cpu_slot, out, outpitch);
+
+	/* Running the request synchronously */
+	std::chrono::steady_clock::time_point infer_begin = std::chrono::steady_clock::now();
+	cpu_slot.request.infer();
+	pipeline_stats.Record(PipelineStage::INFER, infer_begin);
+
+	ReadOutput(cpu_slot, out, outpitch, debug_flag);
+}
+
+/*
+ * @brief Tiled inference of a strided BGRA frame, tiles run on parallel requests and are blended in order
+ */
+void
+OpenVinoData::RunTiled(
+	const unsigned char* inferdata, int inwidth, int inheight, int inpitch, unsigned char* out, int outpitch, bool debug_flag,
+	std::chrono::steady_clock::time_point received)
+{
+	std::chrono::steady_clock::time_point preprocess_begin = std::chrono::steady_clock::now();
+	pipeline_stats.Record(PipelineStage::CAPTURE_HANDOFF, received, preprocess_begin);
+	cv::Mat frame(inheight, inwidth, CV_8UC4, const_cast<unsigned char*>(inferdata), inpitch);
+	if (debug_flag)
+	{
+		cv::imwrite("input.png", frame);
+	}
+	// tiles are cut from the frame at model resolution
+	if (inwidth != model_width || inheight != model_height)
+	{
+		cv::resize(frame, tile_source, cv::Size(model_width, model_height), 0, 0, cv::INTER_LINEAR);
+		frame = tile_source;
+	}
+	// cutting and blending the tiles overlaps with their inference, it is accounted to the infer stage
+	std::chrono::steady_clock::time_point infer_begin = std::chrono::steady_clock::now();
+	pipeline_stats.Record(PipelineStage::PREPROCESS, preprocess_begin, infer_begin);
+
+	int window = tile_size + 2 * tile_halo;
+	int tiles_x = (model_width + tile_size - 1) / tile_size;
+	int tiles_y = (model_height + tile_size - 1) / tile_size;
+	int tile_count = tiles_x * tiles_y;
+	cv::Mat out_image(model_height, model_width, CV_8UC4, out, outpitch);
+
+	if (dirty_tile_threshold > 0.0f)
+	{
+		RunDirtyTiles(frame, out_image);
+	}
+	else
+	{
+		tile_strip.create(tile_size + tile_halo, model_width, CV_8UC4);
+
+		// request k % n runs tile k, the tile it ran before is blended first so tiles are blended in order
+		int request_count = static_cast<int>(tile_requests.size());
+		for (int k = 0; k < tile_count + request_count; k++)
+		{
+			ov::InferRequest& request = tile_requests[k % request_count];
+			int done = k - request_count;
+			if (done >= 0 && done < tile_count)
+			{
+				request.wait();
+				const cv::Mat tile(window, window, CV_8UC4, request.get_output_tensor().data<uint8_t>());
+				BlendTile(tile, done % tiles_x, done / tiles_x, tile_strip);
+				if (done % tiles_x == tiles_x - 1)
+					WriteStrip(tile_strip, done / tiles_x, out_image);
+			}
+			if (k < tile_count)
+				StartTile(frame, k % tiles_x, k / tiles_x, request);
+		}
+	}
+	pipeline_stats.Record(PipelineStage::INFER, infer_begin);
+
+	if (debug_flag)
+	{
+		cv::imwrite("output.png", out_image);
+	}
+}
+
+/*
+ * @brief Run the tiles of a frame at model resolution whose window changed, and compose the output of the results of all tiles
+ * A tile is dirty when its window, halo included, differs from the reference; only the core of an inferred tile
+ * becomes the reference again, so slow drift still dirties a tile eventually. Strips are kept per row of tiles, a row
+ * is written again when its strip or the one above changed, so seams are blended the same as in a full pass.
+ */
+void
+OpenVinoData::RunDirtyTiles(
+	const cv::Mat& frame, cv::Mat& out_image)
+{
+	int window = tile_size + 2 * tile_halo;
+	int half_band = tile_halo / 2;
+	int tiles_x = (model_width + tile_size - 1) / tile_size;
+	int tiles_y = (model_height + tile_size - 1) / tile_size;
+	int tile_count = tiles_x * tiles_y;
+	if (static_cast<int>(tile_results.size()) != tile_count || tile_output.rows != model_height || tile_output.cols != model_width)
+	{
+		tile_results.assign(tile_count, cv::Mat());
+		tile_strips.assign(tiles_y, cv::Mat());
+		tile_output.create(model_height, model_width, CV_8UC4);
+		tile_detector.Reset();
+	}
+
+	tile_detector.Measure(frame.data, model_width, model_height, static_cast<int>(frame.step));
+	std::vector<int> dirty;
+	std::vector<bool> dirty_rows(tiles_y, false);
+	for (int k = 0; k < tile_count; k++)
+	{
+		cv::Rect roi = TileWindow(k % tiles_x, k / tiles_x);
+		if (tile_results[k].empty() || tile_detector.MeasureRegion(roi.x, roi.y, roi.width, roi.height) >= dirty_tile_threshold)
+		{
+			dirty.push_back(k);
+			dirty_rows[k / tiles_x] = true;
+		}
+	}
+
+	// request i % n runs the i-th dirty tile, the tile it ran before is kept first
+	int dirty_count = static_cast<int>(dirty.size());
+	int request_count = static_cast<int>(tile_requests.size());
+	for (int i = 0; i < dirty_count + request_count; i++)
+	{
+		ov::InferRequest& request = tile_requests[i % request_count];
+		int done = i - request_count;
+		if (done >= 0 && done < dirty_count)
+		{
+			request.wait();
+			int k = dirty[done];
+			cv::Mat(window, window, CV_8UC4, request.get_output_tensor().data<uint8_t>()).copyTo(tile_results[k]);
+			int core_x = (k % tiles_x) * tile_size;
+			int core_y = (k / tiles_x) * tile_size;
+			tile_detector.AcceptRegion(core_x, core_y, tile_size, tile_size);
+		}
+		if (i < dirty_count)
+			StartTile(frame, dirty[i] % tiles_x, dirty[i] / tiles_x, request);
+	}
+
+	for (int tileY = 0; tileY < tiles_y; tileY++)
+	{
+		if (!dirty_rows[tileY])
+			continue;
+		tile_strips[tileY].create(tile_size + tile_halo, model_width, CV_8UC4);
+		for (int tileX = 0; tileX < tiles_x; tileX++)
+			BlendTile(tile_results[tileY * tiles_x + tileX], tileX, tileY, tile_strips[tileY]);
+	}
+	for (int tileY = 0; tileY < tiles_y; tileY++)
+	{
+		if (!dirty_rows[tileY] && (tileY == 0 || !dirty_rows[tileY - 1]))
+			continue;
+		if (tileY > 0)
+		{
+			// the band above the seam holds the row above unblended before this row is cross-faded into it
+			int core_y = tileY * tile_size;
+			int above_begin = tileY == 1 ? 0 : core_y - tile_size - half_band;
+			for (int y = core_y - half_band; y < std::min(model_height, core_y + half_band); y++)
+				tile_strips[tileY - 1].row(y - above_begin).copyTo(tile_output.row(y));
+		}
+		WriteStrip(tile_strips[tileY], tileY, tile_output);
+	}
+	tile_output.copyTo(out_image);
+	pipeline_stats.RecordTiles(dirty_count, tile_count);
+}
+
+/*
+ * @brief Window of a tile in the frame at model resolution, moved inside the frame at its borders
+ */
+cv::Rect
+OpenVinoData::TileWindow(
+	int tileX, int tileY) const
+{
+	int window = tile_size + 2 * tile_halo;
+	int origin_x = std::max(0, std::min(tileX * tile_size - tile_halo, model_width - window));
+	int origin_y = std::max(0, std::min(tileY * tile_size - tile_halo, model_height - window));
+	return cv::Rect(origin_x, origin_y, std::min(window, model_width - origin_x), std::min(window, model_height - origin_y));
+}
+
+/*
+ * @brief Copy the window of a tile into the input tensor of a request and start it, frames smaller than a window are padded
+ */
+void
+OpenVinoData::StartTile(
+	const cv::Mat& frame, int tileX, int tileY, ov::InferRequest& request)
+{
+	int window = tile_size + 2 * tile_halo;
+	cv::Rect roi = TileWindow(tileX, tileY);
+	ov::Tensor input_tensor = request.get_input_tensor();
+	cv::Mat window_image(window, window, CV_8UC4, input_tensor.data<uint8_t>());
+	cv::copyMakeBorder(frame(roi), window_image, 0, window - roi.height, 0, window - roi.width, cv::BORDER_REPLICATE);
+	request.start_async();
+}
+
+/*
+ * @brief Blend the result of one tile into the strip of its row
+ * Neighbouring tiles overlap by twice the halo, they are cross-faded over the halo width centered on the seam
+ * so every pixel taken from a tile sees at least half the halo of context.
+ */
+void
+OpenVinoData::BlendTile(
+	const cv::Mat& tile, int tileX, int tileY, cv::Mat& strip)
+{
+	int half_band = tile_halo / 2;
+	int band = 2 * half_band;
+	int tiles_x = (model_width + tile_size - 1) / tile_size;
+
+	int core_x = tileX * tile_size;
+	int core_y = tileY * tile_size;
+	int x_begin = tileX == 0 ? 0 : core_x - half_band;
+	int x_end = std::min(model_width, tileX == tiles_x - 1 ? model_width : core_x + tile_size + half_band);
+	int y_begin = tileY == 0 ? 0 : core_y - half_band;
+	int y_end = std::min(model_height, core_y + tile_size + half_band);
+	cv::Rect roi = TileWindow(tileX, tileY);
+	int origin_x = roi.x;
+	int origin_y = roi.y;
+
+	int fade_end = tileX == 0 ? x_begin : std::min(core_x + half_band, x_end);
+	for (int y = y_begin; y < y_end; y++)
+	{
+		const unsigned char* src = tile.ptr<unsigned char>(y - origin_y);
+		unsigned char* dst = strip.ptr<unsigned char>(y - y_begin);
+		// weight of this tile rises from 0 to 256 across the seam with its left neighbour
+		for (int x = x_begin; x < fade_end; x++)
+		{
+			int weight = ((x - x_begin) * 2 + 1) * 128 / band;
+			for (int c = 0; c < 4; c++)
+			{
+				unsigned char& pixel = dst[4 * x + c];
+				pixel = static_cast<unsigned char>((pixel * (256 - weight) + src[4 * (x - origin_x) + c] * weight + 128) >> 8);
+			}
+		}
+		memcpy(dst + 4 * static_cast<size_t>(fade_end), src + 4 * static_cast<size_t>(fade_end - origin_x), 4 * static_cast<size_t>(x_end - fade_end));
+	}
+}
+
+/*
+ * @brief Blend a complete strip into the output, its top band is cross-faded with the row above
+ */
+void
+OpenVinoData::WriteStrip(
+	const cv::Mat& strip, int tileY, cv::Mat& out_image)
+{
+	int half_band = tile_halo / 2;
+	int band = 2 * half_band;
+	int core_y = tileY * tile_size;
+	int y_begin = tileY == 0 ? 0 : core_y - half_band;
+	int y_end = std::min(model_height, core_y + tile_size + half_band);
+
+	int row_fade_end = tileY == 0 ? y_begin : std::min(core_y + half_band, y_end);
+	for (int y = y_begin; y < y_end; y++)
+	{
+		cv::Mat strip_row = strip.row(y - y_begin);
+		cv::Mat out_row = out_image.row(y);
+		if (y < row_fade_end)
+		{
+			double weight = ((y - y_begin) + 0.5) / band;
+			cv::addWeighted(out_row, 1.0 - weight, strip_row, weight, 0.0, out_row);
+		}
+		else
+		{
+			strip_row.copyTo(out_row);
+		}
+	}
+}
+
+/*
+ * @brief Choose how model output values are mapped onto (0,255) in BGRA results, only used by the host kernels
+ * @param runningRange, false for the fixed (-1,1) range, true to follow a running min/max estimate
+ */
+void
+OpenVinoData::SetRunningOutputRange(bool runningRange)
+{
+	// the graph postprocessing maps the fixed range, a running range would silently not apply
+	if (process_in_graph && runningRange)
+		throw std::logic_error("A running output range needs the host kernels, see OpenVino_SetProcessingInGraph");
+
+	std::lock_guard<std::mutex> result_lock(result_mutex);
+	if (runningRange)
+		postprocess_kernel.SetRunningRange(0.1f);
+	else
+		postprocess_kernel.SetFixedRange(-1.0f, 1.0f);
+}
+
+/*
+ * @brief Skip the inference of frames that differ less than "threshold" from the last inferred one
+ */
+void
+OpenVinoData::SetChangeThreshold(float threshold)
+{
+	std::lock_guard<std::mutex> submit_lock(submit_mutex);
+	change_threshold = std::max(threshold, 0.0f);
+	// the next frame is inferred and becomes the reference
+	change_detector.Reset();
+	unchanged_output.clear();
+}
+
+/*
+ * @brief Run only the tiles whose window changed by at least "threshold" since they were last inferred
+ */
+void
+OpenVinoData::SetDirtyTileThreshold(float threshold)
+{
+	if (tile_size == 0 && threshold > 0.0f)
+		throw std::logic_error("Dirty tiles need tiled inference, see OpenVino_SetTiling");
+
+	std::lock_guard<std::mutex> submit_lock(submit_mutex);
+	dirty_tile_threshold = std::max(threshold, 0.0f);
+	// the next frame runs all tiles
+	tile_results.clear();
+}
+
+/*
+ * @brief (Re)create the pool of asynchronous infer requests
+ * @param framesInFlight, number of frames that may be submitted before a result is collected
+ */
+void
+OpenVinoData::SetFramesInFlight(int framesInFlight)
+{
+	if (framesInFlight < 1)
+		throw std::invalid_argument("At least one frame must be allowed in flight");
+	if (tile_size > 0)
+		throw std::logic_error("Asynchronous frames are not supported with tiled inference");
+
+	// no frame is submitted from here on, the running ones finish before their slots are destroyed
+	std::lock_guard<std::mutex> submit_lock(submit_mutex);
+	WaitAllSlots();
+
+	std::lock_guard<std::mutex> result_lock(result_mutex);
+	std::unique_lock<std::mutex> lock(slot_mutex);
+
+	infer_slots.clear();
+	infer_slots.resize(framesInFlight);
+	submit_sequence = 0;
+	for (size_t i = 0; i < infer_slots.size(); i++)
+	{
+		CreateAsyncRequest(i);
+	}
+}
+
+/*
+ * @brief Preprocess a frame and start its inference asynchronously
+ * @param inferdata, BGRA image raw data
+ * @param inwidth, width of image
+ * @param inheight, height of image
+ * @param inpitch, distance in bytes between two rows of inferdata
+ * @param frameId, caller defined tag returned with the result
+ * @param out, optional registered buffer the result is written to in place
+ * @param outpitch, distance in bytes between two rows of out
+ * @return false if all requests are in flight and no frame was submitted
+ */
+bool
+OpenVinoData::SubmitFrame(
+	const unsigned char* inferdata, int inwidth, int inheight, int inpitch, long long frameId, bool debug_flag, unsigned char* out, int outpitch)
 {
-	logfile_mode.open(logFolder + "\\mode_normal_" + devicename + ".txt", std::ios::binary);
+	if (tile_size > 0)
+		throw std::logic_error("Asynchronous frames are not supported with tiled inference");
+
 	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> submit_lock(submit_mutex);
 
-	// --------------------------- 1. Read IR Generated by ModelOptimizer (.xml and .bin files) ------------
-	clog << "2. Read IR..." << endl;
-	Core core;
-	core.SetConfig({ {CONFIG_KEY(CACHE_DIR), gpuCacheFolder }}, devicename);
-	/** Set batch size to 1 **/
-	CNNNetwork network = core.ReadNetwork(modelXmlFilePath);
-	auto shapes = network.getInputShapes();
-	for (auto& shape : shapes)
-		shape.second[0] = 1;
-	network.reshape(shapes);
+	InferSlot* slot = nullptr;
+	size_t index = 0;
+	{
+		std::lock_guard<std::mutex> lock(slot_mutex);
+		for (; index < infer_slots.size(); index++)
+		{
+			if (infer_slots[index].state == InferSlot::FREE)
+			{
+				slot = &infer_slots[index];
+				break;
+			}
+		}
+	}
+	if (slot == nullptr)
+		return false;
 
+	// the model was recompiled since this slot last ran
+	if (slot->generation != model_generation)
+		CreateAsyncRequest(index);
 
-	// --------------------------- 2. Configure input & output ---------------------------------------------
-	clog << "3. Configure input/output..." << endl;
-	input_info = network.getInputsInfo().begin()->second;
-	input_name = network.getInputsInfo().begin()->first;
+	// the slot stays FREE while it is filled, only this (serialized) path takes FREE slots
+	PrepareInput(*slot, inferdata, inwidth, inheight, inpitch, debug_flag, begin);
+	BindOutput(*slot, out, outpitch);
+
+	{
+		std::lock_guard<std::mutex> lock(slot_mutex);
+		slot->frame_id = frameId;
+		slot->sequence = submit_sequence++;
+		slot->submit_time = begin;
+		slot->error = nullptr;
+		slot->state = InferSlot::RUNNING;
+	}
+	slot->infer_begin = std::chrono::steady_clock::now();
+	slot->request.start_async();
+	return true;
+}
+
+/*
+ * @brief Collect the next frame in submission order, once it finished. Frames that finish
+ * early stay in their slots, the slot pool is the reorder buffer.
+ * @param out, BGRA image raw data after style transfer, may be nullptr if the frame was submitted with an output buffer
+ * @param outpitch, distance in bytes between two rows of out
+ * @param frameId, tag of the collected frame, -1 if the next frame did not finish in time or none is in flight
+ * @param timeoutMs, 0 to poll, negative to wait until the next frame finishes
+ */
+void
+OpenVinoData::GetResult(
+	unsigned char* out, int outpitch, long long* frameId, int timeoutMs, bool debug_flag)
+{
+	if (tile_size > 0)
+		throw std::logic_error("Asynchronous frames are not supported with tiled inference");
+
+	std::lock_guard<std::mutex> result_lock(result_mutex);
+	*frameId = -1;
+
+	InferSlot* slot = nullptr;
+	{
+		std::unique_lock<std::mutex> lock(slot_mutex);
+		// with no frame in flight there is nothing to wait for, the caller gets -1 right away
+		auto find_done = [this, &slot]()
+		{
+			slot = nullptr;
+			for (InferSlot& candidate : infer_slots)
+			{
+				if (candidate.state != InferSlot::FREE &&
+					(slot == nullptr || candidate.sequence < slot->sequence))
+				{
+					slot = &candidate;
+				}
+			}
+			if (slot == nullptr)
+				return true;
+			if (slot->state != InferSlot::DONE)
+				slot = nullptr;
+			return slot != nullptr;
+		};
+
+		if (timeoutMs < 0)
+			slot_done.wait(lock, find_done);
+		else if (timeoutMs > 0)
+			slot_done.wait_for(lock, std::chrono::milliseconds(timeoutMs), find_done);
+		else
+			find_done();
+	}
+	if (slot == nullptr)
+		return;
+
+	if (slot->error)
+	{
+		std::exception_ptr error;
+		{
+			std::lock_guard<std::mutex> lock(slot_mutex);
+			std::swap(error, slot->error);
+			slot->state = InferSlot::FREE;
+		}
+		std::rethrow_exception(error);
+	}
 
+	ReadOutput(*slot, out, outpitch, debug_flag);
 
-	cv::Size& new_input_resolution = cv::Size(inferWidth, inferHeight);
-	SizeVector input_dims = input_info->getTensorDesc().getDims();
-	input_dims[0] = 1;
-	if (new_input_resolution != cv::Size()) {
-		input_dims[2] = static_cast<size_t>(new_input_resolution.height);
-		input_dims[3] = static_cast<size_t>(new_input_resolution.width);
+	std::chrono::steady_clock::time_point begin = slot->submit_time;
+	{
+		std::lock_guard<std::mutex> lock(slot_mutex);
+		*frameId = slot->frame_id;
+		slot->state = InferSlot::FREE;
 	}
+	LogFrameTime(begin);
+}
 
-	std::map<std::string, SizeVector> input_shapes;
-	input_shapes[network.getInputsInfo().begin()->first] = input_dims;
-	network.reshape(input_shapes);
+/*
+ * @brief Call infer on a batch of same-sized BGRA frames in one inference
+ * @param inputs, BGRA image raw data of each frame
+ * @param count, number of frames
+ * @param inwidth, width of the frames
+ * @param inheight, height of the frames
+ * @param inpitch, distance in bytes between two rows of each input
+ * @param outputs, BGRA image raw data after style transfer of each frame, nullptr to drop a result
+ * @param outpitch, distance in bytes between two rows of each output
+ */
+void
+OpenVinoData::InferBatch(
+	const unsigned char* const* inputs, int count, int inwidth, int inheight, int inpitch,
+	unsigned char* const* outputs, int outpitch, bool debug_flag)
+{
+	std::vector<int> outpitches(std::max(count, 0), outpitch);
+	RunBatch(inputs, count, inwidth, inheight, inpitch, outputs, outpitches.data(), debug_flag);
+}
 
-	input_info->setLayout(Layout::NCHW);
-	input_info->setPrecision(Precision::FP32);
+/*
+ * @brief Batched inference with a pitch per output
+ */
+void
+OpenVinoData::RunBatch(
+	const unsigned char* const* inputs, int count, int inwidth, int inheight, int inpitch,
+	unsigned char* const* outputs, const int* outpitches, bool debug_flag)
+{
+	if (count < 1)
+		throw std::invalid_argument("A batch needs at least one frame");
+	if (tile_size > 0)
+		throw std::logic_error("Batched inference is not supported with tiled inference");
 
-	DataPtr output_info = network.getOutputsInfo().begin()->second;
-	output_name = network.getOutputsInfo().begin()->first;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> submit_lock(submit_mutex);
+	std::lock_guard<std::mutex> result_lock(result_mutex);
 
-	output_info->setPrecision(Precision::FP32);
+	BatchModel& batch = GetBatchModel(count);
 
-	// --------------------------- 3. Loading model to the plugin ------------------------------------------
-	clog << "4. Loading model..." << endl;
-	executable_network = core.LoadNetwork(network, devicename);//, cnnConfig.execNetworkConfig);
+	// frames are stacked along N, each at capture size or resized to model resolution on the host
+	int frame_width = batch.resize_in_graph ? inwidth : model_width;
+	int frame_height = batch.resize_in_graph ? inheight : model_height;
+	ov::Shape input_shape = { static_cast<size_t>(count), static_cast<size_t>(frame_height), static_cast<size_t>(frame_width), 4 };
+	ov::Tensor input = batch.request.get_input_tensor();
+	if (input.get_shape() != input_shape)
+	{
+		input = ov::Tensor(ov::element::u8, input_shape);
+		batch.request.set_input_tensor(input);
+	}
 
-	clog << "Intialized." << endl;
+	std::chrono::steady_clock::time_point stack_begin = std::chrono::steady_clock::now();
+	size_t frame_size = static_cast<size_t>(frame_width) * frame_height * 4;
+	for (int i = 0; i < count; i++)
+	{
+		cv::Mat frame(inheight, inwidth, CV_8UC4, const_cast<unsigned char*>(inputs[i]), inpitch);
+		cv::Mat slot(frame_height, frame_width, CV_8UC4, input.data<uint8_t>() + i * frame_size);
+		if (frame.size() == slot.size())
+			frame.copyTo(slot);
+		else
+			cv::resize(frame, slot, slot.size(), 0, 0, cv::INTER_LINEAR);
+	}
+	// frames resized on the host are preprocessed, frames copied as they are only handed off
+	std::chrono::steady_clock::time_point infer_begin = std::chrono::steady_clock::now();
+	bool resized = frame_width != inwidth || frame_height != inheight;
+	pipeline_stats.Record(PipelineStage::CAPTURE_HANDOFF, begin, resized ? stack_begin : infer_begin);
+	if (resized)
+		pipeline_stats.Record(PipelineStage::PREPROCESS, stack_begin, infer_begin);
+
+	batch.request.infer();
+
+	std::chrono::steady_clock::time_point copy_begin = std::chrono::steady_clock::now();
+	pipeline_stats.Record(PipelineStage::INFER, infer_begin, copy_begin);
+	ov::Tensor output = batch.request.get_output_tensor();
+	size_t result_size = static_cast<size_t>(model_width) * model_height * 4;
+	for (int i = 0; i < count; i++)
+	{
+		if (outputs[i] == nullptr)
+			continue;
+		cv::Mat result(model_height, model_width, CV_8UC4, output.data<uint8_t>() + i * result_size);
+		result.copyTo(cv::Mat(model_height, model_width, CV_8UC4, outputs[i], outpitches[i]));
+	}
+	pipeline_stats.Record(PipelineStage::OUTPUT_COPY, copy_begin);
+
+	if (debug_flag)
+	{
+		cv::imwrite("output_batch_0.png", cv::Mat(model_height, model_width, CV_8UC4, output.data<uint8_t>()));
+	}
+
+	LogFrameTime(begin);
+}
 
+/*
+ * @brief Batched model of a batch size, compiled when it is first used; callers hold the submit and result locks
+ */
+OpenVinoData::BatchModel&
+OpenVinoData::GetBatchModel(int count)
+{
+	auto it = batch_models.find(count);
+	if (it != batch_models.end())
+		return it->second;
+
+	// batches always convert in the graph, only the CPU plugin resizes frames of any size there
+	ModelIO io;
+	io.input = ModelInput::BGRX_U8;
+	io.output = ModelOutput::BGRA_U8;
+	io.width = model_width;
+	io.height = model_height;
+	io.batch = count;
+	io.resize = device_name.rfind("CPU", 0) == 0;
+
+	InferenceConfig config;
+	{
+		std::lock_guard<std::mutex> lock(compile_mutex);
+		config = inference_config;
+	}
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	BatchModel batch;
+	batch.model = CompileModel(config, io);
+	batch.request = batch.model.create_infer_request();
+	batch.resize_in_graph = io.resize;
 	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-	loading_time = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count());
-	logfile_mode << "model input size:" << inferWidth << "," << inferHeight << "\n";
-	logfile_mode << "Loading model takes:" << loading_time << "ms\n";
+	logfile_mode << "batch " << count << " loading takes:"
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "ms\n";
+
+	return batch_models.emplace(count, std::move(batch)).first->second;
 }
 
 /*
- * @brief Call infer using loaded model files
- * @param filePath
- * @param modelBinFilePath
- * @param modelLabelFilePath
+ * @brief Add one view of a frame to the batch of that frame, the batch runs once all views are submitted
+ * @param frameNumber, frame the view belongs to, increasing
+ * @param viewIndex, index of the view within the frame
+ * @param viewCount, number of views of the frame
+ * @return true if this call ran the batch and all outputs of the frame are written
  */
 bool
-OpenVinoData::Infer( 
-	std::string filePath, int* w, int* h, float* out)
+OpenVinoData::SubmitView(
+	long long frameNumber, int viewIndex, int viewCount,
+	const unsigned char* input, int inwidth, int inheight, int inpitch,
+	unsigned char* output, int outpitch, bool debug_flag)
 {
-	// --------------------------- 5. Create infer request -------------------------------------------------
-	clog << "5. Creating request..." << endl;
-	InferRequest infer_request = executable_network.CreateInferRequest();
+	std::lock_guard<std::mutex> lock(view_mutex);
 
-	// return image_file_name;
+	// views of an earlier frame that never completed run on their own
+	if (views_submitted > 0 && view_frame != frameNumber)
+		RunViewBatch(debug_flag);
 
-	// --------------------------- 6. Prepare input --------------------------------------------------------
-	cout << "6. Prepare input..." << endl;
-	int height = 1080;
-	int width = 1920;
-	//cv::Mat image(height, width, CV_8UC4, texture);
-	cv::Mat image = cv::imread(filePath);
-	cv::Mat outputImage;
-	cv::cvtColor(image, image, cv::COLOR_BGRA2RGB);
-	image.convertTo(image, CV_32F, 1.0 / 255, 0);
-	/* Resize manually and copy data from the image to the input blob */
-	Blob::Ptr input = infer_request.GetBlob(input_name);
-	auto input_data = input->buffer().as<PrecisionTrait<Precision::U8>::value_type*>();
-
-	auto size = cv::Size(input_info->getTensorDesc().getDims()[3], input_info->getTensorDesc().getDims()[2]);
-	cv::resize(image, image, size);
-
-	size_t channels_number = input->getTensorDesc().getDims()[1];
-	size_t image_size = input->getTensorDesc().getDims()[3] * input->getTensorDesc().getDims()[2];
-
-	for (size_t pid = 0; pid < image_size; ++pid) {
-		for (size_t ch = 0; ch < channels_number; ++ch) {
-			//input of new model is in range -1,1 with float precision
-			input_data[ch * image_size + pid] = image.at<cv::Vec3f>(pid)[ch]*2-1;
-		}
+	if (views_submitted == 0)
+	{
+		if (viewCount < 1)
+			throw std::invalid_argument("A frame needs at least one view");
+		view_frame = frameNumber;
+		view_inputs.assign(viewCount, cv::Mat());
+		view_outputs.assign(viewCount, nullptr);
+		view_outpitches.assign(viewCount, 0);
 	}
-	// -----------------------------------------------------------------------------------------------------
+	if (viewCount != static_cast<int>(view_inputs.size()) || viewIndex < 0 || viewIndex >= viewCount)
+		throw std::invalid_argument("Invalid view index or view count");
 
-	// --------------------------- 7. Do inference --------------------------------------------------------
-	clog << "7. Do inference..." << endl;
-	/* Running the request synchronously */
-	infer_request.Infer();
-	// -----------------------------------------------------------------------------------------------------
-
-	// --------------------------- 8. Process output ------------------------------------------------------
-	clog << "8. Process output..." << endl;
-	Blob::Ptr output = infer_request.GetBlob(output_name);
-	auto output_shape = output->getTensorDesc().getDims();
-	int length = output_shape[0] * output_shape[1] * output_shape[2] * output_shape[3];
-	LockedMemory<const void> blobMapped = as<MemoryBlob>(output)->rmap();
-	float* output_data_pointer = blobMapped.as<float*>();
-	std::vector<float> output_data(output_data_pointer, output_data_pointer + length);
-
-	//output of new model is in range (0,255)
-	std::vector<uint8_t> convert_output_data;
-	convert_output_data.reserve(output_data.size());
-	for (const auto& f : output_data) {
-		convert_output_data.push_back(uint8_t(f));
-	}
-
-	//align result dimension
-	//output_data  = transpose4d(output_data, ieSizeToVector(output_shape), { 0, 3, 1, 2 });
-	int rows = output_shape[2];
-	int cols = output_shape[3];
-	if (convert_output_data.size() == rows * cols * 3) // check that the rows and cols match the size of your vector
-	{
-		//copy vector to mat
-		cv::Mat channelR(rows, cols, CV_32FC1, convert_output_data.data());
-		cv::Mat channelG(rows, cols, CV_32FC1, convert_output_data.data() + cols * rows);
-		cv::Mat channelB(rows, cols, CV_32FC1, convert_output_data.data() + 2 * cols * rows);
-		// RGB2BGR
-		std::vector<cv::Mat> channels{ channelB, channelG, channelR };
-
-		// Create the output matrix
-		merge(channels, outputImage);
+	// all views of a batch share one size
+	for (const cv::Mat& view : view_inputs)
+	{
+		if (!view.empty() && (view.cols != inwidth || view.rows != inheight))
+			throw std::invalid_argument("Views of a frame must have the same size");
 	}
-	
-	int arraysize = outputImage.rows * outputImage.cols * outputImage.channels();
-	memcpy(out, outputImage.data, arraysize * sizeof(float));
-	*w = outputImage.size().width;
-	*h = outputImage.size().height;
 
-	//cv::imwrite("test1.png", outputImage);
+	if (view_inputs[viewIndex].empty())
+		views_submitted++;
+	cv::Mat(inheight, inwidth, CV_8UC4, const_cast<unsigned char*>(input), inpitch).copyTo(view_inputs[viewIndex]);
+	view_outputs[viewIndex] = output;
+	view_outpitches[viewIndex] = outpitch;
+
+	if (views_submitted < viewCount)
+		return false;
+
+	RunViewBatch(debug_flag);
 	return true;
 }
 
 /*
- * @brief Call infer using loaded model files
- * @param filePath
- * @param modelBinFilePath
- * @param modelLabelFilePath
+ * @brief Wait until the batch of a frame ran, run it with the views submitted so far at the timeout
+ * @param frameNumber, frame passed to SubmitView
+ * @param timeoutMs, time to wait for missing views, 0 to run the batch right away
+ * @return true if the outputs of the frame are written
  */
 bool
-OpenVinoData::Infer(
-	unsigned char* inferdata, int inwidth, int inheight, unsigned char* out, bool debug_flag)
+OpenVinoData::WaitViews(long long frameNumber, int timeoutMs, bool debug_flag)
 {
-	frame_count++;
-	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
-	// --------------------------- 5. Create infer request -------------------------------------------------
-	clog << "5. Creating request..." << endl;
-	InferRequest infer_request = executable_network.CreateInferRequest();
+	std::unique_lock<std::mutex> lock(view_mutex);
+	auto completed = [this, frameNumber]() { return views_completed >= frameNumber; };
+	if (timeoutMs > 0)
+		view_done.wait_for(lock, std::chrono::milliseconds(timeoutMs), completed);
+
+	if (!completed() && views_submitted > 0 && view_frame == frameNumber)
+		RunViewBatch(debug_flag);
+	return completed();
+}
+
+/*
+ * @brief Run the pending views as one batch, missing views are padded with a submitted one; callers hold view_mutex
+ */
+void
+OpenVinoData::RunViewBatch(bool debug_flag)
+{
+	const cv::Mat* padding = nullptr;
+	for (const cv::Mat& view : view_inputs)
+	{
+		if (!view.empty())
+		{
+			padding = &view;
+			break;
+		}
+	}
 
-	// return image_file_name;
+	std::vector<const unsigned char*> inputs(view_inputs.size());
+	for (size_t i = 0; i < view_inputs.size(); i++)
+	{
+		inputs[i] = view_inputs[i].empty() ? padding->data : view_inputs[i].data;
+	}
 
-	// --------------------------- 6. Prepare input --------------------------------------------------------
-	cout << "6. Prepare input..." << endl;
+	// the views are consumed whether the batch succeeds or not
+	views_submitted = 0;
+	RunBatch(inputs.data(), static_cast<int>(inputs.size()), padding->cols, padding->rows, static_cast<int>(padding->step),
+		view_outputs.data(), view_outpitches.data(), debug_flag);
 
-	cv::Mat outputImage;
-	cv::Mat image(inheight, inwidth, CV_8UC3, inferdata);
-	image.convertTo(image, CV_32F, 1.0 / 255, 0);
-	if (debug_flag)
+	views_completed = view_frame;
+	view_done.notify_all();
+}
+
+/*
+ * @brief Register a caller owned BGRA buffer, inference reads or writes it in place when it is
+ * passed as input or output. Buffers that fail validation are not registered and keep being copied.
+ * @param data, first pixel, 64 byte aligned
+ * @param width, width of the frame
+ * @param height, height of the frame
+ * @param pitch, distance in bytes between two rows, must be width * 4
+ * @return true if the buffer is used without copies
+ */
+bool
+OpenVinoData::RegisterFrameBuffer(
+	unsigned char* data, int width, int height, int pitch)
+{
+	if (data == nullptr || width <= 0 || height <= 0)
+		throw std::invalid_argument("Invalid frame buffer");
+
+	// tensors are dense NHWC, rows on cache line boundaries keep the plugin's vector loads aligned
+	const char* reason = nullptr;
+	if (!process_in_graph)
+		reason = "host kernels convert frames outside the graph";
+	else if (tile_size > 0)
+		reason = "tiles are cut from and blended into frames on the host";
+	else if (reinterpret_cast<uintptr_t>(data) % 64 != 0)
+		reason = "data is not 64 byte aligned";
+	else if (pitch != width * 4)
+		reason = "rows are padded";
+	if (reason != nullptr)
 	{
-		cv::imwrite("input.png", image);
+		clog << "Frame buffer " << width << "x" << height << " is copied, " << reason << endl;
+		return false;
 	}
-	/*
-	cv::Mat image = cv::imread(filePath);
-	cv::cvtColor(image, image, cv::COLOR_BGRA2RGB);*/
-	
-	/* Resize manually and copy data from the image to the input blob */
-	Blob::Ptr input = infer_request.GetBlob(input_name);
-	auto input_data = input->buffer().as<PrecisionTrait<Precision::FP32>::value_type*>();
 
-	
-	auto size = cv::Size(input_info->getTensorDesc().getDims()[3], input_info->getTensorDesc().getDims()[2]);
-	cv::resize(image, image, size);
+	FrameBuffer buffer;
+	buffer.width = width;
+	buffer.height = height;
+	buffer.pitch = pitch;
+	buffer.tensor = ov::Tensor(ov::element::u8, { 1, static_cast<size_t>(height), static_cast<size_t>(width), 4 }, data);
+
+	std::lock_guard<std::mutex> lock(buffer_mutex);
+	frame_buffers[data] = buffer;
+	return true;
+}
 
-	size_t channels_number = input->getTensorDesc().getDims()[1];
-	size_t image_size = input->getTensorDesc().getDims()[3] * input->getTensorDesc().getDims()[2];
+/*
+ * @brief Forget a registered buffer, waits for the requests using it so the memory can be released afterwards
+ */
+void
+OpenVinoData::UnregisterFrameBuffer(const unsigned char* data)
+{
+	// synchronous frames and submissions use registered buffers under submit_mutex, results under result_mutex
+	std::lock_guard<std::mutex> submit_lock(submit_mutex);
+	std::lock_guard<std::mutex> result_lock(result_mutex);
+	{
+		std::lock_guard<std::mutex> lock(buffer_mutex);
+		frame_buffers.erase(data);
+	}
 
-	for (size_t pid = 0; pid < image_size; ++pid) {
-		for (size_t ch = 0; ch < channels_number; ++ch) {
-			//input of new model is in range -1,1 with float precision
-			input_data[ch * image_size + pid] = image.at<cv::Vec3f>(pid)[ch]*2-1;
+	auto uses_buffer = [data](const InferSlot& slot)
+	{
+		return data != nullptr && (slot.bound_input == data || slot.bound_output == data);
+	};
+	// no request may keep a tensor over the memory, the own tensors are bound again
+	auto release_buffer = [data](InferSlot& slot)
+	{
+		if (slot.bound_input == data)
+		{
+			slot.request.set_input_tensor(slot.own_input);
+			slot.bound_input = nullptr;
+		}
+		if (slot.bound_output == data)
+		{
+			slot.request.set_output_tensor(slot.own_output);
+			slot.bound_output = nullptr;
 		}
+	};
+
+	if (uses_buffer(cpu_slot))
+		release_buffer(cpu_slot);
+
+	std::unique_lock<std::mutex> lock(slot_mutex);
+	slot_done.wait(lock, [&]()
+		{
+			for (const InferSlot& slot : infer_slots)
+			{
+				if (slot.state == InferSlot::RUNNING && uses_buffer(slot))
+					return false;
+			}
+			return true;
+		});
+	for (InferSlot& slot : infer_slots)
+	{
+		if (!uses_buffer(slot))
+			continue;
+		// the result was written to the buffer, it can't be collected any more
+		if (slot.state == InferSlot::DONE && slot.bound_output == data && !slot.error)
+			slot.error = std::make_exception_ptr(std::logic_error("The output buffer of frame " +
+				std::to_string(slot.frame_id) + " was unregistered before the frame was collected"));
+		release_buffer(slot);
+	}
+}
+
+/*
+ * @brief Create a request and the tensors it owns
+ */
+void
+OpenVinoData::CreateSlotRequest(InferSlot& slot)
+{
+	slot.request = compiled_model.create_infer_request();
+	if (process_in_graph)
+	{
+		// the input follows the capture size, start at model resolution
+		slot.own_input = ov::Tensor(ov::element::u8, { 1, static_cast<size_t>(model_height), static_cast<size_t>(model_width), 4 });
+		slot.request.set_input_tensor(slot.own_input);
+	}
+	else
+	{
+		slot.own_input = slot.request.get_input_tensor();
 	}
-	// -----------------------------------------------------------------------------------------------------
+	slot.own_output = slot.request.get_output_tensor();
+	slot.bound_input = nullptr;
+	slot.bound_output = nullptr;
+	slot.generation = model_generation;
+}
 
-	// --------------------------- 7. Do inference --------------------------------------------------------
-	clog << "7. Do inference..." << endl;
-	/* Running the request synchronously */
-	infer_request.Infer();
-	// -----------------------------------------------------------------------------------------------------
-
-	// --------------------------- 8. Process output ------------------------------------------------------
-	clog << "8. Process output..." << endl;
-	Blob::Ptr output = infer_request.GetBlob(output_name);
-	auto output_shape = output->getTensorDesc().getDims();
-	int length = output_shape[0] * output_shape[1] * output_shape[2] * output_shape[3];
-	LockedMemory<const void> blobMapped = as<MemoryBlob>(output)->rmap();
-	float* output_data_pointer = blobMapped.as<float*>();
-	std::vector<float> output_data(output_data_pointer, output_data_pointer + length);
-
-	int rows = output_shape[2];
-	int cols = output_shape[3];
-	if (output_data.size() == rows * cols * 3){
-		cv::Mat channelR(rows, cols, CV_32FC1, output_data.data());
-		cv::Mat channelG(rows, cols, CV_32FC1, output_data.data() + cols * rows);
-		cv::Mat channelB(rows, cols, CV_32FC1, output_data.data() + 2 * cols * rows);
-		// RGB2BGR
-		std::vector<cv::Mat> channels{ channelB, channelG, channelR};
-
-		// Create the output matrix
-		merge(channels, outputImage);
-	}
-	//postprocessing
-	// normolize  (-1,1) to (0,255)
-	cv::normalize(outputImage, outputImage, 0, 255, cv::NORM_MINMAX);
-	outputImage.convertTo(outputImage, CV_8U);
-	if(debug_flag)
-	{
-		cv::imwrite("output.png", outputImage);
+/*
+ * @brief Create the request of an asynchronous slot, with the callback that completes it
+ */
+void
+OpenVinoData::CreateAsyncRequest(size_t index)
+{
+	CreateSlotRequest(infer_slots[index]);
+	infer_slots[index].request.set_callback(
+		[this, index](std::exception_ptr error)
+		{
+			pipeline_stats.Record(PipelineStage::INFER, infer_slots[index].infer_begin);
+			std::lock_guard<std::mutex> lock(slot_mutex);
+			infer_slots[index].error = error;
+			infer_slots[index].state = InferSlot::DONE;
+			slot_done.notify_all();
+		});
+}
+
+/*
+ * @brief Registered tensor over caller memory matching the frame, empty if the frame has to be copied
+ */
+ov::Tensor
+OpenVinoData::FindFrameBuffer(
+	const unsigned char* data, int width, int height, int pitch)
+{
+	std::lock_guard<std::mutex> lock(buffer_mutex);
+	auto it = frame_buffers.find(data);
+	if (it == frame_buffers.end() ||
+		it->second.width != width ||
+		it->second.height != height ||
+		it->second.pitch != pitch)
+	{
+		return ov::Tensor();
 	}
-	
-	int arraysize = outputImage.rows * outputImage.cols * outputImage.channels();
-	memcpy(out, outputImage.data, arraysize * sizeof(unsigned char));
+	return it->second.tensor;
+}
+
+/*
+ * @brief Bind a strided BGRA frame as input of a request, in place or through a copy into the own tensor
+ */
+void
+OpenVinoData::PrepareInput(
+	InferSlot& slot, const unsigned char* inferdata, int inwidth, int inheight, int inpitch, bool debug_flag,
+	std::chrono::steady_clock::time_point received)
+{
+	if (debug_flag)
+	{
+		cv::imwrite("input.png", cv::Mat(inheight, inwidth, CV_8UC4, const_cast<unsigned char*>(inferdata), inpitch));
+	}
+
+	if (!process_in_graph)
+	{
+		// the kernel reads the capture where it is
+		std::chrono::steady_clock::time_point preprocess_begin = std::chrono::steady_clock::now();
+		pipeline_stats.Record(PipelineStage::CAPTURE_HANDOFF, received, preprocess_begin);
+		preprocess_kernel.Configure(inwidth, inheight, model_width, model_height);
+		kernel_arena->Execute([&]() { preprocess_kernel.Run(inferdata, inpitch, slot.own_input.data<float>()); });
+		pipeline_stats.Record(PipelineStage::PREPROCESS, preprocess_begin);
+		return;
+	}
+
+	// the graph converts, resizes and normalizes, registered frames are read in place
+	ov::Tensor caller_tensor = FindFrameBuffer(inferdata, inwidth, inheight, inpitch);
+	if (caller_tensor)
+	{
+		slot.request.set_input_tensor(caller_tensor);
+		slot.bound_input = inferdata;
+		pipeline_stats.Record(PipelineStage::CAPTURE_HANDOFF, received);
+		return;
+	}
+
+	if (slot.bound_input != nullptr)
+	{
+		slot.request.set_input_tensor(slot.own_input);
+		slot.bound_input = nullptr;
+	}
+	// the tensor keeps its allocation while the capture size does not grow
+	slot.own_input.set_shape({ 1, static_cast<size_t>(inheight), static_cast<size_t>(inwidth), 4 });
+	unsigned char* input_data = slot.own_input.data<uint8_t>();
+	size_t row_size = static_cast<size_t>(inwidth) * 4;
+	for (int y = 0; y < inheight; y++)
+	{
+		memcpy(input_data + y * row_size, inferdata + static_cast<size_t>(y) * inpitch, row_size);
+	}
+	pipeline_stats.Record(PipelineStage::CAPTURE_HANDOFF, received);
+}
+
+/*
+ * @brief Bind the caller's output buffer to a request when it is registered, otherwise the own tensor
+ */
+void
+OpenVinoData::BindOutput(
+	InferSlot& slot, unsigned char* out, int outpitch)
+{
+	ov::Tensor caller_tensor;
+	if (process_in_graph && out != nullptr)
+		caller_tensor = FindFrameBuffer(out, model_width, model_height, outpitch);
+
+	if (caller_tensor)
+	{
+		slot.request.set_output_tensor(caller_tensor);
+		slot.bound_output = out;
+	}
+	else if (slot.bound_output != nullptr)
+	{
+		slot.request.set_output_tensor(slot.own_output);
+		slot.bound_output = nullptr;
+	}
+}
+
+/*
+ * @brief Write the output of a request into strided BGRA rows, nothing to do when it was written in place
+ */
+void
+OpenVinoData::ReadOutput(
+	InferSlot& slot, unsigned char* out, int outpitch, bool debug_flag)
+{
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	if (slot.bound_output != nullptr)
+	{
+		// the result already is in the buffer bound at submission
+		if (out == nullptr || out == slot.bound_output)
+		{
+			out = slot.bound_output;
+			outpitch = model_width * 4;
+			pipeline_stats.Record(PipelineStage::OUTPUT_COPY, 0.0);
+		}
+		else
+		{
+			cv::Mat result(model_height, model_width, CV_8UC4, slot.bound_output);
+			cv::Mat out_image(model_height, model_width, CV_8UC4, out, outpitch);
+			result.copyTo(out_image);
+			pipeline_stats.Record(PipelineStage::OUTPUT_COPY, begin);
+		}
+	}
+	else if (out == nullptr)
+	{
+		throw std::invalid_argument("Output buffer is null and the frame was not submitted with one");
+	}
+	else if (process_in_graph)
+	{
+		// 8 bit BGRA pixels come out of the graph, copy them into the caller's rows
+		cv::Mat result(model_height, model_width, CV_8UC4, slot.own_output.data<uint8_t>());
+		cv::Mat out_image(model_height, model_width, CV_8UC4, out, outpitch);
+		result.copyTo(out_image);
+		pipeline_stats.Record(PipelineStage::OUTPUT_COPY, begin);
+	}
+	else
+	{
+		// the kernel writes the caller's rows directly
+		kernel_arena->Execute([&]() { postprocess_kernel.Run(slot.own_output.data<const float>(), model_width, model_height, out, outpitch); });
+		pipeline_stats.Record(PipelineStage::POSTPROCESS, begin);
+	}
+	if (debug_flag)
+	{
+		cv::imwrite("output.png", cv::Mat(model_height, model_width, CV_8UC4, out, outpitch));
+	}
+}
 
+/*
+ * @brief Account one delivered frame in the running averages and the periodic performance log
+ */
+void
+OpenVinoData::LogFrameTime(std::chrono::steady_clock::time_point begin)
+{
 	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-	total_inference_time += static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count());
+	double latency = std::chrono::duration<double, std::milli>(end - begin).count();
+	const double smoothing = 0.05;
+	if (latency_average == 0.0)
+	{
+		latency_average = latency;
+	}
+	else
+	{
+		double interval = std::chrono::duration<double, std::milli>(end - last_delivery).count();
+		delivery_interval = delivery_interval == 0.0 ? interval : delivery_interval + smoothing * (interval - delivery_interval);
+		latency_average += smoothing * (latency - latency_average);
+	}
+	last_delivery = end;
+
+	if (frame_count == 0)
+		window_begin = begin;
+	total_inference_time += latency;
+	frame_count++;
 	if (frame_count == 100)
 	{
-		logfile_mode << "Style transfer takes " << total_inference_time / frame_count << "ms\n";
+		double window = std::chrono::duration<double>(end - window_begin).count();
+		logfile_mode << "Style transfer takes " << total_inference_time / frame_count << "ms, "
+			<< frame_count / window << " fps\n";
 		total_inference_time = 0.0;
 		frame_count = 0;
 	}
-	//cv::imwrite("test1.png", outputImage);
-	return true;
+}
+
+/*
+ * @brief Achieved throughput and latency of delivered frames, running averages
+ * @param fps, delivered frames per second
+ * @param latencyMs, time from submission (or call) to delivery of a frame
+ * @param framesInFlight, frames submitted and not yet delivered
+ */
+void
+OpenVinoData::GetThroughputStats(double* fps, double* latencyMs, int* framesInFlight)
+{
+	{
+		std::lock_guard<std::mutex> result_lock(result_mutex);
+		*fps = delivery_interval > 0.0 ? 1000.0 / delivery_interval : 0.0;
+		*latencyMs = latency_average;
+	}
+	std::lock_guard<std::mutex> lock(slot_mutex);
+	*framesInFlight = 0;
+	for (const InferSlot& slot : infer_slots)
+	{
+		if (slot.state != InferSlot::FREE)
+			(*framesInFlight)++;
+	}
+}
+
+/*
+ * @brief Stage times over the recent frames, model load time and model cache use
+ */
+PipelineSnapshot
+OpenVinoData::GetStats() const
+{
+	return pipeline_stats.Snapshot();
+}
+
+/*
+ * @brief Bytes of the input and output tensors of all infer requests
+ */
+size_t
+OpenVinoData::RequestMemory()
+{
+	auto tensors_size = [](ov::InferRequest& request)
+	{
+		return request.get_input_tensor().get_byte_size() + request.get_output_tensor().get_byte_size();
+	};
+
+	size_t bytes = 0;
+	if (cpu_slot.request)
+		bytes += tensors_size(cpu_slot.request);
+	std::lock_guard<std::mutex> lock(slot_mutex);
+	for (InferSlot& slot : infer_slots)
+	{
+		if (slot.request)
+			bytes += tensors_size(slot.request);
+	}
+	for (ov::InferRequest& request : tile_requests)
+	{
+		bytes += tensors_size(request);
+	}
+	return bytes;
+}
+
+/*
+ * @brief Block until no asynchronous request is running
+ */
+void
+OpenVinoData::WaitAllSlots()
+{
+	std::unique_lock<std::mutex> lock(slot_mutex);
+	slot_done.wait(lock, [this]()
+		{
+			for (const InferSlot& slot : infer_slots)
+			{
+				if (slot.state == InferSlot::RUNNING)
+					return false;
+			}
+			return true;
+		});
 }
 
 bool OpenVinoData::Create_OCLCtx(ID3D11Device* d3dDevice)
@@ -330,11 +1846,13 @@ bool OpenVinoData::Create_OCLCtx(ID3D11Device* d3dDevice)
 	 * @param ctx
 	 * @param inferWidth
 	 * @param inferHeight
+	 * @param config, only its OpenVINO properties apply to the OpenCL path
 	 */
 void OpenVinoData::Initialize_BaseOCL(
 	std::string modelXmlFilePath,
 	int inferWidth,
-	int inferHeight)
+	int inferHeight,
+	const InferenceConfig& config)
 {
 	D3D11_TEXTURE2D_DESC desc_ovrgba_copy;
 
@@ -355,67 +1873,59 @@ void OpenVinoData::Initialize_BaseOCL(
 		throw std::runtime_error("Can't create DX texture");
 	}
 
-	logfile_mode.open(logFolder + "\\mode_ocl_gpu.txt", std::ios::binary);
+	OpenLog("mode_ocl_gpu_" + std::to_string(inferWidth) + "x" + std::to_string(inferHeight));
 
 	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
-	//1) Reading network 
-	ov::Core core;
-	core.set_property(ov::cache_dir(gpuCacheFolder));
-	auto model = core.read_model(modelXmlFilePath);
-
-	ov::preprocess::PrePostProcessor ppp(model);
-	// 2)Setting input info
-	ppp.input().tensor().
-		set_layout("NCHW").
-		set_element_type(ov::element::u8).
-		set_color_format(ov::preprocess::ColorFormat::RGB).
-		//set_shape({ 1,3,480,640}).
-		set_memory_type(ov::intel_gpu::memory_type::buffer);
-
-	// 3)Adding explicit preprocessing steps:
-	ppp.input().preprocess()
-		//.convert_color(ov::preprocess::ColorFormat::RGB)
-		//.convert_layout("NCHW")
-		//.resize(ov::preprocess::ResizeAlgorithm::RESIZE_LINEAR)
-		.convert_element_type(ov::element::f16)
-		.mean(127.5)
-		.scale(127.5);
-
-	ppp.input().model().set_layout("NCHW");
-
-	//ppp.output().postprocess().convert_element_type(ov::element::f16);
-	// 4)Setting output info
-	ppp.output().tensor()
-		.set_element_type(ov::element::f16);
-
-	model = ppp.build();
-
-	// 5) reshape mode input
+	//1) Reading network with pre/post processing baked in
+	model_io = ModelIO();
+	model_io.input = ModelInput::PLANAR_U8;
+	model_io.output = ModelOutput::RGBA_U8;
+	model_io.width = inferWidth;
+	model_io.height = inferHeight;
+	model_io.gpu_buffers = true;
 	input_shape = { 1,3,static_cast<size_t>(inferHeight), static_cast<size_t>(inferWidth) };
-	model->reshape(input_shape);
+	model_width = inferWidth;
+	model_height = inferHeight;
+	model_xml_path = modelXmlFilePath;
+	device_name.clear();
+	{
+		std::lock_guard<std::mutex> lock(compile_mutex);
+		inference_config = config;
+	}
 
-	// 6)Loading model to the device -------------------------------------------
-	auto remote_context = ov::intel_gpu::ocl::ClContext(core, oclEnv->GetContext());
+	// 2)Loading model to the device -------------------------------------------
 	_oclCtx = oclEnv->GetContext();
-	compiled_model = core.compile_model(model, remote_context); 
+	compiled_model = CompileModel(config, model_io);
 	//ov::serialize(compiled_model.get_runtime_model(), "test_graph.xml");
-	// 7)Creating infer request ------------------------------------------------
-	infer_request = compiled_model.create_infer_request();
 
-	// 8)Create input and output GPU Blobs
+	// 3)Create input and output GPU Blobs, the output holds RGBA8 pixels ready for the texture
 	_inputBuffer = cl::Buffer(_oclCtx, CL_MEM_READ_WRITE, input_shape[1] * input_shape[2] * input_shape[3] * sizeof(uint8_t), NULL, NULL);
-	_outputBuffer = cl::Buffer(_oclCtx, CL_MEM_READ_WRITE, input_shape[1] * input_shape[2] * input_shape[3] * sizeof(cl_half), NULL, NULL);
-	auto shared_in_blob = remote_context.create_tensor(ov::element::u8, input_shape, _inputBuffer);
-	auto shared_output_blob = remote_context.create_tensor(ov::element::f16, input_shape, _outputBuffer);  //style transfer output has the same shape with input
-	infer_request.set_input_tensor(shared_in_blob);
-	infer_request.set_output_tensor(shared_output_blob);
+	_outputBuffer = cl::Buffer(_oclCtx, CL_MEM_READ_WRITE, input_shape[2] * input_shape[3] * 4 * sizeof(uint8_t), NULL, NULL);
+
+	// 4)Creating infer request ------------------------------------------------
+	CreateOCLRequest();
 
 	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
 	loading_time = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count());
 	logfile_mode << "model input size:" << inferWidth << "," << inferHeight <<"\n";
+	for (const auto& property : config.properties)
+		logfile_mode << property.first << ":" << property.second << "\n";
 	logfile_mode << "Loading model takes:" << loading_time << "ms\n";
 }
 
+/*
+ * @brief Create the request of the OpenCL path, bound to the shared input and output buffers
+ */
+void
+OpenVinoData::CreateOCLRequest()
+{
+	auto remote_context = compiled_model.get_context().as<ov::intel_gpu::ocl::ClContext>();
+	ov::Shape output_shape = { 1, input_shape[2], input_shape[3], 4 };
+	infer_request = compiled_model.create_infer_request();
+	infer_request.set_input_tensor(remote_context.create_tensor(ov::element::u8, input_shape, _inputBuffer));
+	infer_request.set_output_tensor(remote_context.create_tensor(ov::element::u8, output_shape, _outputBuffer));
+}
+
 
 /**
  * @brief Call infer using DirectX Texture2D RGBA
@@ -433,8 +1943,12 @@ bool OpenVinoData::Infer(
 	int surfaceHeight,
 	bool debug_flag)
 {
+	std::chrono::steady_clock::time_point received = std::chrono::steady_clock::now();
+	// a recompiled model is swapped in between two frames
+	std::lock_guard<std::mutex> submit_lock(submit_mutex);
 	frame_count++;
 	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	pipeline_stats.Record(PipelineStage::CAPTURE_HANDOFF, received, begin);
 	if (input_shape[2] != surfaceHeight ||
 		input_shape[3] != surfaceWidth)
 	{
@@ -449,14 +1963,16 @@ bool OpenVinoData::Infer(
 		return false;
 	}
 
+	std::chrono::steady_clock::time_point infer_begin = std::chrono::steady_clock::now();
+	pipeline_stats.Record(PipelineStage::PREPROCESS, begin, infer_begin);
 	infer_request.infer();
 
-	if (!srcConversionKernel->SetArgumentsRGBbuffertoRGBA(_outputBuffer.get(), output_surface, surfaceWidth, surfaceHeight)) {
-		return false;
-	}
-	if (!srcConversionKernel->Run()) {
+	std::chrono::steady_clock::time_point copy_begin = std::chrono::steady_clock::now();
+	pipeline_stats.Record(PipelineStage::INFER, infer_begin, copy_begin);
+	if (!srcConversionKernel->CopyRGBAbufferToSurface(_outputBuffer.get(), output_surface, surfaceWidth, surfaceHeight)) {
 		return false;
 	}
+	pipeline_stats.Record(PipelineStage::OUTPUT_COPY, copy_begin);
 
 	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
 	total_inference_time += static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count());
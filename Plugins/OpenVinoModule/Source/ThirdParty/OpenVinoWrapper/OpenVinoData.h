@@ -23,28 +23,209 @@ embedded in Materials by Intel or Intel's suppliers or licensors in any way."
 
 #include <string>
 #include <fstream>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <exception>
+#include <map>
+#include <thread>
+#include <atomic>
 #include <d3d11.h>
-#include <ie/inference_engine.hpp>
+#include <opencv2/core.hpp>
 #include "openvino/openvino.hpp"
 #include "openvino/runtime/intel_gpu/properties.hpp"
 #include "openvino/runtime/intel_gpu/ocl/ocl.hpp"
 #include "OpenCLUtil.h"
+#include "ImageKernels.h"
+#include "ModelBuilder.h"
+#include "PipelineStats.h"
+#include "CpuAffinity.h"
+
+/**
+ * @struct InferenceConfig
+ * @brief How the model is compiled and scheduled, applied by OpenVinoData::Initialize
+ */
+struct InferenceConfig
+{
+	// convert frames inside the compiled graph, false for the fused host kernels
+	bool process_in_graph = true;
+	// run the model on tiles of this size at model resolution, 0 for whole frames
+	int tile_size = 0;
+	// pixels of context around each tile, negative to use the receptive field of the model
+	int tile_halo = -1;
+	// CPU streams of the throughput scheduler, 0 compiles for latency
+	int streams = 0;
+	// frames that may be in flight, 0 for one per stream (two in latency mode)
+	int queue_depth = 0;
+	// cores CPU inference runs on, see CoreSet::Parse, empty for all of them
+	std::string core_set;
+	// OpenVINO properties by name and string value (see OpenVinoData::IsTunableProperty), they
+	// override the settings above
+	std::map<std::string, std::string> properties;
+
+	bool operator==(const InferenceConfig& other) const
+	{
+		return process_in_graph == other.process_in_graph &&
+			tile_size == other.tile_size &&
+			tile_halo == other.tile_halo &&
+			streams == other.streams &&
+			queue_depth == other.queue_depth &&
+			core_set == other.core_set &&
+			properties == other.properties;
+	}
+};
+
 /**
  * @class OpenVinoData
  * @brief This class handles actual process of initialization and calls to infer and parsing of results
  */
 class OpenVinoData
 {
-	// Data describing input of OpenVino algorithm
-	InferenceEngine::InputInfo::Ptr input_info;
-	// Loaded executable nerual network
-	InferenceEngine::ExecutableNetwork executable_network;
-	// Input and output names for OpenVino algorithm
-	std::string input_name, output_name;
-
-	// varibales for ov2.0 
-	ov::InferRequest      infer_request;
+	// Loaded model, and the infer request of the OpenCL path
 	ov::CompiledModel     compiled_model;
+	ov::InferRequest      infer_request;
+	// Model resolution
+	int model_width;
+	int model_height;
+	// CPU path converts frames inside the compiled graph (u8 BGRA tensors) instead of the fused host kernels (f32 planar tensors)
+	bool process_in_graph;
+
+	// Tiled inference: the model runs on windows of tile_size + 2 * tile_halo pixels, 0 runs whole frames
+	int tile_size;
+	int tile_halo;
+	// Requests running tiles on parallel CPU streams
+	std::vector<ov::InferRequest> tile_requests;
+	cv::Mat tile_source;    // frame resized to model resolution
+	cv::Mat tile_strip;     // one row of tiles, blended horizontally before it is blended into the output
+	// Tiles whose window differs less than dirty_tile_threshold from when they were last inferred keep their result, 0 runs all tiles
+	std::atomic<float> dirty_tile_threshold;
+	ChangeDetector tile_detector;
+	std::vector<cv::Mat> tile_results;  // last result of every tile
+	std::vector<cv::Mat> tile_strips;   // every row of tiles, blended horizontally
+	cv::Mat tile_output;                // frame composed of the strips, rows are composed again when a tile of theirs changes
+
+	// Scratch images of the BGR entry points, (re)allocated only when a size changes
+	cv::Mat bgra_image;     // BGR input widened to BGRA
+	cv::Mat result_image;   // BGRA result before it is narrowed to BGR
+	// Fused resize/normalize/planarize of captured BGRA frames
+	PreprocessKernel preprocess_kernel;
+	// Fused planar float to BGRA8 conversion of the model output
+	PostprocessKernel postprocess_kernel;
+	// Cores of the CPU path, the kernels run in an arena on them
+	CoreSet core_set;
+	std::unique_ptr<KernelArena> kernel_arena;
+	// Core set the TBB workers were pinned for by this session, released with it
+	CoreSet pinned_core_set;
+	bool workers_pinned;
+	// Frames that differ less than change_threshold from the last inferred one get its result again, 0 disables it
+	std::atomic<float> change_threshold;
+	ChangeDetector change_detector;
+	std::vector<unsigned char> unchanged_output;
+	// Result at model resolution before it is rescaled to the output by InferBGRAScaled
+	cv::Mat scaled_output;
+	std::mutex scale_mutex;
+	// Latency of the last InferBGRA call in ms, 0 if it did not run the model
+	std::atomic<double> last_inference_ms;
+
+	/**
+	 * @struct InferSlot
+	 * @brief One infer request, the tensors it owns and the frame it is working on
+	 */
+	struct InferSlot
+	{
+		enum State
+		{
+			FREE = 0,
+			RUNNING,
+			DONE,
+		};
+
+		ov::InferRequest request;
+		// tensors allocated with the request, bound whenever a frame can't use caller memory
+		ov::Tensor own_input;
+		ov::Tensor own_output;
+		// caller buffers currently bound instead, nullptr while the own tensors are bound
+		const unsigned char* bound_input = nullptr;
+		unsigned char* bound_output = nullptr;
+		long long frame_id = -1;
+		// submission order, results are delivered strictly in it
+		unsigned long long sequence = 0;
+		// compiled model the request was created from, see model_generation
+		unsigned int generation = 0;
+		State state = FREE;
+		std::exception_ptr error;
+		std::chrono::steady_clock::time_point submit_time;
+		// start of the inference, its completion callback records the infer stage
+		std::chrono::steady_clock::time_point infer_begin;
+	};
+
+	// Request of the synchronous CPU calls
+	InferSlot cpu_slot;
+	// Pool of asynchronous infer requests, one per frame in flight
+	std::vector<InferSlot> infer_slots;
+	unsigned long long submit_sequence;
+	// Guards slot states, signalled by the completion callbacks
+	std::mutex slot_mutex;
+	std::condition_variable slot_done;
+	// Serialize the preprocessing and postprocessing scratch state between caller threads
+	std::mutex submit_mutex;
+	std::mutex result_mutex;
+
+	// What the model is compiled from, kept to compile it again when properties change
+	InferenceConfig inference_config;
+	std::string model_xml_path;
+	std::string device_name;    // empty on the OpenCL path
+	ModelIO model_io;
+	// Bumped by every swap of compiled_model, asynchronous requests of an older model are recreated when their slot is reused
+	unsigned int model_generation;
+	/**
+	 * @struct BatchModel
+	 * @brief The model compiled for a batch of same-sized frames, with its request
+	 */
+	struct BatchModel
+	{
+		ov::CompiledModel model;
+		ov::InferRequest request;
+		// frames keep their size and are resized in the graph, otherwise on the host
+		bool resize_in_graph = false;
+	};
+	// Batched models by batch size, compiled on first use and dropped when properties change
+	std::map<int, BatchModel> batch_models;
+
+	// Views of one frame coalesced into one batch, see SubmitView
+	std::mutex view_mutex;
+	std::condition_variable view_done;
+	long long view_frame;                     // frame the pending views belong to
+	int views_submitted;                      // pending views, 0 when no batch is being collected
+	long long views_completed;                // last frame whose batch ran
+	std::vector<cv::Mat> view_inputs;         // copies of the pending views, empty for views not submitted
+	std::vector<unsigned char*> view_outputs;
+	std::vector<int> view_outpitches;
+
+	// Background recompilation after a property change, the latest properties win
+	std::thread compile_thread;
+	std::mutex compile_mutex;
+	bool compile_running;
+	bool compile_pending;
+
+	/**
+	 * @struct FrameBuffer
+	 * @brief Caller owned BGRA frame that passed validation, wrapped once as a tensor over its memory
+	 */
+	struct FrameBuffer
+	{
+		int width;
+		int height;
+		int pitch;
+		ov::Tensor tensor;
+	};
+
+	// Registered caller buffers by address
+	std::map<const unsigned char*, FrameBuffer> frame_buffers;
+	std::mutex buffer_mutex;
+
+	// opencl buffers shared with the compiled model
 	cl::Buffer            _inputBuffer;
 	cl::Buffer            _outputBuffer;
 	cl::Context           _oclCtx;
@@ -63,21 +244,54 @@ class OpenVinoData
 	double total_inference_time;
 	double loading_time;
 	int frame_count;
+	std::chrono::steady_clock::time_point window_begin;
+	// running averages of frame latency and of the time between two delivered frames
+	double latency_average;
+	double delivery_interval;
+	std::chrono::steady_clock::time_point last_delivery;
 	std::ofstream logfile_mode;
-	std::string gpuCacheFolder;
+	// Name of logfile_mode, unique among the live sessions
+	std::string log_name;
+	// Live stage times and model loads, read through GetStats
+	PipelineStats pipeline_stats;
 	std::string logFolder;
 
 public:
 	OpenVinoData()
 	{
+		model_width = 0;
+		model_height = 0;
+		process_in_graph = true;
+		tile_size = 0;
+		tile_halo = 0;
+		submit_sequence = 0;
+		model_generation = 0;
+		change_threshold = 0.0f;
+		dirty_tile_threshold = 0.0f;
+		last_inference_ms = 0.0;
+		kernel_arena = std::make_unique<KernelArena>(core_set);
+		workers_pinned = false;
+		compile_running = false;
+		compile_pending = false;
+		view_frame = -1;
+		views_submitted = 0;
+		views_completed = -1;
 		frame_count = 0;
 		total_inference_time = 0.0;
-		gpuCacheFolder = CreateCacheDir("ovgpu_cache");
+		latency_average = 0.0;
+		delivery_interval = 0.0;
 		logFolder = CreateCacheDir("log");
 	};
 	virtual ~OpenVinoData()
 	{
-		logfile_mode.close();
+		// a recompilation in progress swaps into this object, let it finish
+		if (compile_thread.joinable())
+			compile_thread.join();
+		// completion callbacks reference this object, drain them before anything is destroyed
+		WaitAllSlots();
+		if (workers_pinned)
+			CoreSet::ReleaseTbbWorkers(pinned_core_set);
+		CloseLog();
 	};
 
 public:
@@ -85,22 +299,38 @@ public:
 	 * @brief Initialize OpenVino with passed model files
 	 * @param modelXmlFilePath
 	 * @param modelBinFilePath
-	 * @param modelLabelFilePath
+	 * @param inferWidth
+	 * @param inferHeight
+	 * @param devicename
+	 * @param config, compilation and scheduling of the CPU path
 	 */
 	void Initialize(
 		std::string modelXmlFilePath,
 		std::string modelBinFilePath,
 		int inferWidth,
 		int inferHeight,
-		std::string devicename);
+		std::string devicename,
+		const InferenceConfig& config = InferenceConfig());
+
+	/**
+	 * @brief Compile the model "Initialize" would load with the same arguments into the compiled model
+	 * cache, or find it there. Creates no infer requests and no log file and leaves the TBB workers where
+	 * they are; the object can not infer afterwards.
+	 * @param devicename, OpenVINO device; the OpenCL path is not supported, it needs the Direct3D device
+	 */
+	void Precompile(
+		const std::string& modelXmlFilePath,
+		int inferWidth,
+		int inferHeight,
+		const std::string& devicename,
+		const InferenceConfig& config);
 
 	/**
 	 * @brief Call infer using loaded model files
 	 * @param filePath
 	 * @param width of image after style transfer
 	 * @param height of image after style transfer
-	 * @param height of image after style transfer
-	 * @param out, image raw data after style transfer
+	 * @param out, BGR float image raw data after style transfer, in range (0,255)
 	 */
 	bool
 		OpenVinoData::Infer(
@@ -125,6 +355,232 @@ public:
 			bool debug_flag);
 
 
+	/**
+	 * @brief Call infer using a BGRA frame as captured by the engine
+	 * @param input, BGRA image raw data
+	 * @param inwidth, width of image
+	 * @param inheight, height of image
+	 * @param inpitch, distance in bytes between two rows of input
+	 * @param output, BGRA image raw data after style transfer
+	 * @param outpitch, distance in bytes between two rows of output
+	 */
+	bool InferBGRA(
+		const unsigned char* input,
+		int inwidth,
+		int inheight,
+		int inpitch,
+		unsigned char* output,
+		int outpitch,
+		bool debug_flag);
+
+	/**
+	 * @brief Call infer using a BGRA frame as captured by the engine, and rescale the result from model
+	 * resolution to an output of another size, e.g. when a lower resolution holds the frame time budget
+	 * @param outwidth, width of the output
+	 * @param outheight, height of the output
+	 */
+	bool InferBGRAScaled(
+		const unsigned char* input,
+		int inwidth,
+		int inheight,
+		int inpitch,
+		unsigned char* output,
+		int outwidth,
+		int outheight,
+		int outpitch,
+		bool debug_flag);
+
+	/**
+	 * @brief Latency of the last "InferBGRA" call in ms, 0 if it answered with a previous result instead of running the model
+	 */
+	double LastInferenceMs() const { return last_inference_ms.load(std::memory_order_relaxed); }
+
+	/**
+	 * @brief Run one mid-gray frame at model resolution, so the first captured frame does not pay for
+	 * lazy allocations and kernel selection. Warm-up frames are not part of the statistics.
+	 */
+	void WarmUpFrame();
+
+	/**
+	 * @brief Choose how model output values are mapped onto (0,255) in BGRA results, only used by the host kernels
+	 * @param runningRange, false for the fixed (-1,1) range, true to follow a running min/max estimate,
+	 * rejected when the graph processes frames
+	 */
+	void SetRunningOutputRange(bool runningRange);
+
+	/**
+	 * @brief Skip the inference of frames that barely differ from the last inferred frame and return its
+	 * result again, for still cameras in menus, pauses and cutscene holds. Applies to "InferBGRA".
+	 * @param threshold, mean absolute luma difference in (0,255) below which a frame counts as unchanged, 0 to infer every frame
+	 */
+	void SetChangeThreshold(float threshold);
+	float ChangeThreshold() const { return change_threshold.load(std::memory_order_relaxed); }
+
+	/**
+	 * @brief Run only the tiles whose window, halo included, changed since they were last inferred; the
+	 * other tiles keep their result and the frame is composed of all of them with the usual seam blending.
+	 * Needs tiled inference.
+	 * @param threshold, mean absolute luma difference in (0,255) of a window below which its tile counts as unchanged, 0 to run all tiles
+	 */
+	void SetDirtyTileThreshold(float threshold);
+	float DirtyTileThreshold() const { return dirty_tile_threshold.load(std::memory_order_relaxed); }
+
+	/**
+	 * @brief (Re)create the pool of asynchronous infer requests
+	 * @param framesInFlight, number of frames that may be submitted before a result is collected
+	 */
+	void SetFramesInFlight(int framesInFlight);
+
+	/**
+	 * @brief Register a caller owned BGRA buffer, inference reads or writes it in place when it is
+	 * passed as input or output. Buffers that fail validation are not registered and keep being copied.
+	 * @param data, first pixel, 64 byte aligned
+	 * @param width, width of the frame
+	 * @param height, height of the frame
+	 * @param pitch, distance in bytes between two rows, must be width * 4
+	 * @return true if the buffer is used without copies
+	 */
+	bool RegisterFrameBuffer(
+		unsigned char* data,
+		int width,
+		int height,
+		int pitch);
+
+	/**
+	 * @brief Forget a registered buffer, waits for the requests using it so the memory can be released afterwards.
+	 * A finished frame whose result is in the buffer is collected as an error.
+	 */
+	void UnregisterFrameBuffer(const unsigned char* data);
+
+	/**
+	 * @brief Preprocess a frame and start its inference asynchronously
+	 * @param input, BGRA image raw data
+	 * @param inwidth, width of image
+	 * @param inheight, height of image
+	 * @param inpitch, distance in bytes between two rows of input
+	 * @param frameId, caller defined tag returned with the result
+	 * @param output, optional registered buffer the result is written to in place
+	 * @param outpitch, distance in bytes between two rows of output
+	 * @return false if all requests are in flight and no frame was submitted
+	 */
+	bool SubmitFrame(
+		const unsigned char* input,
+		int inwidth,
+		int inheight,
+		int inpitch,
+		long long frameId,
+		bool debug_flag,
+		unsigned char* output = nullptr,
+		int outpitch = 0);
+
+	/**
+	 * @brief Collect the next frame in submission order, once it finished
+	 * @param output, BGRA image raw data after style transfer, may be nullptr if the frame was submitted with an output buffer
+	 * @param outpitch, distance in bytes between two rows of output
+	 * @param frameId, tag of the collected frame, -1 if the next frame did not finish in time or none is in flight
+	 * @param timeoutMs, 0 to poll, negative to wait until the next frame finishes
+	 */
+	void GetResult(
+		unsigned char* output,
+		int outpitch,
+		long long* frameId,
+		int timeoutMs,
+		bool debug_flag);
+
+	/**
+	 * @brief Achieved throughput and latency of delivered frames, running averages
+	 * @param fps, delivered frames per second
+	 * @param latencyMs, time from submission (or call) to delivery of a frame
+	 * @param framesInFlight, frames submitted and not yet delivered
+	 */
+	void GetThroughputStats(
+		double* fps,
+		double* latencyMs,
+		int* framesInFlight);
+
+	/**
+	 * @brief Min, mean, 95th percentile and max time of each pipeline stage over the recent frames,
+	 * model load time and model cache hits and misses. Does not wait for running inferences.
+	 */
+	PipelineSnapshot GetStats() const;
+
+	/**
+	 * @brief Bytes of the input and output tensors of all infer requests, call it while no frame is in flight
+	 */
+	size_t RequestMemory();
+
+	/**
+	 * @brief Size of the compiled model cache shared by all sessions before the least recently used
+	 * models are evicted, 0 disables the cache
+	 */
+	static void SetModelCacheLimit(uint64_t bytes);
+
+	/**
+	 * @brief Create the OpenVINO core and compiled model cache all sessions share, if they don't exist yet.
+	 * Statics created afterwards are destroyed before them, e.g. the owners of threads loading sessions.
+	 */
+	static void CreateSharedRuntime();
+
+	/**
+	 * @brief Full name and capabilities of an OpenVINO device, with the OpenVINO version; compiled models
+	 * and measurements on one machine are only valid for the same description
+	 */
+	static std::string DeviceDescription(const std::string& device);
+
+	/**
+	 * @brief Call infer on a batch of same-sized BGRA frames, e.g. the views of a stereo or split-screen
+	 * frame, in one inference. The model is compiled for each batch size on first use.
+	 * @param inputs, BGRA image raw data of each frame
+	 * @param count, number of frames
+	 * @param inwidth, width of the frames
+	 * @param inheight, height of the frames
+	 * @param inpitch, distance in bytes between two rows of each input
+	 * @param outputs, BGRA image raw data after style transfer of each frame, nullptr to drop a result
+	 * @param outpitch, distance in bytes between two rows of each output
+	 */
+	void InferBatch(
+		const unsigned char* const* inputs,
+		int count,
+		int inwidth,
+		int inheight,
+		int inpitch,
+		unsigned char* const* outputs,
+		int outpitch,
+		bool debug_flag);
+
+	/**
+	 * @brief Add one view of a frame to the batch of that frame. The batch runs as soon as all views of
+	 * the frame are submitted, or when a view of a later frame arrives first. The input is copied, the
+	 * output is written when the batch runs.
+	 * @param frameNumber, frame the view belongs to, increasing
+	 * @param viewIndex, index of the view within the frame
+	 * @param viewCount, number of views of the frame
+	 * @return true if this call ran the batch and all outputs of the frame are written
+	 */
+	bool SubmitView(
+		long long frameNumber,
+		int viewIndex,
+		int viewCount,
+		const unsigned char* input,
+		int inwidth,
+		int inheight,
+		int inpitch,
+		unsigned char* output,
+		int outpitch,
+		bool debug_flag);
+
+	/**
+	 * @brief Wait until the batch of a frame ran; when the views of the frame are still incomplete at
+	 * the timeout, the batch runs with the views submitted so far
+	 * @param frameNumber, frame passed to SubmitView
+	 * @param timeoutMs, time to wait for missing views, 0 to run the batch right away
+	 * @return true if the outputs of the frame are written
+	 */
+	bool WaitViews(
+		long long frameNumber,
+		int timeoutMs,
+		bool debug_flag);
+
 	/**
 	 *Create OCL Context and Kernel
 	 */
@@ -136,11 +592,13 @@ public:
 	 * @param ctx
 	 * @param inferWidth
 	 * @param inferHeight
+	 * @param config, only its OpenVINO properties apply to the OpenCL path
 	 */
 	void Initialize_BaseOCL(
 		std::string modelXmlFilePath,
 		int inferWidth,
-		int inferHeight);
+		int inferHeight,
+		const InferenceConfig& config = InferenceConfig());
 
 	/**
 	 * @brief Call infer using DirectX Texture2D RGBA
@@ -157,4 +615,87 @@ public:
 		int surfaceHeight,
 		bool debug_flag);
 
+	/**
+	 * @brief OpenVINO properties that can be tuned at runtime: PERFORMANCE_HINT, NUM_STREAMS,
+	 * INFERENCE_NUM_THREADS, INFERENCE_PRECISION_HINT, AFFINITY and PERFORMANCE_HINT_NUM_REQUESTS
+	 */
+	static bool IsTunableProperty(const std::string& name);
+
+	/**
+	 * @brief Change an OpenVINO property of the loaded model. The model is compiled again in the
+	 * background and swapped in between two frames; it keeps running with the old properties until
+	 * then, and for good if the new ones fail to compile.
+	 * @param name, one of the tunable properties
+	 * @param value, string form of the value, empty to go back to the plugin default
+	 */
+	void SetProperty(
+		const std::string& name,
+		const std::string& value);
+
+	/**
+	 * @brief Value of an OpenVINO property as the compiled model applies it, or as requested if the
+	 * plugin does not report it
+	 * @param name, one of the tunable properties
+	 */
+	std::string GetProperty(
+		const std::string& name);
+
+private:
+	// Open the log of the session as "<base>.txt", or "<base>_2.txt" and so on while another session writes to it
+	void OpenLog(const std::string& base);
+	// Close the log and hand its name back
+	void CloseLog();
+	// Model input and output, tiles and core set for a resolution and device, what the compiled model depends on
+	void ConfigureModel(const std::string& modelXmlFilePath, int inferWidth, int inferHeight,
+		const std::string& devicename, const InferenceConfig& config);
+	// Properties the model is compiled with: the scheduling settings of the config, overridden by its OpenVINO properties
+	ov::AnyMap CompileProperties(const InferenceConfig& config) const;
+	// Read the IR, bake pre/post processing into it and compile it for the device or the OpenCL context
+	ov::CompiledModel CompileModel(const InferenceConfig& config, const ModelIO& io);
+	// Compile again until no property change is pending, runs on compile_thread
+	void RecompileLoop();
+	// Replace compiled_model between two frames and recreate the requests that are not in flight
+	void SwapCompiledModel(const ov::CompiledModel& model);
+	// Create a request and the tensors it owns
+	void CreateSlotRequest(InferSlot& slot);
+	// Create the request of an asynchronous slot, with the callback that completes it
+	void CreateAsyncRequest(size_t index);
+	// Create the request of the OpenCL path, bound to the shared input and output buffers
+	void CreateOCLRequest();
+	// Registered tensor over caller memory matching the frame, empty if the frame has to be copied
+	ov::Tensor FindFrameBuffer(const unsigned char* data, int width, int height, int pitch);
+	// Bind a strided BGRA frame as input of a request, in place or through a copy into the own tensor;
+	// the capture handoff stage runs from "received" until the frame is bound
+	void PrepareInput(InferSlot& slot, const unsigned char* inferdata, int inwidth, int inheight, int inpitch, bool debug_flag,
+		std::chrono::steady_clock::time_point received);
+	// Bind the caller's output buffer to a request when it is registered, otherwise the own tensor
+	void BindOutput(InferSlot& slot, unsigned char* out, int outpitch);
+	// Write the output of a request into strided BGRA rows, nothing to do when it was written in place
+	void ReadOutput(InferSlot& slot, unsigned char* out, int outpitch, bool debug_flag);
+	// Synchronous inference of a strided BGRA frame, callers hold the submit and result locks
+	void RunFrame(const unsigned char* inferdata, int inwidth, int inheight, int inpitch, unsigned char* out, int outpitch, bool debug_flag,
+		std::chrono::steady_clock::time_point received);
+	// Tiled inference of a strided BGRA frame, tiles run on parallel requests and are blended in order
+	void RunTiled(const unsigned char* inferdata, int inwidth, int inheight, int inpitch, unsigned char* out, int outpitch, bool debug_flag,
+		std::chrono::steady_clock::time_point received);
+	// Run the tiles of a frame at model resolution whose window changed, and compose the output of the results of all tiles
+	void RunDirtyTiles(const cv::Mat& frame, cv::Mat& out_image);
+	// Window of a tile in the frame at model resolution, moved inside the frame at its borders
+	cv::Rect TileWindow(int tileX, int tileY) const;
+	// Copy the window of a tile into the input tensor of a request and start it
+	void StartTile(const cv::Mat& frame, int tileX, int tileY, ov::InferRequest& request);
+	// Blend the result of one tile into the strip of its row
+	void BlendTile(const cv::Mat& tile, int tileX, int tileY, cv::Mat& strip);
+	// Blend a complete strip into the output, its top band is cross-faded with the row above
+	void WriteStrip(const cv::Mat& strip, int tileY, cv::Mat& out_image);
+	// Batched inference with a pitch per output
+	void RunBatch(const unsigned char* const* inputs, int count, int inwidth, int inheight, int inpitch, unsigned char* const* outputs, const int* outpitches, bool debug_flag);
+	// Batched model of a batch size, compiled when it is first used
+	BatchModel& GetBatchModel(int count);
+	// Run the pending views as one batch, missing views are padded; callers hold view_mutex
+	void RunViewBatch(bool debug_flag);
+	// Account one frame in the periodic performance log
+	void LogFrameTime(std::chrono::steady_clock::time_point begin);
+	// Block until no asynchronous request is running
+	void WaitAllSlots();
 };
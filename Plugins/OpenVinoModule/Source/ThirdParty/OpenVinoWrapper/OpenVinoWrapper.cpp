@@ -27,31 +27,2228 @@ embedded in Materials by Intel or Intel's suppliers or licensors in any way."
 #include <vector>
 #include <memory>
 #include <string>
+#include <mutex>
+#include <atomic>
+#include <list>
+#include <map>
+#include <thread>
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <d3d11.h>
 
 #include "OpenVinoData.h"
+#include "ResolutionController.h"
+#include "VariantProbe.h"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
 using namespace std;
 
-// This variable holds last error message, if any 
-static string last_error;
-// This is a pointer to initialized OpenVino model structures, assigned by "OpenVino_Initialize"
-static unique_ptr<OpenVinoData> initializedData;
-// This variable holds the model width and height
-static int modelWidth;
-static int modelHeight;
-static bool isOCLInitialized = false;
+/**
+ * @struct SessionKey
+ * @brief What a CPU mode session was loaded with, a cached session is only reused for the same
+ */
+struct SessionKey
+{
+	string xml_path;
+	string bin_path;
+	string device;
+	int width = 0;
+	int height = 0;
+	InferenceConfig config;
+
+	bool operator==(const SessionKey& other) const
+	{
+		return xml_path == other.xml_path &&
+			bin_path == other.bin_path &&
+			device == other.device &&
+			width == other.width &&
+			height == other.height &&
+			config == other.config;
+	}
+};
+
+/**
+ * @struct OpenVinoSession
+ * @brief One loaded model at one resolution, behind an "OpenVinoSessionHandle"
+ */
+struct OpenVinoSession
+{
+	// OpenVinoData does actual processing and serializes concurrent calls on the same session
+	unique_ptr<OpenVinoData> data;
+	bool is_ocl = false;
+	// what a CPU mode session was loaded with, guarded by the mutex of the default session or cache holding it.
+	// The properties of the default session change under the ladder mutex too, the ladder reads them under that one
+	SessionKey key;
+	// rough memory use: weights and request tensors, counted against the memory budget of the session cache
+	uint64_t memory_bytes = 0;
+};
+
+/**
+ * @struct StyleFiles
+ * @brief IR of a style registered by "OpenVino_RegisterStyle"
+ */
+struct StyleFiles
+{
+	string xml_path;
+	string bin_path;
+};
+
+// This variable holds last error message of the calling thread, if any
+static thread_local string last_error;
+// Session of the functions without handle, assigned by "OpenVino_Initialize" and "OpenVino_Initialize_BaseOCL".
+// Calls hold a reference, so a concurrent release only destroys it once they returned
+static shared_ptr<OpenVinoSession> defaultSession;
+static mutex defaultSessionMutex;
+// This variable holds the style transfer width and height chosen by "OpenVino_GetSuitableSTsize"
+static atomic<int> modelWidth(0);
+static atomic<int> modelHeight(0);
+// Compilation and scheduling of new sessions, applied by the next "OpenVino_Initialize" or "OpenVino_CreateSession"
+static InferenceConfig inferenceConfig;
+static mutex inferenceConfigMutex;
+// CPU mode default sessions replaced recently, most recently used first. Switching back to their
+// resolution or device swaps them in without compiling, see "OpenVino_SetSessionCacheSize"
+static list<shared_ptr<OpenVinoSession>> sessionCache;
+static size_t sessionCacheSize = 3;
+static uint64_t sessionMemoryBudget = 1024ull * 1024 * 1024;
+static mutex sessionCacheMutex;
+// Styles by name, see "OpenVino_SetStyle"
+static map<string, StyleFiles> styles;
+static mutex stylesMutex;
+
+/*
+ * @brief Reference to the default session, empty if it is not initialized
+ */
+static shared_ptr<OpenVinoSession>
+DefaultSession()
+{
+	lock_guard<mutex> lock(defaultSessionMutex);
+	return defaultSession;
+}
+
+/*
+ * @brief Default session of the CPU mode functions, throws if it is not initialized in CPU mode
+ */
+static shared_ptr<OpenVinoSession>
+DefaultCpuSession()
+{
+	shared_ptr<OpenVinoSession> session = DefaultSession();
+	if (!session || session->is_ocl)
+		throw std::invalid_argument("OpenVINO has not been initialized in CPU mode");
+	return session;
+}
+
+/*
+ * @brief Move the least recently used sessions into "evicted" until the cache fits its count and memory budget,
+ * callers hold sessionCacheMutex
+ */
+static void
+EvictSessions(list<shared_ptr<OpenVinoSession>>& evicted)
+{
+	uint64_t total = 0;
+	for (const shared_ptr<OpenVinoSession>& session : sessionCache)
+		total += session->memory_bytes;
+
+	while (!sessionCache.empty() && (sessionCache.size() > sessionCacheSize || total > sessionMemoryBudget))
+	{
+		total -= sessionCache.back()->memory_bytes;
+		evicted.splice(evicted.begin(), sessionCache, std::prev(sessionCache.end()));
+	}
+}
+
+/*
+ * @brief Keep a replaced default session loaded for a later switch back, the least recently used ones are dropped
+ */
+static void
+CacheSession(shared_ptr<OpenVinoSession> session)
+{
+	if (!session || session->is_ocl)
+		return;
+
+	list<shared_ptr<OpenVinoSession>> evicted;
+	lock_guard<mutex> lock(sessionCacheMutex);
+	sessionCache.push_front(std::move(session));
+	EvictSessions(evicted);
+	// evicted sessions are released after the lock, unless another thread is still inside a call on them
+}
+
+/*
+ * @brief Take the cached session loaded with "key" out of the cache, empty if there is none
+ */
+static shared_ptr<OpenVinoSession>
+TakeCachedSession(const SessionKey& key)
+{
+	lock_guard<mutex> lock(sessionCacheMutex);
+	for (auto it = sessionCache.begin(); it != sessionCache.end(); ++it)
+	{
+		if ((*it)->key == key)
+		{
+			shared_ptr<OpenVinoSession> session = *it;
+			sessionCache.erase(it);
+			return session;
+		}
+	}
+	return nullptr;
+}
+
+/*
+ * @brief Drop all cached sessions
+ */
+static void
+ClearSessionCache()
+{
+	list<shared_ptr<OpenVinoSession>> cleared;
+	lock_guard<mutex> lock(sessionCacheMutex);
+	std::swap(cleared, sessionCache);
+}
+
+/*
+ * @brief Make "session" the default session, the replaced one goes into the session cache
+ */
+static void
+ReplaceDefaultSession(shared_ptr<OpenVinoSession> session)
+{
+	{
+		lock_guard<mutex> lock(defaultSessionMutex);
+		std::swap(session, defaultSession);
+	}
+	CacheSession(std::move(session));
+}
+
+/*
+ * @brief Copy the stage times and load counters of a session into the C struct
+ */
+static void
+FillStats(const OpenVinoSession& session, OpenVinoStats* stats)
+{
+	PipelineSnapshot snapshot = session.data->GetStats();
+	OpenVinoStageStats* stages[] = {
+		&stats->capture_handoff, &stats->preprocess, &stats->infer, &stats->postprocess, &stats->output_copy };
+	for (size_t i = 0; i < static_cast<size_t>(PipelineStage::COUNT); i++)
+	{
+		const StageSummary& summary = snapshot.stages[i];
+		stages[i]->count = summary.count;
+		stages[i]->min_ms = summary.min_ms;
+		stages[i]->mean_ms = summary.mean_ms;
+		stages[i]->p95_ms = summary.p95_ms;
+		stages[i]->max_ms = summary.max_ms;
+	}
+	stats->load_ms = snapshot.load_ms;
+	stats->loads = snapshot.loads;
+	stats->cache_hits = snapshot.cache_hits;
+	stats->cache_misses = snapshot.cache_misses;
+	stats->frames_checked = snapshot.frames_checked;
+	stats->frames_skipped = snapshot.frames_skipped;
+	stats->tiles_total = snapshot.tiles_total;
+	stats->tiles_inferred = snapshot.tiles_inferred;
+	stats->resolution_rung = 0;
+	stats->inference_width = session.key.width;
+	stats->inference_height = session.key.height;
+	stats->frame_budget_ms = 0.0;
+	stats->frame_ms = 0.0;
+}
+
+/*
+ * @brief Copy of the settings new sessions are created with
+ */
+static InferenceConfig
+CurrentInferenceConfig()
+{
+	lock_guard<mutex> lock(inferenceConfigMutex);
+	return inferenceConfig;
+}
+
+/*
+ * @brief What a CPU mode session loads with the current settings
+ */
+static SessionKey
+CpuSessionKey(
+	LPCSTR modelXmlFilePath,
+	LPCSTR modelBinFilePath,
+	int inferWidth,
+	int inferHeight,
+	LPCSTR devicename)
+{
+	if (modelXmlFilePath == nullptr ||
+		modelBinFilePath == nullptr ||
+		devicename == nullptr)
+		throw invalid_argument("One of the file paths or the device passed was null");
+
+	SessionKey key;
+	key.xml_path = modelXmlFilePath;
+	key.bin_path = modelBinFilePath;
+	key.device = devicename;
+	key.width = inferWidth;
+	key.height = inferHeight;
+	key.config = CurrentInferenceConfig();
+	return key;
+}
+
+/*
+ * @brief Load a model for CPU (or another OpenVINO device) into a new session
+ */
+static unique_ptr<OpenVinoSession>
+LoadCpuSession(const SessionKey& key)
+{
+	auto session = std::make_unique<OpenVinoSession>();
+	session->data = std::make_unique<OpenVinoData>();
+	session->key = key;
+	// Forward initialization to OpenVinoData:
+	session->data->Initialize(key.xml_path, key.bin_path, key.width, key.height, key.device, key.config);
+	std::error_code ignored;
+	uintmax_t weights = std::filesystem::file_size(key.bin_path, ignored);
+	session->memory_bytes = (weights == static_cast<uintmax_t>(-1) ? 0 : weights) + session->data->RequestMemory();
+	return session;
+}
+
+/*
+ * @brief Load a model for CPU (or another OpenVINO device) into a new session
+ */
+static unique_ptr<OpenVinoSession>
+CreateCpuSession(
+	LPCSTR modelXmlFilePath,
+	LPCSTR modelBinFilePath,
+	int inferWidth,
+	int inferHeight,
+	LPCSTR devicename)
+{
+	return LoadCpuSession(CpuSessionKey(modelXmlFilePath, modelBinFilePath, inferWidth, inferHeight, devicename));
+}
+
+// Frames run by a background initialization before the session is ready
+static const int kWarmUpFrames = 3;
+
+/**
+ * @struct BackgroundInitialization
+ * @brief Default session loaded by "OpenVino_InitializeAsync". The latest request wins, the loaded
+ * session waits until "OpenVino_IsReady" swaps it in.
+ */
+struct BackgroundInitialization
+{
+	std::mutex init_mutex;
+	// model, resolution and settings of the requested session
+	SessionKey key;
+	// bumped by every request and cancellation, a loaded session of an older one is dropped
+	unsigned long long request = 0;
+	bool pending = false;
+	bool running = false;
+	// the requested session is not loaded yet
+	bool loading = false;
+	// loading steps done: compilation, then each warm-up frame
+	int steps_done = 0;
+	shared_ptr<OpenVinoSession> loaded;
+	string error;
+	// runs "BackgroundInitializationLoop", joined by "OpenVino_Release" and at unload
+	std::thread thread;
+};
+
+static shared_ptr<BackgroundInitialization> backgroundInit = make_shared<BackgroundInitialization>();
+
+static void JoinLoadingThreadsAtUnload();
+
+/*
+ * @brief Load requested sessions until no request is pending, runs on the thread of "init"
+ */
+static void
+BackgroundInitializationLoop(shared_ptr<BackgroundInitialization> init)
+{
+	while (true)
+	{
+		unsigned long long request;
+		SessionKey key;
+		{
+			lock_guard<mutex> lock(init->init_mutex);
+			if (!init->pending)
+			{
+				init->running = false;
+				return;
+			}
+			init->pending = false;
+			init->steps_done = 0;
+			request = init->request;
+			key = init->key;
+		}
+
+		unique_ptr<OpenVinoSession> session;
+		string error;
+		try
+		{
+			session = LoadCpuSession(key);
+			for (int i = 0; i < kWarmUpFrames; i++)
+			{
+				{
+					lock_guard<mutex> lock(init->init_mutex);
+					if (init->request != request)
+						break;
+					init->steps_done = i + 1;
+				}
+				session->data->WarmUpFrame();
+			}
+		}
+		catch (std::exception& ex)
+		{
+			session.reset();
+			error = ex.what();
+		}
+		catch (...)
+		{
+			session.reset();
+			error = "General error";
+		}
+
+		lock_guard<mutex> lock(init->init_mutex);
+		// a superseded or cancelled session is dropped when the lock is released
+		if (init->request == request)
+		{
+			init->loading = false;
+			init->steps_done = kWarmUpFrames + 1;
+			init->loaded = std::move(session);
+			init->error = error;
+			if (!error.empty())
+				clog << "Background initialization failed: " << error << endl;
+		}
+		if (!init->pending)
+		{
+			init->running = false;
+			return;
+		}
+	}
+}
+
+/*
+ * @brief Drop a background initialization in progress, a session it already loaded goes into the session cache
+ */
+static void
+CancelBackgroundInitialization()
+{
+	shared_ptr<OpenVinoSession> loaded;
+	{
+		lock_guard<mutex> lock(backgroundInit->init_mutex);
+		backgroundInit->request++;
+		backgroundInit->pending = false;
+		backgroundInit->loading = false;
+		backgroundInit->error.clear();
+		std::swap(loaded, backgroundInit->loaded);
+	}
+	CacheSession(std::move(loaded));
+}
+
+/*
+ * @brief Cancel a background initialization and wait for its thread. A model compiling can't be
+ * interrupted, the wait lasts until its compilation finished.
+ */
+static void
+JoinBackgroundInitialization()
+{
+	CancelBackgroundInitialization();
+	std::thread thread;
+	{
+		lock_guard<mutex> lock(backgroundInit->init_mutex);
+		std::swap(thread, backgroundInit->thread);
+	}
+	if (thread.joinable())
+		thread.join();
+}
+
+/*
+ * @brief Whether the default session is the CPU mode session loaded with "key"
+ */
+static bool
+IsDefaultSession(const SessionKey& key)
+{
+	lock_guard<mutex> lock(defaultSessionMutex);
+	return defaultSession && !defaultSession->is_ocl && defaultSession->key == key;
+}
+
+/*
+ * @brief Load the session of "key" in the background, or hand a loaded one to the next "OpenVino_IsReady"
+ */
+static void
+RequestDefaultSession(const SessionKey& key)
+{
+	// switching back to a session loaded before costs nothing, the cached one is swapped in by the next "OpenVino_IsReady"
+	bool is_default = IsDefaultSession(key);
+	shared_ptr<OpenVinoSession> cached = is_default ? nullptr : TakeCachedSession(key);
+	shared_ptr<OpenVinoSession> superseded;
+	{
+		lock_guard<mutex> lock(backgroundInit->init_mutex);
+		backgroundInit->request++;
+		backgroundInit->error.clear();
+		std::swap(superseded, backgroundInit->loaded);
+		if (!is_default && !cached && superseded && superseded->key == key)
+			std::swap(cached, superseded);
+
+		if (is_default || cached)
+		{
+			backgroundInit->pending = false;
+			backgroundInit->loading = false;
+			backgroundInit->steps_done = kWarmUpFrames + 1;
+			backgroundInit->loaded = std::move(cached);
+		}
+		else
+		{
+			backgroundInit->key = key;
+			backgroundInit->pending = true;
+			backgroundInit->loading = true;
+			backgroundInit->steps_done = 0;
+			if (!backgroundInit->running)
+			{
+				JoinLoadingThreadsAtUnload();
+				// a previous loop cleared "running" as its last step, it has returned or is about to
+				if (backgroundInit->thread.joinable())
+					backgroundInit->thread.join();
+				backgroundInit->running = true;
+				backgroundInit->thread = std::thread(BackgroundInitializationLoop, backgroundInit);
+			}
+		}
+	}
+	CacheSession(std::move(superseded));
+}
+
+/**
+ * @struct ResolutionLadder
+ * @brief Lower resolution sessions of the default CPU mode session, see "OpenVino_SetResolutionLadder".
+ * Frames run at the rung the controller picks and are rescaled to the size of the default session.
+ */
+struct ResolutionLadder
+{
+	std::mutex ladder_mutex;
+	// scales of the rungs below the default session, highest first
+	vector<float> scales;
+	ResolutionController controller;
+	// default session the rungs were loaded for
+	SessionKey base;
+	bool has_base = false;
+	// thresholds of the default session, every rung gets them when it is loaded and when they change
+	float change_threshold = 0.0f;
+	float dirty_tile_threshold = 0.0f;
+	// rungs[0] stays empty and stands for the default session, lower rungs are empty until they are loaded
+	vector<shared_ptr<OpenVinoSession>> rungs;
+	// bumped whenever the rungs are dropped, the loader discards a session of an older generation
+	unsigned long long generation = 0;
+	// index into "scales" of the rung the loader loads next
+	size_t next_rung = 0;
+	bool loader_running = false;
+	// runs "LadderLoaderLoop", joined by "OpenVino_Release" and at unload
+	std::thread loader;
+};
+
+static shared_ptr<ResolutionLadder> resolutionLadder = make_shared<ResolutionLadder>();
+
+/*
+ * @brief Size of a rung, a multiple of 4 like "OpenVino_GetSuitableSTsize" chooses
+ */
+static int
+RungSize(int size, float scale)
+{
+	return std::max(4, static_cast<int>(size * scale / 4.0f + 0.5f) * 4);
+}
+
+/*
+ * @brief Give a rung the change and dirty tile thresholds of the default session
+ */
+static void
+SetRungThresholds(OpenVinoSession& rung, float change_threshold, float dirty_tile_threshold)
+{
+	try
+	{
+		rung.data->SetChangeThreshold(change_threshold);
+		rung.data->SetDirtyTileThreshold(dirty_tile_threshold);
+	}
+	catch (std::exception& ex)
+	{
+		// e.g. a rung too small to be tiled, it runs all of its frame
+		clog << "Resolution rung " << rung.key.width << "x" << rung.key.height << " keeps its thresholds: " << ex.what() << endl;
+	}
+}
+
+/*
+ * @brief Load the lower rungs of the current base one after another, highest first, runs on the loader
+ * thread of "ladder". Rungs dropped meanwhile are not loaded any more, the loop moves on to the rungs of
+ * the new base after the one compiling.
+ */
+static void
+LadderLoaderLoop(shared_ptr<ResolutionLadder> ladder)
+{
+	while (true)
+	{
+		SessionKey key;
+		size_t index;
+		unsigned long long generation;
+		{
+			lock_guard<mutex> lock(ladder->ladder_mutex);
+			if (!ladder->has_base || ladder->next_rung >= ladder->scales.size())
+			{
+				ladder->loader_running = false;
+				return;
+			}
+			index = ladder->next_rung++;
+			generation = ladder->generation;
+			key = ladder->base;
+			key.width = RungSize(ladder->base.width, ladder->scales[index]);
+			key.height = RungSize(ladder->base.height, ladder->scales[index]);
+		}
+
+		shared_ptr<OpenVinoSession> session;
+		try
+		{
+			session = LoadCpuSession(key);
+			session->data->WarmUpFrame();
+		}
+		catch (std::exception& ex)
+		{
+			// the controller skips a rung that is not available
+			session.reset();
+			clog << "Resolution rung " << key.width << "x" << key.height << " is not available: " << ex.what() << endl;
+		}
+
+		lock_guard<mutex> lock(ladder->ladder_mutex);
+		if (ladder->generation == generation && session)
+			// set under the lock, so a threshold changed meanwhile is not missed; no frame runs on the rung yet
+			SetRungThresholds(*session, ladder->change_threshold, ladder->dirty_tile_threshold);
+		if (ladder->generation == generation)
+			ladder->rungs[index + 1] = std::move(session);
+		// a session of dropped rungs is released after the lock
+	}
+}
+
+/*
+ * @brief Drop the loaded rungs and return to the default session, callers hold the ladder mutex
+ * @return dropped sessions, to be released after the lock
+ */
+static vector<shared_ptr<OpenVinoSession>>
+DropLadderRungs(ResolutionLadder& ladder)
+{
+	vector<shared_ptr<OpenVinoSession>> dropped;
+	std::swap(dropped, ladder.rungs);
+	ladder.generation++;
+	ladder.has_base = false;
+	ladder.next_rung = 0;
+	ladder.controller.Reset();
+	return dropped;
+}
+
+/*
+ * @brief Session the next frame of the default session runs on, the default session itself or the rung the
+ * controller picked. The rungs are loaded again in the background when the default session changed.
+ */
+static shared_ptr<OpenVinoSession>
+LadderSession(const shared_ptr<OpenVinoSession>& session)
+{
+	vector<shared_ptr<OpenVinoSession>> dropped;
+	lock_guard<mutex> lock(resolutionLadder->ladder_mutex);
+	ResolutionLadder& ladder = *resolutionLadder;
+	if (ladder.controller.GetBudget() <= 0.0 || ladder.scales.empty())
+		return session;
+
+	if (!ladder.has_base || !(ladder.base == session->key))
+	{
+		dropped = DropLadderRungs(ladder);
+		ladder.base = session->key;
+		ladder.has_base = true;
+		ladder.change_threshold = session->data->ChangeThreshold();
+		ladder.dirty_tile_threshold = session->data->DirtyTileThreshold();
+		ladder.rungs.resize(ladder.scales.size() + 1);
+		vector<double> pixels = { static_cast<double>(session->key.width) * session->key.height };
+		for (float scale : ladder.scales)
+			pixels.push_back(static_cast<double>(RungSize(session->key.width, scale)) * RungSize(session->key.height, scale));
+		ladder.controller.SetRungs(pixels);
+		// one loader, it picks up the new rungs after the rung it may be compiling
+		if (!ladder.loader_running)
+		{
+			JoinLoadingThreadsAtUnload();
+			// a previous loop cleared "loader_running" as its last step, it has returned or is about to
+			if (ladder.loader.joinable())
+				ladder.loader.join();
+			ladder.loader_running = true;
+			ladder.loader = std::thread(LadderLoaderLoop, resolutionLadder);
+		}
+		return session;
+	}
+
+	int rung = ladder.controller.GetRung();
+	return rung > 0 && ladder.rungs[rung] ? ladder.rungs[rung] : session;
+}
+
+/*
+ * @brief Account the latency of a frame of the default session, 0 if it did not run the model
+ */
+static void
+RecordLadderFrame(double ms)
+{
+	lock_guard<mutex> lock(resolutionLadder->ladder_mutex);
+	ResolutionLadder& ladder = *resolutionLadder;
+	if (!ladder.has_base)
+		return;
+
+	vector<bool> available(ladder.rungs.size());
+	for (size_t i = 0; i < ladder.rungs.size(); i++)
+		available[i] = ladder.rungs[i] != nullptr;
+	int rung = ladder.controller.GetRung();
+	if (ladder.controller.Record(ms, available) != rung)
+	{
+		int new_rung = ladder.controller.GetRung();
+		const SessionKey& key = new_rung == 0 ? ladder.base : ladder.rungs[new_rung]->key;
+		clog << "Inference resolution " << key.width << "x" << key.height << ", " << ladder.controller.GetFrameMs()
+			<< " ms per frame at the previous one, budget " << ladder.controller.GetBudget() << " ms" << endl;
+	}
+}
+
+/*
+ * @brief Give the loaded rungs the thresholds "session" has now, if the rungs belong to it
+ */
+static void
+UpdateLadderThresholds(const shared_ptr<OpenVinoSession>& session)
+{
+	vector<shared_ptr<OpenVinoSession>> rungs;
+	float change_threshold;
+	float dirty_tile_threshold;
+	{
+		lock_guard<mutex> lock(resolutionLadder->ladder_mutex);
+		ResolutionLadder& ladder = *resolutionLadder;
+		if (!ladder.has_base || !(ladder.base == session->key))
+			return;
+		// rungs loaded from now on get them from the loader
+		ladder.change_threshold = change_threshold = session->data->ChangeThreshold();
+		ladder.dirty_tile_threshold = dirty_tile_threshold = session->data->DirtyTileThreshold();
+		rungs = ladder.rungs;
+	}
+	// outside the lock, a rung may be running a frame
+	for (const shared_ptr<OpenVinoSession>& rung : rungs)
+		if (rung)
+			SetRungThresholds(*rung, change_threshold, dirty_tile_threshold);
+}
+
+/*
+ * @brief Drop the rungs of the default session, e.g. when it is released
+ */
+static void
+ClearLadderRungs()
+{
+	vector<shared_ptr<OpenVinoSession>> dropped;
+	lock_guard<mutex> lock(resolutionLadder->ladder_mutex);
+	dropped = DropLadderRungs(*resolutionLadder);
+}
+
+/*
+ * @brief Drop the rungs and wait for the loader thread, which finishes the rung it may be compiling
+ */
+static void
+JoinLadderLoader()
+{
+	ClearLadderRungs();
+	std::thread loader;
+	{
+		lock_guard<mutex> lock(resolutionLadder->ladder_mutex);
+		std::swap(loader, resolutionLadder->loader);
+	}
+	if (loader.joinable())
+		loader.join();
+}
+
+/**
+ * @struct LoadingThreadsJoiner
+ * @brief Joins the threads loading sessions when the library is unloaded, while the OpenVINO core and
+ * model cache they use still exist
+ */
+struct LoadingThreadsJoiner
+{
+	~LoadingThreadsJoiner()
+	{
+		JoinBackgroundInitialization();
+		JoinLadderLoader();
+	}
+};
+
+/*
+ * @brief Have the loading threads joined at unload, called before one is started
+ */
+static void
+JoinLoadingThreadsAtUnload()
+{
+	// created after the shared runtime, so it is destroyed, and joins, before the runtime is
+	OpenVinoData::CreateSharedRuntime();
+	static LoadingThreadsJoiner joiner;
+}
+
+/*
+ * @brief This method is called to make initialization of the OpenVino library and load the
+ * models based on files specified in "modelXmlFilePath", "modelBinFilePath" and "modelLabelFilePath".
+ * @param modelXmlFilePath Path to, for example: squeezenet1.1.xml
+ * @param modelBinFilePath Path to, for example: squeezenet1.1.bin
+ * @param modelLabelFilePath Path to, for example: squeezenet1.1.labels
+ * @return true if call is successfull or false if not
+ */
+DLLEXPORT
+bool __cdecl 
+OpenVino_Initialize(
+	LPCSTR modelXmlFilePath,
+	LPCSTR modelBinFilePath,
+	int inferWidth,
+	int inferHeight,
+	LPCSTR devicename)
+{
+	try
+	{
+		last_error.clear();
+
+		CancelBackgroundInitialization();
+		SessionKey key = CpuSessionKey(modelXmlFilePath, modelBinFilePath, inferWidth, inferHeight, devicename);
+		if (IsDefaultSession(key))
+			return true;
+
+		// a session loaded before with the same model, resolution, device and settings is reused
+		shared_ptr<OpenVinoSession> session = TakeCachedSession(key);
+		if (!session)
+			session = LoadCpuSession(key);
+		// Save it for use in later calls, the replaced session stays cached:
+		ReplaceDefaultSession(std::move(session));
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+ * @brief This method starts loading a model into the default session on a background thread: the model is
+ * read, compiled and run on a few warm-up frames. The previous default session keeps running until
+ * "OpenVino_IsReady" swaps the new one in. A new request supersedes one still loading.
+ * @param modelXmlFilePath Path to, for example: style_transfer.xml
+ * @param modelBinFilePath Path to, for example: style_transfer.bin
+ * @param inferWidth, inference width
+ * @param inferHeight, inference height
+ * @param devicename, device the model is compiled for
+ * @return true if call is successfull or false if not
+ */
+DLLEXPORT
+bool __cdecl
+OpenVino_InitializeAsync(
+	LPCSTR modelXmlFilePath,
+	LPCSTR modelBinFilePath,
+	int inferWidth,
+	int inferHeight,
+	LPCSTR devicename)
+{
+	try
+	{
+		SessionKey key = CpuSessionKey(modelXmlFilePath, modelBinFilePath, inferWidth, inferHeight, devicename);
+		last_error.clear();
+
+		RequestDefaultSession(key);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+ * @brief This method reports the progress of "OpenVino_InitializeAsync". A loaded session replaces the
+ * default session in the call that reports it ready, so buffers can be resized before the next frame.
+ * @param ready, true once the default session is loaded and no initialization is in progress
+ * @param progress, fraction of the loading steps done, 1 when ready
+ * @return true if call is successfull, false if the background initialization failed
+ */
+DLLEXPORT
+bool __cdecl
+OpenVino_IsReady(
+	bool* ready,
+	float* progress)
+{
+	try
+	{
+		if (ready == nullptr || progress == nullptr)
+			throw invalid_argument("Invalid readiness output");
+
+		last_error.clear();
+
+		shared_ptr<OpenVinoSession> loaded;
+		bool loading = false;
+		{
+			lock_guard<mutex> lock(backgroundInit->init_mutex);
+			if (!backgroundInit->error.empty())
+			{
+				string error = backgroundInit->error;
+				backgroundInit->error.clear();
+				throw std::runtime_error(error);
+			}
+			loaded = std::move(backgroundInit->loaded);
+			loading = backgroundInit->loading;
+			*progress = static_cast<float>(backgroundInit->steps_done) / (kWarmUpFrames + 1);
+		}
+
+		if (loaded)
+		{
+			// the previous session stays cached for a switch back
+			ReplaceDefaultSession(std::move(loaded));
+		}
+
+		*ready = !loading && DefaultSession() != nullptr;
+		if (!loading)
+			*progress = *ready ? 1.0f : 0.0f;
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method registers a style IR under a name, for "OpenVino_SetStyle". Registering a name again
+* replaces its files for later switches.
+* @param name, name of the style
+* @param modelXmlFilePath Path to, for example: style_transfer.xml
+* @param modelBinFilePath Path to, for example: style_transfer.bin
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_RegisterStyle(
+	LPCSTR name,
+	LPCSTR modelXmlFilePath,
+	LPCSTR modelBinFilePath)
+{
+	try
+	{
+		if (name == nullptr ||
+			modelXmlFilePath == nullptr ||
+			modelBinFilePath == nullptr)
+			throw invalid_argument("The name or one of the file paths passed was null");
+
+		last_error.clear();
+
+		lock_guard<mutex> lock(stylesMutex);
+		styles[name] = StyleFiles{ modelXmlFilePath, modelBinFilePath };
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method switches the default session to a registered style at its resolution and device,
+* like "OpenVino_InitializeAsync" with the files of the style.
+* @param name, name given to "OpenVino_RegisterStyle"
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SetStyle(
+	LPCSTR name)
+{
+	try
+	{
+		if (name == nullptr)
+			throw invalid_argument("Style name was null");
+
+		StyleFiles files;
+		{
+			lock_guard<mutex> lock(stylesMutex);
+			auto it = styles.find(name);
+			if (it == styles.end())
+				throw invalid_argument(string("Unknown style ") + name);
+			files = it->second;
+		}
+
+		// the resolution and device of a session still loading win over the running one
+		SessionKey key;
+		bool loading;
+		{
+			lock_guard<mutex> lock(backgroundInit->init_mutex);
+			loading = backgroundInit->loading;
+			if (loading)
+				key = backgroundInit->key;
+		}
+		if (!loading)
+		{
+			lock_guard<mutex> lock(defaultSessionMutex);
+			if (!defaultSession || defaultSession->is_ocl)
+				throw std::invalid_argument("OpenVINO has not been initialized in CPU mode");
+			key = defaultSession->key;
+		}
+		key.xml_path = files.xml_path;
+		key.bin_path = files.bin_path;
+		key.config = CurrentInferenceConfig();
+
+		last_error.clear();
+
+		RequestDefaultSession(key);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+
+/*
+* @brief This method is used to infer results, based on loaded model (see "OpenVino_Initialize")
+* and based on texture rendered by engine.
+* @param texture data
+* @param inwidth, texture width
+* @param inheight, texture height
+* @param outwidth, image width after style transfer
+* @param outheight, image height after style transfer
+* @param output, image data after style transfer
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_Infer_FromTexture(
+	unsigned char* input, int inwidth, int inheight,  unsigned char* out, bool debug_flag)
+{
+	try
+	{
+		shared_ptr<OpenVinoSession> session = DefaultSession();
+		if (!session)
+			throw std::invalid_argument("OpenVINO has not been initialized");
+
+		/*if (filePath == nullptr)
+			throw std::invalid_argument("File path passed was null");*/
+
+		// Actual Infer call passed to OpenVinoData
+		session->data->Infer(input, inwidth, inheight, out, debug_flag);
+
+		return true;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+ * @brief Infer a BGRA frame with the default CPU mode session, or with the rung of the resolution ladder
+ * that holds the frame budget, and rescale the result to the output if their sizes differ
+ */
+static void
+InferDefaultBGRA(
+	const unsigned char* input, int inwidth, int inheight, int inpitch, unsigned char* out, int outwidth, int outheight, int outpitch, bool debug_flag)
+{
+	shared_ptr<OpenVinoSession> session = DefaultCpuSession();
+
+	if (input == nullptr || out == nullptr || inpitch < inwidth * 4 || outpitch <= 0)
+		throw std::invalid_argument("Invalid input or output frame");
+
+	// a lower rung of the resolution ladder infers smaller frames, they are rescaled to the size of the default session
+	shared_ptr<OpenVinoSession> target = LadderSession(session);
+	if (outwidth <= 0 || outheight <= 0)
+	{
+		outwidth = session->key.width;
+		outheight = session->key.height;
+	}
+	if (outpitch < outwidth * 4)
+		throw std::invalid_argument("Invalid output frame");
+	chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+
+	// Actual Infer call passed to OpenVinoData, it rescales only if the sizes differ
+	target->data->InferBGRAScaled(input, inwidth, inheight, inpitch, out, outwidth, outheight, outpitch, debug_flag);
+
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+	RecordLadderFrame(target->data->LastInferenceMs() > 0.0 ? ms : 0.0);
+}
+
+/*
+* @brief This method is used to infer results, based on loaded model (see "OpenVino_Initialize")
+* and based on BGRA frame captured by engine.
+* @param input, BGRA texture data
+* @param inwidth, texture width
+* @param inheight, texture height
+* @param inpitch, distance in bytes between two rows of input
+* @param output, BGRA image data after style transfer
+* @param outpitch, distance in bytes between two rows of output
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_Infer_FromBGRA(
+	const unsigned char* input, int inwidth, int inheight, int inpitch, unsigned char* out, int outpitch, bool debug_flag)
+{
+	try
+	{
+		InferDefaultBGRA(input, inwidth, inheight, inpitch, out, 0, 0, outpitch, debug_flag);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method works as "OpenVino_Infer_FromBGRA", the result is rescaled to the output size if the
+* default session has another one.
+* @param outwidth, width of output
+* @param outheight, height of output
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_Infer_FromBGRAToSize(
+	const unsigned char* input, int inwidth, int inheight, int inpitch, unsigned char* out, int outwidth, int outheight, int outpitch, bool debug_flag)
+{
+	try
+	{
+		if (outwidth <= 0 || outheight <= 0)
+			throw std::invalid_argument("Invalid output size");
+
+		InferDefaultBGRA(input, inwidth, inheight, inpitch, out, outwidth, outheight, outpitch, debug_flag);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method chooses where CPU mode converts frames: inside the compiled graph (default),
+* or with the fused host kernels. Applied by the next "OpenVino_Initialize".
+* @param inGraph, true to convert inside the compiled graph
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SetProcessingInGraph(
+	bool inGraph)
+{
+	last_error.clear();
+	lock_guard<mutex> lock(inferenceConfigMutex);
+	inferenceConfig.process_in_graph = inGraph;
+
+	return true;
+}
+
+/*
+* @brief This method makes CPU mode run the model on tiles with overlapping halos instead of whole
+* frames. Applied by the next "OpenVino_Initialize".
+* @param size, tile size in pixels at model resolution, 0 to run whole frames
+* @param halo, pixels of context around each tile, negative to use the receptive field of the model
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SetTiling(
+	int size, int halo)
+{
+	last_error.clear();
+	lock_guard<mutex> lock(inferenceConfigMutex);
+	inferenceConfig.tile_size = size > 0 ? size : 0;
+	inferenceConfig.tile_halo = halo;
+
+	return true;
+}
+
+/*
+* @brief This method makes CPU mode compile for throughput with several streams, each running its
+* own frame of the asynchronous API. Applied by the next "OpenVino_Initialize".
+* @param streams, number of CPU streams, 0 to compile for latency
+* @param queueDepth, frames that may be in flight, 0 for one per stream
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SetThroughputMode(
+	int streams, int queueDepth)
+{
+	last_error.clear();
+	lock_guard<mutex> lock(inferenceConfigMutex);
+	inferenceConfig.streams = streams > 0 ? streams : 0;
+	inferenceConfig.queue_depth = queueDepth > 0 ? queueDepth : 0;
+
+	return true;
+}
+
+/*
+* @brief This method keeps CPU mode inference on a set of cores. Applied by the next "OpenVino_Initialize".
+* @param coreSet, "P" or "E" cores of a hybrid CPU, "numa:N", logical processors such as "0-7,16", or
+* empty for all cores
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SetCoreSet(
+	const char* coreSet)
+{
+	try
+	{
+		if (coreSet == nullptr)
+			throw std::invalid_argument("Core set was null");
+
+		// rejected here rather than by the next initialization
+		CoreSet set = CoreSet::Parse(coreSet);
+		if (!set.Empty())
+			clog << "Core set " << coreSet << ": " << set.Count() << " processors, NUMA node " << set.NumaNode() << endl;
+
+		last_error.clear();
+		lock_guard<mutex> lock(inferenceConfigMutex);
+		inferenceConfig.core_set = coreSet;
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method changes an OpenVINO property of the model. Before "OpenVino_Initialize" it is
+* applied by the next initialization; afterwards the model is compiled again in the background and
+* swapped in between two frames, it keeps running with the old properties until then.
+* @param name, PERFORMANCE_HINT, NUM_STREAMS, INFERENCE_NUM_THREADS, INFERENCE_PRECISION_HINT, AFFINITY
+* or PERFORMANCE_HINT_NUM_REQUESTS
+* @param value, value as OpenVINO prints it, e.g. THROUGHPUT, 4, f32, CORE; empty for the plugin default
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SetProperty(
+	const char* name, const char* value)
+{
+	try
+	{
+		if (name == nullptr || value == nullptr)
+			throw std::invalid_argument("Property name or value was null");
+
+		if (!OpenVinoData::IsTunableProperty(name))
+			throw std::invalid_argument(string("Unsupported property ") + name);
+
+		last_error.clear();
+		{
+			lock_guard<mutex> lock(inferenceConfigMutex);
+			if (*value == '\0')
+				inferenceConfig.properties.erase(name);
+			else
+				inferenceConfig.properties[name] = value;
+		}
+
+		shared_ptr<OpenVinoSession> session;
+		{
+			// the default session is compiled again with the property, cached sessions keep theirs
+			lock_guard<mutex> lock(defaultSessionMutex);
+			// the resolution ladder reads the key under its own mutex, so it is changed under both
+			lock_guard<mutex> ladder_lock(resolutionLadder->ladder_mutex);
+			session = defaultSession;
+			if (session && *value == '\0')
+				session->key.config.properties.erase(name);
+			else if (session)
+				session->key.config.properties[name] = value;
+		}
+		if (session)
+			session->data->SetProperty(name, value);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method reads an OpenVINO property: as the compiled model applies it once
+* "OpenVino_Initialize" succeeded, the requested value before.
+* @param name, one of the properties accepted by "OpenVino_SetProperty"
+* @param value, buffer receiving the value, empty if it was not set before initialization
+* @param maxLength, size of the buffer
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_GetProperty(
+	const char* name, char* value, size_t maxLength)
+{
+	try
+	{
+		if (name == nullptr || value == nullptr)
+			throw std::invalid_argument("Property name or value was null");
+
+		if (!OpenVinoData::IsTunableProperty(name))
+			throw std::invalid_argument(string("Unsupported property ") + name);
+
+		string result;
+		shared_ptr<OpenVinoSession> session = DefaultSession();
+		if (session)
+		{
+			result = session->data->GetProperty(name);
+		}
+		else
+		{
+			lock_guard<mutex> lock(inferenceConfigMutex);
+			auto it = inferenceConfig.properties.find(name);
+			if (it != inferenceConfig.properties.end())
+				result = it->second;
+		}
+
+		if (result.length() >= maxLength)
+			throw std::invalid_argument("Property value does not fit the buffer");
+
+		last_error.clear();
+		strcpy_s(value, maxLength, result.c_str());
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method chooses how model output is mapped onto 8 bit BGRA results by the host kernels.
+* @param runningRange, true to follow the running min/max estimate, an error in graph processing
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SetRunningOutputRange(
+	bool runningRange)
+{
+	try
+	{
+		shared_ptr<OpenVinoSession> session = DefaultCpuSession();
+
+		last_error.clear();
+		session->data->SetRunningOutputRange(runningRange);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method skips the inference of frames that differ less than "threshold" from the last inferred one.
+* @param threshold, mean absolute luma difference in (0,255), 0 to infer every frame
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SetChangeThreshold(
+	float threshold)
+{
+	try
+	{
+		if (threshold < 0.0f)
+			throw std::invalid_argument("Invalid change threshold");
+
+		shared_ptr<OpenVinoSession> session = DefaultCpuSession();
+
+		last_error.clear();
+		session->data->SetChangeThreshold(threshold);
+		UpdateLadderThresholds(session);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method runs only the tiles whose window changed by at least "threshold" since they were last inferred.
+* @param threshold, mean absolute luma difference in (0,255), 0 to run every tile
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SetDirtyTileThreshold(
+	float threshold)
+{
+	try
+	{
+		if (threshold < 0.0f)
+			throw std::invalid_argument("Invalid dirty tile threshold");
+
+		shared_ptr<OpenVinoSession> session = DefaultCpuSession();
+
+		last_error.clear();
+		session->data->SetDirtyTileThreshold(threshold);
+		UpdateLadderThresholds(session);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method sets the time a frame of "OpenVino_Infer_FromBGRA" may take, the resolution ladder holds it.
+* @param budgetMs, frame time budget in ms, 0 to always infer at the resolution of the default session
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SetFrameBudget(
+	float budgetMs)
+{
+	try
+	{
+		if (budgetMs < 0.0f)
+			throw std::invalid_argument("Invalid frame budget");
+
+		last_error.clear();
+
+		vector<shared_ptr<OpenVinoSession>> dropped;
+		lock_guard<mutex> lock(resolutionLadder->ladder_mutex);
+		resolutionLadder->controller.SetBudget(budgetMs);
+		// the rungs are loaded again once a budget is set
+		if (budgetMs == 0.0f)
+			dropped = DropLadderRungs(*resolutionLadder);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method sets the lower resolutions the default session may infer at to hold the frame budget.
+* @param scales, scales of the rungs in (0,1) relative to the resolution of the default session
+* @param count, number of scales, 0 for none
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SetResolutionLadder(
+	const float* scales,
+	int count)
+{
+	try
+	{
+		if (count < 0 || (count > 0 && scales == nullptr))
+			throw std::invalid_argument("Invalid resolution ladder");
+
+		vector<float> rungs(scales, scales + count);
+		for (float scale : rungs)
+		{
+			if (!(scale > 0.0f && scale < 1.0f))
+				throw std::invalid_argument("Resolution scales must be in (0,1)");
+		}
+		sort(rungs.begin(), rungs.end(), std::greater<float>());
+		rungs.erase(unique(rungs.begin(), rungs.end()), rungs.end());
+
+		last_error.clear();
+
+		vector<shared_ptr<OpenVinoSession>> dropped;
+		lock_guard<mutex> lock(resolutionLadder->ladder_mutex);
+		if (rungs != resolutionLadder->scales)
+		{
+			resolutionLadder->scales = rungs;
+			// loaded again by the next frame
+			dropped = DropLadderRungs(*resolutionLadder);
+		}
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method sets how many frames can be in flight in the asynchronous API (default 2).
+* @param framesInFlight, number of infer requests in the pool
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SetFramesInFlight(
+	int framesInFlight)
+{
+	try
+	{
+		shared_ptr<OpenVinoSession> session = DefaultCpuSession();
+
+		last_error.clear();
+		session->data->SetFramesInFlight(framesInFlight);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method registers a caller owned BGRA buffer that inference reads from or writes to in place.
+* @param data, first pixel of the buffer, 64 byte aligned
+* @param width, frame width
+* @param height, frame height
+* @param pitch, distance in bytes between two rows, width * 4 for zero-copy
+* @param zeroCopy, set to false if the buffer fails validation and keeps being copied
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_RegisterFrameBuffer(
+	unsigned char* data, int width, int height, int pitch, bool* zeroCopy)
+{
+	try
+	{
+		shared_ptr<OpenVinoSession> session = DefaultCpuSession();
+
+		if (zeroCopy == nullptr)
+			throw std::invalid_argument("Invalid zero-copy flag");
+
+		last_error.clear();
+		*zeroCopy = session->data->RegisterFrameBuffer(data, width, height, pitch);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method forgets a registered buffer, the caller may release it afterwards.
+* @param data, first pixel of the buffer
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_UnregisterFrameBuffer(
+	const unsigned char* data)
+{
+	try
+	{
+		shared_ptr<OpenVinoSession> session = DefaultCpuSession();
+
+		last_error.clear();
+		session->data->UnregisterFrameBuffer(data);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method preprocesses a frame and starts its inference without waiting for the result.
+* @param input, BGRA texture data
+* @param inwidth, texture width
+* @param inheight, texture height
+* @param inpitch, distance in bytes between two rows of input
+* @param frameId, non-negative tag returned together with the result of this frame
+* @return true if the frame was submitted, false if all frames are in flight or on error
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SubmitFrame(
+	const unsigned char* input, int inwidth, int inheight, int inpitch, long long frameId, bool debug_flag)
+{
+	return OpenVino_SubmitFrameTo(input, inwidth, inheight, inpitch, frameId, nullptr, 0, debug_flag);
+}
+
+/*
+* @brief This method starts the inference of a frame whose result is written to a registered buffer in place.
+* @param input, BGRA texture data
+* @param inwidth, texture width
+* @param inheight, texture height
+* @param inpitch, distance in bytes between two rows of input
+* @param frameId, non-negative tag returned together with the result of this frame
+* @param output, registered BGRA buffer of model size, or null to copy the result when it is collected
+* @param outpitch, distance in bytes between two rows of output
+* @return true if the frame was submitted, false if all frames are in flight or on error
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SubmitFrameTo(
+	const unsigned char* input, int inwidth, int inheight, int inpitch, long long frameId,
+	unsigned char* output, int outpitch, bool debug_flag)
+{
+	try
+	{
+		shared_ptr<OpenVinoSession> session = DefaultCpuSession();
+
+		if (input == nullptr || frameId < 0 || inpitch < inwidth * 4)
+			throw std::invalid_argument("Invalid input frame");
+
+		if (!session->data->SubmitFrame(input, inwidth, inheight, inpitch, frameId, debug_flag, output, outpitch))
+		{
+			last_error = "All frames are in flight";
+			return false;
+		}
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method collects the next frame in submission order, if it has finished.
+* @param output, BGRA image data after style transfer
+* @param outpitch, distance in bytes between two rows of output
+* @param frameId, tag of the collected frame, or -1 if the next frame has not finished yet
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_TryGetResult(
+	unsigned char* output, int outpitch, long long* frameId, bool debug_flag)
+{
+	return OpenVino_WaitResult(output, outpitch, frameId, 0, debug_flag);
+}
+
+/*
+* @brief This method waits for the next frame in submission order.
+* @param output, BGRA image data after style transfer, may be null for frames submitted with an output buffer
+* @param outpitch, distance in bytes between two rows of output
+* @param frameId, tag of the collected frame, or -1 if the timeout expired or no frame is in flight
+* @param timeoutMs, maximum time to wait, negative to wait without limit
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_WaitResult(
+	unsigned char* output, int outpitch, long long* frameId, int timeoutMs, bool debug_flag)
+{
+	try
+	{
+		shared_ptr<OpenVinoSession> session = DefaultCpuSession();
+
+		if (frameId == nullptr || (output != nullptr && outpitch <= 0))
+			throw std::invalid_argument("Invalid output buffer or frame id");
+
+		session->data->GetResult(output, outpitch, frameId, timeoutMs, debug_flag);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method reports achieved throughput against latency of the asynchronous API.
+* @param fps, delivered frames per second, running average
+* @param latencyMs, time from submission to delivery of a frame, running average
+* @param framesInFlight, frames submitted and not yet collected
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_GetThroughputStats(
+	double* fps, double* latencyMs, int* framesInFlight)
+{
+	try
+	{
+		shared_ptr<OpenVinoSession> session = DefaultCpuSession();
+
+		if (fps == nullptr || latencyMs == nullptr || framesInFlight == nullptr)
+			throw std::invalid_argument("Invalid statistics output");
+
+		session->data->GetThroughputStats(fps, latencyMs, framesInFlight);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method is used to infer a batch of same-sized BGRA frames, e.g. the views of a stereo
+* or split-screen frame, in one inference. The model is compiled for each batch size on first use.
+* @param inputs, BGRA texture data of each frame
+* @param count, number of frames
+* @param inwidth, width of the frames
+* @param inheight, height of the frames
+* @param inpitch, distance in bytes between two rows of each input
+* @param outputs, BGRA image data after style transfer of each frame
+* @param outpitch, distance in bytes between two rows of each output
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_InferBatch(
+	const unsigned char* const* inputs, int count, int inwidth, int inheight, int inpitch,
+	unsigned char* const* outputs, int outpitch, bool debug_flag)
+{
+	try
+	{
+		shared_ptr<OpenVinoSession> session = DefaultCpuSession();
+
+		if (inputs == nullptr || outputs == nullptr || count < 1 || inpitch < inwidth * 4 || outpitch <= 0)
+			throw std::invalid_argument("Invalid input or output frames");
+
+		last_error.clear();
+		session->data->InferBatch(inputs, count, inwidth, inheight, inpitch, outputs, outpitch, debug_flag);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method adds one view of a frame to the batch of that frame. The batch runs when all
+* views of the frame are submitted, or when a view of a later frame arrives first; see "OpenVino_WaitViews".
+* @param frameNumber, frame the view belongs to, increasing
+* @param viewIndex, index of the view within the frame
+* @param viewCount, number of views of the frame
+* @param input, BGRA texture data of the view, copied before the call returns
+* @param inwidth, texture width
+* @param inheight, texture height
+* @param inpitch, distance in bytes between two rows of input
+* @param output, BGRA image data after style transfer, written when the batch runs
+* @param outpitch, distance in bytes between two rows of output
+* @param batchDone, true if this call ran the batch and all outputs of the frame are written
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SubmitView(
+	long long frameNumber, int viewIndex, int viewCount,
+	const unsigned char* input, int inwidth, int inheight, int inpitch,
+	unsigned char* output, int outpitch, bool* batchDone, bool debug_flag)
+{
+	try
+	{
+		shared_ptr<OpenVinoSession> session = DefaultCpuSession();
+
+		if (input == nullptr || output == nullptr || batchDone == nullptr || inpitch < inwidth * 4 || outpitch <= 0)
+			throw std::invalid_argument("Invalid input or output frame");
+
+		last_error.clear();
+		*batchDone = session->data->SubmitView(frameNumber, viewIndex, viewCount,
+			input, inwidth, inheight, inpitch, output, outpitch, debug_flag);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method waits until the batch of a frame ran. When views of the frame are still missing
+* at the timeout, the batch runs with the views submitted so far.
+* @param frameNumber, frame passed to "OpenVino_SubmitView"
+* @param timeoutMs, time to wait for missing views, 0 to run the batch right away
+* @param done, true if the outputs of the frame are written
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_WaitViews(
+	long long frameNumber, int timeoutMs, bool* done, bool debug_flag)
+{
+	try
+	{
+		shared_ptr<OpenVinoSession> session = DefaultCpuSession();
+
+		if (done == nullptr)
+			throw std::invalid_argument("Invalid done flag");
+
+		last_error.clear();
+		*done = session->data->WaitViews(frameNumber, timeoutMs, debug_flag);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+* @brief This method is used to infer results, based on loaded model (see "OpenVino_Initialize")
+* and based on image loaded from "filePath".
+* @param filePath path to the file to be analysed
+* @param outwidth, image width after style transfer
+* @param outheight, image height after style transfer
+* @param output, image data after style transfer
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_Infer_FromFile(
+	char* filePath, int* outwidth, int* outheight, float* output)
+{
+	try
+	{
+		shared_ptr<OpenVinoSession> session = DefaultSession();
+		if (!session)
+			throw std::invalid_argument("OpenVINO has not been initialized");
+
+		if (filePath == nullptr)
+			throw std::invalid_argument("File path passed was null");
+
+		// Actual Infer call passed to OpenVinoData
+		session->data->Infer(filePath, outwidth, outheight, output);
+
+		return true;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+/*
+ * @brief This method is used to get last error message that any of the other methods might have set.
+ * @param lastErrorMessage user-allocated buffer into which error message will be copied
+ * @param maxLength length of buffer in lastErrorMessage
+ * @return true if call is successfull or false if not
+ */
+DLLEXPORT
+bool __cdecl
+OpenVino_GetLastError(
+	char* lastErrorMessage,
+	size_t maxLength)
+{
+	if (lastErrorMessage == nullptr)
+		return false;
+
+	if (last_error.length() >= maxLength)
+		return false;
+
+	strcpy_s(lastErrorMessage, maxLength, last_error.c_str());
+
+	return true;
+}
+
+/*
+* @brief This method is called to make initialization of the OpenVino library and load the
+* models based on files specified in "modelXmlFilePath", "modelBinFilePath" and "d3dDevice".
+* @param modelXmlFilePath Path to, for example: style_transfer.xml
+* @param modelBinFilePath Path to, for example: style_transfer.bin
+* @param d3dDevice
+* @param inferWidth, inference width
+* @param inferHeight, inference height
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_Initialize_BaseOCL(
+	LPCSTR modelXmlFilePath,
+	LPCSTR modelBinFilePath,
+	void* d3dDevice,
+	int inferWidth,
+	int inferHeight)
+{
+	try
+	{
+		if (modelXmlFilePath == nullptr ||
+			modelBinFilePath == nullptr)
+			throw invalid_argument("One of the file paths passed was null");
+
+		last_error.clear();
+		CancelBackgroundInitialization();
+		// CPU mode sessions are of no use in OpenCL mode
+		ClearSessionCache();
+		ClearLadderRungs();
+		ID3D11Device* dxDevice = (ID3D11Device*)d3dDevice;
+		
+
+		// OpenVinoData structure does actual processing:
+		auto session = std::make_shared<OpenVinoSession>();
+		session->data = std::make_unique<OpenVinoData>();
+		session->is_ocl = true;
+		//Create opencl context
+		session->data->Create_OCLCtx(dxDevice);
+		
+		// Forward initialization to OpenVinoData:
+		session->data->Initialize_BaseOCL(modelXmlFilePath,inferWidth, inferHeight, CurrentInferenceConfig());
+		// Save it for use in later calls:
+		lock_guard<mutex> lock(defaultSessionMutex);
+		defaultSession = std::move(session);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+
+DLLEXPORT
+bool __cdecl
+OpenVino_Infer_FromDXData(
+	void* input_surface,
+	void* output_surface,
+	int surfaceWidth,
+	int surfaceHeight, 
+	bool debug_flag)
+{
+	shared_ptr<OpenVinoSession> session = DefaultSession();
+	if (!session || !session->is_ocl)
+		return false;
+
+	try
+	{
+
+		ID3D11Texture2D* input_dxdata = (ID3D11Texture2D*)input_surface;
+		ID3D11Texture2D* output_dxdata = (ID3D11Texture2D*)output_surface;
+		// Actual Infer call passed to OpenVinoData
+		session->data->Infer(input_dxdata, output_dxdata, surfaceWidth,surfaceHeight,debug_flag);
+
+		return true;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
+}
+
+DLLEXPORT
+bool __cdecl
+OpenVino_GetSuitableSTsize(
+	int inputWidth,
+	int inputHeight,
+	int* expectedWidth,
+	int* expectedHeight)
+{
+	try
+	{
+		last_error.clear();
+		*expectedWidth = (int)floor((inputWidth + 3) / 4.0) * 4;
+		*expectedHeight = (int)floor((inputHeight + 3) / 4.0) * 4;
+
+		if (*expectedWidth == inputWidth
+			&& *expectedHeight == inputHeight)
+		{
+			std::cout << "The original input shape (width, height) is not suitable:" << to_string(inputWidth) << "," << to_string(inputHeight) << std::endl;
+			std::cout << ";try new input shape (width, height) :" << to_string(*expectedWidth) << "," << to_string(*expectedHeight) << std::endl;
+		}
+		modelWidth = *expectedWidth;
+		modelHeight = *expectedHeight;
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "Cannot get sutitable size";
+
+		return false;
+	}	
+}
+
+DLLEXPORT
+bool __cdecl
+OpenVINO_GetCurrentSTsize(
+	int* width,
+	int* height)
+{
+	try
+	{
+		last_error.clear();
+		*width = modelWidth;
+		*height = modelHeight;
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "Cannot get current style transfer size";
+		return false;
+	}
+}
+
+DLLEXPORT
+bool __cdecl
+OpenVino_Release()
+{
+	try
+	{
+		last_error.clear();
+		// the loading threads use the shared OpenVINO core, they are done before a release returns
+		JoinBackgroundInitialization();
+		JoinLadderLoader();
+		ClearSessionCache();
+		shared_ptr<OpenVinoSession> session;
+		{
+			lock_guard<mutex> lock(defaultSessionMutex);
+			std::swap(session, defaultSession);
+		}
+		// released here unless another thread is still inside a call on it
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "OpenVINO Release Failed";
+
+		return false;
+	}
+}
 
 /*
- * @brief This method is called to make initialization of the OpenVino library and load the
- * models based on files specified in "modelXmlFilePath", "modelBinFilePath" and "modelLabelFilePath".
- * @param modelXmlFilePath Path to, for example: squeezenet1.1.xml
- * @param modelBinFilePath Path to, for example: squeezenet1.1.bin
- * @param modelLabelFilePath Path to, for example: squeezenet1.1.labels
- * @return true if call is successfull or false if not
- */
+* @brief This method loads a model into a new session, independent of the default session and of
+* other sessions. Settings made with "OpenVino_SetProcessingInGraph", "OpenVino_SetTiling",
+* "OpenVino_SetThroughputMode" and "OpenVino_SetProperty" before the call apply to it.
+* @param modelXmlFilePath Path to, for example: style_transfer.xml
+* @param modelBinFilePath Path to, for example: style_transfer.bin
+* @param inferWidth, inference width
+* @param inferHeight, inference height
+* @param devicename, OpenVINO device, for example: CPU
+* @return handle of the session, or null if the call failed
+*/
 DLLEXPORT
-bool __cdecl 
-OpenVino_Initialize(
+OpenVinoSessionHandle __cdecl
+OpenVino_CreateSession(
 	LPCSTR modelXmlFilePath,
 	LPCSTR modelBinFilePath,
 	int inferWidth,
@@ -60,65 +2257,63 @@ OpenVino_Initialize(
 {
 	try
 	{
-		if (modelXmlFilePath == nullptr ||
-			modelBinFilePath == nullptr)
-			throw invalid_argument("One of the file paths passed was null");
-
 		last_error.clear();
 
-		// OpenVinoData structure does actual processing:
-		auto ptr = std::make_unique<OpenVinoData>();
-		// Forward initialization to OpenVinoData:
-		ptr->Initialize(modelXmlFilePath, modelBinFilePath, inferWidth, inferHeight, devicename);
-		// Save it for use in later calls:
-		initializedData = std::move(ptr);
-
-		return true;
+		unique_ptr<OpenVinoSession> session = CreateCpuSession(modelXmlFilePath, modelBinFilePath, inferWidth, inferHeight, devicename);
+		// the handle owns the session until "OpenVino_DestroySession"
+		return session.release();
 	}
 	catch (std::exception& ex)
 	{
 		last_error = ex.what();
 
-		return false;
+		return nullptr;
 	}
 	catch (...)
 	{
 		last_error = "General error";
 
-		return false;
+		return nullptr;
 	}
 }
 
-
 /*
-* @brief This method is used to infer results, based on loaded model (see "OpenVino_Initialize")
-* and based on texture rendered by engine.
-* @param texture data
+* @brief This method is used to infer results of a session, based on BGRA frame captured by engine.
+* Sessions run concurrently; calls on the same session are serialized.
+* @param session, handle returned by "OpenVino_CreateSession"
+* @param input, BGRA texture data
 * @param inwidth, texture width
 * @param inheight, texture height
-* @param outwidth, image width after style transfer
-* @param outheight, image height after style transfer
-* @param output, image data after style transfer
+* @param inpitch, distance in bytes between two rows of input
+* @param output, BGRA image data after style transfer, at the resolution of the session
+* @param outpitch, distance in bytes between two rows of output
 * @return true if call is successfull or false if not
 */
 DLLEXPORT
 bool __cdecl
-OpenVino_Infer_FromTexture(
-	unsigned char* input, int inwidth, int inheight,  unsigned char* out, bool debug_flag)
+OpenVino_InferSession(
+	OpenVinoSessionHandle session,
+	const unsigned char* input, int inwidth, int inheight, int inpitch, unsigned char* output, int outpitch, bool debug_flag)
 {
 	try
 	{
-		if (!initializedData)
-			throw std::invalid_argument("OpenVINO has not been initialized");
+		if (session == nullptr)
+			throw std::invalid_argument("Invalid session");
 
-		/*if (filePath == nullptr)
-			throw std::invalid_argument("File path passed was null");*/
+		if (input == nullptr || output == nullptr || inpitch < inwidth * 4 || outpitch <= 0)
+			throw std::invalid_argument("Invalid input or output frame");
 
-		// Actual Infer call passed to OpenVinoData
-		initializedData->Infer(input, inwidth, inheight, out, debug_flag);
+		last_error.clear();
+		session->data->InferBGRA(input, inwidth, inheight, inpitch, output, outpitch, debug_flag);
 
 		return true;
 	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
 	catch (...)
 	{
 		last_error = "General error";
@@ -128,102 +2323,119 @@ OpenVino_Infer_FromTexture(
 }
 
 /*
-* @brief This method is used to infer results, based on loaded model (see "OpenVino_Initialize")
-* and based on image loaded from "filePath".
-* @param filePath path to the file to be analysed
-* @param outwidth, image width after style transfer
-* @param outheight, image height after style transfer
-* @param output, image data after style transfer
+* @brief This method releases a session created by "OpenVino_CreateSession". No other call may use
+* the handle during or after this call.
+* @param session, handle returned by "OpenVino_CreateSession"
 * @return true if call is successfull or false if not
 */
 DLLEXPORT
 bool __cdecl
-OpenVino_Infer_FromFile(
-	char* filePath, int* outwidth, int* outheight, float* output)
+OpenVino_DestroySession(
+	OpenVinoSessionHandle session)
 {
 	try
 	{
-		if (!initializedData)
-			throw std::invalid_argument("OpenVINO has not been initialized");
-
-		if (filePath == nullptr)
-			throw std::invalid_argument("File path passed was null");
+		if (session == nullptr)
+			throw std::invalid_argument("Invalid session");
 
-		// Actual Infer call passed to OpenVinoData
-		initializedData->Infer(filePath, outwidth, outheight, output);
+		last_error.clear();
+		delete session;
 
 		return true;
 	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
 	catch (...)
 	{
-		last_error = "General error";
+		last_error = "OpenVINO Release Failed";
 
 		return false;
 	}
 }
 
 /*
- * @brief This method is used to get last error message that any of the other methods might have set.
- * @param lastErrorMessage user-allocated buffer into which error message will be copied
- * @param maxLength length of buffer in lastErrorMessage
- * @return true if call is successfull or false if not
- */
+* @brief This method reads the live statistics of the default session without blocking inference
+* @param stats, statistics of the session
+* @return true if call is successfull or false if not
+*/
 DLLEXPORT
 bool __cdecl
-OpenVino_GetLastError(
-	char* lastErrorMessage,
-	size_t maxLength)
+OpenVino_GetStats(
+	OpenVinoStats* stats)
 {
-	if (lastErrorMessage == nullptr)
-		return false;
+	try
+	{
+		shared_ptr<OpenVinoSession> session = DefaultSession();
+		if (!session)
+			throw std::invalid_argument("OpenVINO has not been initialized");
 
-	if (last_error.length() >= maxLength)
-		return false;
+		if (stats == nullptr)
+			throw std::invalid_argument("Invalid statistics output");
 
-	strcpy_s(lastErrorMessage, maxLength, last_error.c_str());
+		// frames of a lower rung of the resolution ladder are timed by its session
+		shared_ptr<OpenVinoSession> active = session;
+		int rung = 0;
+		double budget_ms = 0.0;
+		double frame_ms = 0.0;
+		{
+			lock_guard<mutex> lock(resolutionLadder->ladder_mutex);
+			const ResolutionLadder& ladder = *resolutionLadder;
+			budget_ms = ladder.controller.GetBudget();
+			if (ladder.has_base && ladder.base == session->key)
+			{
+				rung = ladder.controller.GetRung();
+				frame_ms = ladder.controller.GetFrameMs();
+				if (rung > 0 && ladder.rungs[rung])
+					active = ladder.rungs[rung];
+			}
+		}
 
-	return true;
+		FillStats(*active, stats);
+		stats->resolution_rung = rung;
+		stats->frame_budget_ms = budget_ms;
+		stats->frame_ms = frame_ms;
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
+		return false;
+	}
 }
 
 /*
-* @brief This method is called to make initialization of the OpenVino library and load the
-* models based on files specified in "modelXmlFilePath", "modelBinFilePath" and "d3dDevice".
-* @param modelXmlFilePath Path to, for example: style_transfer.xml
-* @param modelBinFilePath Path to, for example: style_transfer.bin
-* @param d3dDevice
-* @param inferWidth, inference width
-* @param inferHeight, inference height
+* @brief This method reads the live statistics of a session without blocking inference
+* @param session, handle returned by "OpenVino_CreateSession"
+* @param stats, statistics of the session
 * @return true if call is successfull or false if not
 */
 DLLEXPORT
 bool __cdecl
-OpenVino_Initialize_BaseOCL(
-	LPCSTR modelXmlFilePath,
-	LPCSTR modelBinFilePath,
-	void* d3dDevice,
-	int inferWidth,
-	int inferHeight)
+OpenVino_GetSessionStats(
+	OpenVinoSessionHandle session,
+	OpenVinoStats* stats)
 {
 	try
 	{
-		if (modelXmlFilePath == nullptr ||
-			modelBinFilePath == nullptr)
-			throw invalid_argument("One of the file paths passed was null");
+		if (session == nullptr)
+			throw std::invalid_argument("Invalid session");
 
-		last_error.clear();
-		ID3D11Device* dxDevice = (ID3D11Device*)d3dDevice;
-		
+		if (stats == nullptr)
+			throw std::invalid_argument("Invalid statistics output");
 
-		// OpenVinoData structure does actual processing:
-		auto ptr = std::make_unique<OpenVinoData>();
-		//Create opencl context
-		ptr->Create_OCLCtx(dxDevice);
-		
-		// Forward initialization to OpenVinoData:
-		ptr->Initialize_BaseOCL(modelXmlFilePath,inferWidth, inferHeight);
-		// Save it for use in later calls:
-		initializedData = std::move(ptr);
-		isOCLInitialized = true;
+		FillStats(*session, stats);
 
 		return true;
 	}
@@ -241,31 +2453,71 @@ OpenVino_Initialize_BaseOCL(
 	}
 }
 
-
+/*
+* @brief This method limits the folder of compiled models, the least recently used ones are deleted
+* when it grows over the limit.
+* @param megabytes, size of all compiled models together, 0 to compile every time
+* @return true if call is successfull or false if not
+*/
 DLLEXPORT
 bool __cdecl
-OpenVino_Infer_FromDXData(
-	void* input_surface,
-	void* output_surface,
-	int surfaceWidth,
-	int surfaceHeight, 
-	bool debug_flag)
+OpenVino_SetCacheLimit(
+	int megabytes)
 {
-	if (!isOCLInitialized)
+	try
+	{
+		if (megabytes < 0)
+			throw std::invalid_argument("Invalid cache limit");
+
+		OpenVinoData::SetModelCacheLimit(static_cast<uint64_t>(megabytes) * 1024 * 1024);
+
+		return true;
+	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
+	catch (...)
+	{
+		last_error = "General error";
+
 		return false;
+	}
+}
 
+/*
+* @brief This method sets how many replaced CPU mode default sessions stay loaded for a switch back,
+* the least recently used ones are released beyond it.
+* @param count, number of cached sessions, 0 to release replaced sessions right away
+* @return true if call is successfull or false if not
+*/
+DLLEXPORT
+bool __cdecl
+OpenVino_SetSessionCacheSize(
+	int count)
+{
 	try
 	{
-		if (!initializedData)
-			throw std::invalid_argument("OpenVINO has not been initialized");
+		if (count < 0)
+			throw std::invalid_argument("Invalid session cache size");
 
-		ID3D11Texture2D* input_dxdata = (ID3D11Texture2D*)input_surface;
-		ID3D11Texture2D* output_dxdata = (ID3D11Texture2D*)output_surface;
-		// Actual Infer call passed to OpenVinoData
-		initializedData->Infer(input_dxdata, output_dxdata, surfaceWidth,surfaceHeight,debug_flag);
+		list<shared_ptr<OpenVinoSession>> evicted;
+		{
+			lock_guard<mutex> lock(sessionCacheMutex);
+			sessionCacheSize = static_cast<size_t>(count);
+			EvictSessions(evicted);
+		}
 
 		return true;
 	}
+	catch (std::exception& ex)
+	{
+		last_error = ex.what();
+
+		return false;
+	}
 	catch (...)
 	{
 		last_error = "General error";
@@ -274,28 +2526,28 @@ OpenVino_Infer_FromDXData(
 	}
 }
 
+/*
+* @brief This method sets the memory the cached sessions may take together, beyond it the least
+* recently used ones are released.
+* @param megabytes, memory budget of the cached sessions
+* @return true if call is successfull or false if not
+*/
 DLLEXPORT
 bool __cdecl
-OpenVino_GetSuitableSTsize(
-	int inputWidth,
-	int inputHeight,
-	int* expectedWidth,
-	int* expectedHeight)
+OpenVino_SetSessionMemoryBudget(
+	int megabytes)
 {
 	try
 	{
-		last_error.clear();
-		*expectedWidth = (int)floor((inputWidth + 3) / 4.0) * 4;
-		*expectedHeight = (int)floor((inputHeight + 3) / 4.0) * 4;
+		if (megabytes < 0)
+			throw std::invalid_argument("Invalid session memory budget");
 
-		if (*expectedWidth == inputWidth
-			&& *expectedHeight == inputHeight)
+		list<shared_ptr<OpenVinoSession>> evicted;
 		{
-			std::cout << "The original input shape (width, height) is not suitable:" << to_string(inputWidth) << "," << to_string(inputHeight) << std::endl;
-			std::cout << ";try new input shape (width, height) :" << to_string(*expectedWidth) << "," << to_string(*expectedHeight) << std::endl;
+			lock_guard<mutex> lock(sessionCacheMutex);
+			sessionMemoryBudget = static_cast<uint64_t>(megabytes) * 1024 * 1024;
+			EvictSessions(evicted);
 		}
-		modelWidth = *expectedWidth;
-		modelHeight = *expectedHeight;
 
 		return true;
 	}
@@ -307,23 +2559,47 @@ OpenVino_GetSuitableSTsize(
 	}
 	catch (...)
 	{
-		last_error = "Cannot get sutitable size";
+		last_error = "General error";
 
 		return false;
-	}	
+	}
 }
 
+/*
+* @brief This method compiles a model for each resolution into the model cache, so later
+* initializations with the same model, device and settings import it instead of compiling. No session
+* is created; the OpenCL path needs its Direct3D device and is cached by its first initialization.
+* @param modelXmlFilePath Path to, for example: style_transfer.xml
+* @param modelBinFilePath Path to, for example: style_transfer.bin
+* @param devicename, device the model is compiled for
+* @param widths, inference widths
+* @param heights, inference heights
+* @param count, number of resolutions
+* @return true if call is successfull or false if not
+*/
 DLLEXPORT
 bool __cdecl
-OpenVINO_GetCurrentSTsize(
-	int* width,
-	int* height)
+OpenVino_WarmUpCache(
+	const char* modelXmlFilePath,
+	const char* modelBinFilePath,
+	const char* devicename,
+	const int* widths,
+	const int* heights,
+	int count)
 {
 	try
 	{
-		last_error.clear();
-		*width = modelWidth;
-		*height = modelHeight;
+		if (count < 0 || (count > 0 && (widths == nullptr || heights == nullptr)))
+			throw std::invalid_argument("Invalid resolutions");
+
+		for (int i = 0; i < count; i++)
+		{
+			SessionKey key = CpuSessionKey(modelXmlFilePath, modelBinFilePath, widths[i], heights[i], devicename);
+			// only the compiled model goes into the cache, no requests or tensors are created
+			OpenVinoData data;
+			data.Precompile(key.xml_path, key.width, key.height, key.device, key.config);
+		}
+
 		return true;
 	}
 	catch (std::exception& ex)
@@ -334,20 +2610,144 @@ OpenVINO_GetCurrentSTsize(
 	}
 	catch (...)
 	{
-		last_error = "Cannot get current style transfer size";
+		last_error = "General error";
+
 		return false;
 	}
 }
 
+/*
+ * @brief Frames the model variants are probed on: the images of a folder, or synthetic frames with
+ * smooth gradients, edges and fine detail when there is none
+ */
+static vector<cv::Mat>
+ProbeFrames(const char* framesFolder, int width, int height)
+{
+	const size_t max_frames = 8;
+	vector<cv::Mat> frames;
+	if (framesFolder != nullptr && *framesFolder != '\0')
+	{
+		vector<filesystem::path> images;
+		for (const auto& entry : filesystem::directory_iterator(framesFolder))
+		{
+			string extension = entry.path().extension().string();
+			transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+			if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp")
+				images.push_back(entry.path());
+		}
+		// the same frames in the same order on every run
+		sort(images.begin(), images.end());
+		for (const auto& image : images)
+		{
+			if (frames.size() == max_frames)
+				break;
+			cv::Mat bgr = cv::imread(image.string());
+			if (bgr.empty())
+				continue;
+			cv::Mat bgra;
+			cv::cvtColor(bgr, bgra, cv::COLOR_BGR2BGRA);
+			frames.push_back(bgra);
+		}
+		if (frames.empty())
+			throw std::invalid_argument(string("No image to probe the model variants on in ") + framesFolder);
+		return frames;
+	}
+
+	for (int i = 0; i < 4; i++)
+	{
+		cv::Mat frame(height, width, CV_8UC4);
+		for (int y = 0; y < height; y++)
+		{
+			unsigned char* row = frame.data + y * frame.step;
+			for (int x = 0; x < width; x++)
+			{
+				bool checker = ((x >> (3 + i)) + (y >> (3 + i))) & 1;
+				row[x * 4 + 0] = static_cast<unsigned char>(255 * x / max(1, width - 1));
+				row[x * 4 + 1] = static_cast<unsigned char>(255 * y / max(1, height - 1));
+				row[x * 4 + 2] = static_cast<unsigned char>(checker ? 200 : 40 + 50 * i);
+				row[x * 4 + 3] = 255;
+			}
+		}
+		frames.push_back(frame);
+	}
+	return frames;
+}
+
+/*
+* @brief This method picks the fastest variant of a style within a quality tolerance of the first one,
+* and applies its precision hint to later initializations.
+* @param chosenIndex, index of the chosen model files
+* @param chosenPrecision, precision hint of the chosen variant, empty for the plugin default
+* @return true if call is successfull or false if not
+*/
 DLLEXPORT
 bool __cdecl
-OpenVino_Release()
+OpenVino_SelectVariant(
+	const char* const* modelXmlFilePaths,
+	const char* const* modelBinFilePaths,
+	int count,
+	const char* precisions,
+	int width,
+	int height,
+	const char* devicename,
+	const char* framesFolder,
+	float minPsnr,
+	float minSsim,
+	int* chosenIndex,
+	char* chosenPrecision,
+	size_t maxLength)
 {
 	try
 	{
+		if (count <= 0 || modelXmlFilePaths == nullptr || modelBinFilePaths == nullptr)
+			throw std::invalid_argument("No model variant");
+		if (devicename == nullptr || chosenIndex == nullptr || chosenPrecision == nullptr)
+			throw std::invalid_argument("Device or results were null");
+		if (width <= 0 || height <= 0)
+			throw std::invalid_argument("Invalid resolution");
+
+		vector<string> hints;
+		string list = precisions != nullptr ? precisions : "";
+		for (size_t begin = 0; begin <= list.size();)
+		{
+			size_t end = min(list.find(',', begin), list.size());
+			hints.push_back(list.substr(begin, end - begin));
+			begin = end + 1;
+		}
+
+		// every model file with every hint, the first model file with the first hint is the reference
+		vector<ModelVariant> variants;
+		for (int i = 0; i < count; i++)
+		{
+			for (const string& hint : hints)
+				variants.push_back({ modelXmlFilePaths[i], modelBinFilePaths[i], hint });
+		}
+
+		static VariantProbe probe(CreateCacheDir("variant_probe"));
+		InferenceConfig config = CurrentInferenceConfig();
+		vector<VariantScore> scores;
+		bool cached = false;
+		int chosen = probe.Select(variants, width, height, devicename, config, ProbeFrames(framesFolder, width, height),
+			minPsnr, minSsim, &scores, &cached);
+		const ModelVariant& variant = variants[chosen];
+		if (variant.precision.length() >= maxLength)
+			throw std::invalid_argument("Precision does not fit the buffer");
+		if (cached)
+			clog << "Variant " << variant.xml_path << " " << variant.precision << " chosen by an earlier probe" << endl;
+
+		{
+			lock_guard<mutex> lock(inferenceConfigMutex);
+			if (variant.precision.empty())
+				inferenceConfig.properties.erase(ov::hint::inference_precision.name());
+			else
+				inferenceConfig.properties[ov::hint::inference_precision.name()] = variant.precision;
+		}
+
 		last_error.clear();
-		isOCLInitialized = false;
-		initializedData = nullptr;
+		*chosenIndex = chosen / static_cast<int>(hints.size());
+		strcpy_s(chosenPrecision, maxLength, variant.precision.c_str());
+
+		return true;
 	}
 	catch (std::exception& ex)
 	{
@@ -357,7 +2757,7 @@ OpenVino_Release()
 	}
 	catch (...)
 	{
-		last_error = "OpenVINO Release Failed";
+		last_error = "General error";
 
 		return false;
 	}
@@ -37,11 +37,57 @@ embedded in Materials by Intel or Intel's suppliers or licensors in any way."
 #include <d3d11.h>
 #endif
 
+/**
+ * Opaque handle of a session: one loaded model at one resolution, see "OpenVino_CreateSession"
+ */
+typedef struct OpenVinoSession* OpenVinoSessionHandle;
+
+/**
+ * Times of one pipeline stage in ms over the most recent 256 frames, see "OpenVino_GetStats"
+ */
+typedef struct OpenVinoStageStats
+{
+	unsigned long long count;   // frames that passed the stage since initialization
+	double min_ms;
+	double mean_ms;
+	double p95_ms;
+	double max_ms;
+} OpenVinoStageStats;
+
+/**
+ * Live statistics of a session. Stages a path does not have, e.g. preprocessing when it runs
+ * inside the graph, keep a count of 0.
+ */
+typedef struct OpenVinoStats
+{
+	OpenVinoStageStats capture_handoff; // from the call until the frame is in an input tensor, waiting included
+	OpenVinoStageStats preprocess;      // host side conversion into the input tensor
+	OpenVinoStageStats infer;
+	OpenVinoStageStats postprocess;     // host side conversion of the output tensor
+	OpenVinoStageStats output_copy;     // copy of the result into the caller's buffer or texture
+	double load_ms;                     // last model compilation
+	unsigned long long loads;
+	unsigned long long cache_hits;      // compilations imported from the model cache
+	unsigned long long cache_misses;
+	unsigned long long frames_checked;  // frames compared by the change detector, see "OpenVino_SetChangeThreshold"
+	unsigned long long frames_skipped;  // of them, frames answered with the previous result
+	unsigned long long tiles_total;     // tiles of frames that only infer changed tiles, see "OpenVino_SetDirtyTileThreshold"
+	unsigned long long tiles_inferred;  // of them, tiles inferred again
+	int resolution_rung;                // rung of the resolution ladder frames run at, 0 for the resolution of the session
+	int inference_width;                // resolution frames are inferred at, rescaled to the session's
+	int inference_height;
+	double frame_budget_ms;             // see "OpenVino_SetFrameBudget", 0 if none is set
+	double frame_ms;                    // mean latency of the frames the last rung decision was based on
+} OpenVinoStats;
+
 extern "C"
 {
 	/**
 	 * All methods use C-style calls, returning true on success and fail, while setting last error.
 	 * All output data is pre-initialized on caller side and passed into the calls.
+	 * The last error is kept per calling thread. Methods without session handle work on a default
+	 * session created by "OpenVino_Initialize" or "OpenVino_Initialize_BaseOCL"; any number of
+	 * further sessions can be used concurrently from different threads.
 	 */
 
 	/*
@@ -59,6 +105,64 @@ extern "C"
 		int inferHeight,
 		const char* devicename);
 
+	/*
+	* @brief This method loads a model into the default session like "OpenVino_Initialize", but on a
+	* background thread: the model is read, compiled and run on a few warm-up frames there, so neither
+	* the call nor the first frame stalls the caller. The previous default session, if any, keeps running
+	* until "OpenVino_IsReady" swaps the new one in. A new request supersedes one still loading;
+	* "OpenVino_Initialize", "OpenVino_Initialize_BaseOCL" and "OpenVino_Release" cancel it.
+	* @param modelXmlFilePath Path to, for example: style_transfer.xml
+	* @param modelBinFilePath Path to, for example: style_transfer.bin
+	* @param inferWidth, inference width
+	* @param inferHeight, inference height
+	* @param devicename, device the model is compiled for
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_InitializeAsync(
+		const char* modelXmlFilePath,
+		const char* modelBinFilePath,
+		int inferWidth,
+		int inferHeight,
+		const char* devicename);
+
+	/*
+	* @brief This method reports the progress of "OpenVino_InitializeAsync", call it once per frame.
+	* A loaded session replaces the default session in the call that reports it ready, so callers
+	* resize their buffers there, before the next frame.
+	* @param ready, true once the default session is loaded and no initialization is in progress
+	* @param progress, fraction of the loading steps done (compilation, then each warm-up frame), 1 when ready
+	* @return true if call is successfull, false if the background initialization failed; the previous
+	* default session stays in place then
+	*/
+	DLLEXPORT bool OpenVino_IsReady(
+		bool* ready,
+		float* progress);
+
+	/*
+	* @brief This method registers a style IR under a name, for "OpenVino_SetStyle". Registering a name
+	* again replaces its files for later switches.
+	* @param name, name of the style
+	* @param modelXmlFilePath Path to, for example: style_transfer.xml
+	* @param modelBinFilePath Path to, for example: style_transfer.bin
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_RegisterStyle(
+		const char* name,
+		const char* modelXmlFilePath,
+		const char* modelBinFilePath);
+
+	/*
+	* @brief This method switches the CPU mode default session to a registered style, at the resolution
+	* and device it runs with (or is loading with). It works like "OpenVino_InitializeAsync": the current
+	* style keeps running until "OpenVino_IsReady" swaps the new one in. Styles used before stay loaded
+	* in the session cache, each with its own infer requests, so switching back to them takes effect with
+	* the next "OpenVino_IsReady"; all sessions share one OpenVINO runtime and the compiled model cache.
+	* @param name, name given to "OpenVino_RegisterStyle"
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetStyle(
+		const char* name);
+
 	/*
 	 * @brief This method is used to infer results, based on loaded model (see "OpenVino_Initialize")
 	 * and based on image loaded from "filePath".
@@ -84,6 +188,314 @@ extern "C"
 	DLLEXPORT bool OpenVino_Infer_FromTexture(
 		unsigned char* input, int inwidth, int inheight,  unsigned char* output, bool debug_flag);
 
+	/*
+	* @brief This method is used to infer results, based on loaded model (see "OpenVino_Initialize")
+	* and based on BGRA frame captured by engine, without any repacking on caller side.
+	* @param input, BGRA texture data
+	* @param inwidth, texture width
+	* @param inheight, texture height
+	* @param inpitch, distance in bytes between two rows of input
+	* @param output, BGRA image data after style transfer, can be uploaded to a texture as-is
+	* @param outpitch, distance in bytes between two rows of output
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_Infer_FromBGRA(
+		const unsigned char* input, int inwidth, int inheight, int inpitch, unsigned char* output, int outpitch, bool debug_flag);
+
+	/*
+	* @brief This method works as "OpenVino_Infer_FromBGRA" into an output of a given size. The result is
+	* rescaled if the default session has another size, e.g. while a session of a new size is swapped in,
+	* so a thread inferring next to the one that swaps sessions never writes past its output.
+	* @param outwidth, width of output
+	* @param outheight, height of output
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_Infer_FromBGRAToSize(
+		const unsigned char* input, int inwidth, int inheight, int inpitch, unsigned char* output, int outwidth, int outheight, int outpitch, bool debug_flag);
+
+	/*
+	* @brief This method chooses where CPU mode converts frames: inside the compiled graph (default),
+	* or with the fused host kernels. Applied by the next "OpenVino_Initialize"; devices other than
+	* CPU always use the host kernels.
+	* @param inGraph, true to convert inside the compiled graph
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetProcessingInGraph(
+		bool inGraph);
+
+	/*
+	* @brief This method makes CPU mode run the model on square tiles with overlapping halos instead
+	* of whole frames, which keeps memory and latency bounded at 1440p and 4K model resolutions.
+	* Tiles run in parallel CPU streams and neighbours are cross-faded over the halo. Needs in-graph
+	* processing; asynchronous frames and zero-copy buffers are not available while tiling.
+	* Applied by the next "OpenVino_Initialize".
+	* @param size, tile size in pixels at model resolution, 0 to run whole frames
+	* @param halo, pixels of context around each tile, negative to use the receptive field of the model
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetTiling(
+		int size, int halo);
+
+	/*
+	* @brief This method makes CPU mode compile for throughput: the CPU is split into streams and
+	* consecutive frames of the asynchronous API run side by side, one per stream. Results are still
+	* collected strictly in submission order. A deeper queue raises throughput at the cost of latency,
+	* see "OpenVino_GetThroughputStats". Applied by the next "OpenVino_Initialize"; ignored while tiling.
+	* @param streams, number of CPU streams, 0 to compile for latency (default)
+	* @param queueDepth, frames that may be in flight, 0 for one per stream
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetThroughputMode(
+		int streams, int queueDepth);
+
+	/*
+	* @brief This method keeps CPU mode inference off the cores of the game, render and RHI threads. The
+	* streams of the model get as many threads as the set has processors, and the TBB workers running
+	* them and the host kernels are pinned to it. The model is compiled and its tensors allocated on a
+	* thread pinned to the set, so memory is local to its NUMA node. TBB workers are shared by the process
+	* and are pinned once the model compiled; while CPU sessions of another core set are live, e.g. cached
+	* ones, they stay on that set and a warning is logged. An explicit AFFINITY or
+	* INFERENCE_NUM_THREADS (see "OpenVino_SetProperty") overrides the pinning of OpenVINO itself.
+	* Applied by the next "OpenVino_Initialize".
+	* @param coreSet, "P" or "E" for the performance or efficiency cores of a hybrid CPU, "numa:N" for
+	* the processors of NUMA node N, logical processors and ranges such as "0-7,16", or empty for all
+	* cores (default)
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetCoreSet(
+		const char* coreSet);
+
+	/*
+	* @brief This method tunes an OpenVINO property of the model, on the CPU and the OpenCL path.
+	* Before "OpenVino_Initialize" it is applied by the next initialization. Afterwards the model is
+	* compiled again in the background and swapped in between two frames, so tuning never stalls
+	* rendering; the model keeps running with the old properties until then, and for good if the new
+	* ones fail to compile. Explicit properties override "OpenVino_SetThroughputMode".
+	* @param name, PERFORMANCE_HINT, NUM_STREAMS, INFERENCE_NUM_THREADS, INFERENCE_PRECISION_HINT,
+	* AFFINITY (CPU pinning) or PERFORMANCE_HINT_NUM_REQUESTS
+	* @param value, value as OpenVINO prints it, e.g. THROUGHPUT, 4, f32, CORE; empty for the plugin default
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetProperty(
+		const char* name, const char* value);
+
+	/*
+	* @brief This method reads an OpenVINO property accepted by "OpenVino_SetProperty": as the compiled
+	* model applies it once initialized (a recompilation in progress is not reflected yet), the
+	* requested value before.
+	* @param name, property name
+	* @param value, buffer receiving the value
+	* @param maxLength, size of the buffer
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_GetProperty(
+		const char* name, char* value, size_t maxLength);
+
+	/*
+	* @brief This method chooses how the host kernels map model output onto 8 bit BGRA results:
+	* the fixed (-1,1) range of the model (default), or a running estimate of its min/max. The running range
+	* is an error while the graph processes frames, see "OpenVino_SetProcessingInGraph".
+	* @param runningRange, true to follow the running min/max estimate
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetRunningOutputRange(
+		bool runningRange);
+
+	/*
+	* @brief This method makes "OpenVino_Infer_FromBGRA" skip frames that barely differ from the last
+	* inferred one and return its result again, e.g. while the camera is still in menus, pauses or
+	* cutscene holds. Every 4th pixel of every 4th row is compared by its luma; "OpenVino_GetStats"
+	* reports how many frames were skipped. Applies to the default session and the rungs of its
+	* resolution ladder, until it is replaced.
+	* @param threshold, mean absolute luma difference in (0,255) below which a frame counts as
+	* unchanged, e.g. 1.5; 0 to infer every frame (default)
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetChangeThreshold(
+		float threshold);
+
+	/*
+	* @brief This method makes tiled inference (see "OpenVino_SetTiling") run only the tiles whose
+	* window, halo included, changed since they were last inferred, e.g. the HUD and the moving parts
+	* of a scene under a still camera. The other tiles keep their previous result and all of them are
+	* composed with the usual seam blending; "OpenVino_GetStats" reports the tiles inferred again.
+	* Applies to the default session and the rungs of its resolution ladder, until it is replaced.
+	* @param threshold, mean absolute luma difference in (0,255) of a window below which its tile
+	* counts as unchanged, e.g. 2; 0 to run every tile (default)
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetDirtyTileThreshold(
+		float threshold);
+
+	/*
+	* @brief This method sets a frame time budget for "OpenVino_Infer_FromBGRA" on the default session.
+	* The latency of each frame is measured and, when it stays over the budget, frames are inferred at
+	* the next lower rung of the resolution ladder (see "OpenVino_SetResolutionLadder") and rescaled to
+	* the size of the default session, so outputs keep their size. A higher rung is tried again once its
+	* predicted latency is well within the budget; a rung that fails again is tried less often, so the
+	* resolution does not oscillate. The rungs are loaded in the background; "OpenVino_GetStats"
+	* reports the rung, the inference resolution and the measured frame time. CPU mode only.
+	* @param budgetMs, time a frame may take in ms, e.g. 33 for 30 fps; 0 to always infer at the
+	* resolution of the default session (default)
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetFrameBudget(
+		float budgetMs);
+
+	/*
+	* @brief This method sets the rungs of the resolution ladder below the default session, as scales
+	* of its resolution rounded to multiples of 4, e.g. { 0.75, 0.5 }. Each rung is a session of its own,
+	* loaded next to the default session once a frame budget is set, and again whenever the default
+	* session is replaced. Applies to later frames; settings made before are kept across releases.
+	* @param scales, scales in (0,1), in any order
+	* @param count, number of scales, 0 to keep the resolution of the default session
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetResolutionLadder(
+		const float* scales,
+		int count);
+
+	/*
+	* @brief This method sets how many frames can be in flight in the asynchronous API (default 2).
+	* It must be called after "OpenVino_Initialize"; frames still in flight are discarded.
+	* @param framesInFlight, number of infer requests in the pool
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetFramesInFlight(
+		int framesInFlight);
+
+	/*
+	* @brief This method registers a caller owned BGRA buffer. When it is passed as input or output of
+	* "OpenVino_Infer_FromBGRA" or "OpenVino_SubmitFrameTo", inference reads or writes it in place.
+	* Zero-copy needs in-graph processing (see "OpenVino_SetProcessingInGraph"), 64 byte aligned data
+	* and rows without padding (pitch == width * 4); other buffers keep being copied.
+	* @param data, first pixel of the buffer
+	* @param width, frame width
+	* @param height, frame height
+	* @param pitch, distance in bytes between two rows
+	* @param zeroCopy, set to true if the buffer is used in place
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_RegisterFrameBuffer(
+		unsigned char* data, int width, int height, int pitch, bool* zeroCopy);
+
+	/*
+	* @brief This method forgets a registered buffer. It waits for running inferences that use it, so the
+	* caller may release the memory afterwards. A submitted frame whose result was written to the buffer
+	* and not yet collected is collected as an error.
+	* @param data, first pixel of the buffer
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_UnregisterFrameBuffer(
+		const unsigned char* data);
+
+	/*
+	* @brief This method preprocesses a frame and starts its inference without waiting for the result,
+	* based on loaded model (see "OpenVino_Initialize").
+	* @param input, BGRA texture data, same layout as in "OpenVino_Infer_FromBGRA"
+	* @param inwidth, texture width
+	* @param inheight, texture height
+	* @param inpitch, distance in bytes between two rows of input
+	* @param frameId, non-negative tag returned together with the result of this frame
+	* @return true if the frame was submitted, false if all frames are in flight or on error
+	*/
+	DLLEXPORT bool OpenVino_SubmitFrame(
+		const unsigned char* input, int inwidth, int inheight, int inpitch, long long frameId, bool debug_flag);
+
+	/*
+	* @brief This method works as "OpenVino_SubmitFrame", the result of the frame is written in place
+	* to a registered output buffer of model size.
+	* @param output, registered BGRA buffer, or null to copy the result when it is collected
+	* @param outpitch, distance in bytes between two rows of output
+	* @return true if the frame was submitted, false if all frames are in flight or on error
+	*/
+	DLLEXPORT bool OpenVino_SubmitFrameTo(
+		const unsigned char* input, int inwidth, int inheight, int inpitch, long long frameId,
+		unsigned char* output, int outpitch, bool debug_flag);
+
+	/*
+	* @brief This method collects the next frame submitted by "OpenVino_SubmitFrame", if it has finished.
+	* Frames are returned strictly in submission order.
+	* @param output, BGRA image data after style transfer
+	* @param outpitch, distance in bytes between two rows of output
+	* @param frameId, tag of the collected frame, or -1 if the next frame has not finished yet
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_TryGetResult(
+		unsigned char* output, int outpitch, long long* frameId, bool debug_flag);
+
+	/*
+	* @brief This method waits for the next frame submitted by "OpenVino_SubmitFrame", in submission order.
+	* @param output, BGRA image data after style transfer, may be null for frames submitted with an output buffer
+	* @param outpitch, distance in bytes between two rows of output
+	* @param frameId, tag of the collected frame, or -1 if the timeout expired or no frame is in flight
+	* @param timeoutMs, maximum time to wait, negative to wait without limit
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_WaitResult(
+		unsigned char* output, int outpitch, long long* frameId, int timeoutMs, bool debug_flag);
+
+	/*
+	* @brief This method reports achieved throughput against latency of collected frames, as running
+	* averages, to tune "OpenVino_SetThroughputMode" and "OpenVino_SetFramesInFlight".
+	* @param fps, delivered frames per second
+	* @param latencyMs, time from submission to delivery of a frame
+	* @param framesInFlight, frames submitted and not yet collected
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_GetThroughputStats(
+		double* fps, double* latencyMs, int* framesInFlight);
+
+	/*
+	* @brief This method is used to infer a batch of same-sized BGRA frames, e.g. the views of a stereo
+	* or split-screen frame, in one inference, which is faster than one inference per view. The model is
+	* compiled for each batch size on first use; on devices other than CPU frames are resized to the
+	* model resolution on the host. Not available while tiling.
+	* @param inputs, BGRA texture data of each frame
+	* @param count, number of frames
+	* @param inwidth, width of the frames
+	* @param inheight, height of the frames
+	* @param inpitch, distance in bytes between two rows of each input
+	* @param outputs, BGRA image data after style transfer of each frame
+	* @param outpitch, distance in bytes between two rows of each output
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_InferBatch(
+		const unsigned char* const* inputs, int count, int inwidth, int inheight, int inpitch,
+		unsigned char* const* outputs, int outpitch, bool debug_flag);
+
+	/*
+	* @brief This method coalesces the views of a frame, submitted one by one from any thread, into
+	* one "OpenVino_InferBatch" call. The input is copied right away; the batch runs when the last view
+	* of the frame is submitted, or when a view of a later frame arrives first.
+	* @param frameNumber, frame the view belongs to, increasing
+	* @param viewIndex, index of the view within the frame
+	* @param viewCount, number of views of the frame
+	* @param input, BGRA texture data of the view
+	* @param inwidth, texture width, the same for all views of a frame
+	* @param inheight, texture height
+	* @param inpitch, distance in bytes between two rows of input
+	* @param output, BGRA image data after style transfer, written when the batch runs
+	* @param outpitch, distance in bytes between two rows of output
+	* @param batchDone, true if this call ran the batch and all outputs of the frame are written
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SubmitView(
+		long long frameNumber, int viewIndex, int viewCount,
+		const unsigned char* input, int inwidth, int inheight, int inpitch,
+		unsigned char* output, int outpitch, bool* batchDone, bool debug_flag);
+
+	/*
+	* @brief This method waits until the batch of a frame submitted by "OpenVino_SubmitView" ran. When
+	* views of the frame are still missing at the timeout, the batch runs with the views submitted so far.
+	* @param frameNumber, frame passed to "OpenVino_SubmitView"
+	* @param timeoutMs, time to wait for missing views, 0 to run the batch right away
+	* @param done, true if the outputs of the frame are written
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_WaitViews(
+		long long frameNumber, int timeoutMs, bool* done, bool debug_flag);
+
 	/*
 	* @brief This method is used to infer results, based on loaded model (see "OpenVino_Initialize")
 	* and based on image loaded from "filePath".
@@ -151,7 +563,164 @@ extern "C"
 		int* height);
 
 	/*
-	* @brief This method is to manually release OpenVinoData instance
+	* @brief This method is to manually release OpenVinoData instance of the default session
 	*/
 	DLLEXPORT bool OpenVino_Release();
+
+	/*
+	* @brief This method loads a model into a new session, for example for another viewport or
+	* render target. Sessions have their own model, resolution and requests and run concurrently.
+	* Settings made with "OpenVino_SetProcessingInGraph", "OpenVino_SetTiling",
+	* "OpenVino_SetThroughputMode" and "OpenVino_SetProperty" before the call apply to it.
+	* @param modelXmlFilePath Path to, for example: style_transfer.xml
+	* @param modelBinFilePath Path to, for example: style_transfer.bin
+	* @param inferWidth, inference width
+	* @param inferHeight, inference height
+	* @param devicename, OpenVINO device, for example: CPU
+	* @return handle of the session, or null if the call failed
+	*/
+	DLLEXPORT OpenVinoSessionHandle OpenVino_CreateSession(
+		const char* modelXmlFilePath,
+		const char* modelBinFilePath,
+		int inferWidth,
+		int inferHeight,
+		const char* devicename);
+
+	/*
+	* @brief This method is used to infer results of a session, based on BGRA frame captured by engine.
+	* Calls on the same session from several threads are serialized.
+	* @param session, handle returned by "OpenVino_CreateSession"
+	* @param input, BGRA texture data
+	* @param inwidth, texture width
+	* @param inheight, texture height
+	* @param inpitch, distance in bytes between two rows of input
+	* @param output, BGRA image data after style transfer, at the resolution of the session
+	* @param outpitch, distance in bytes between two rows of output
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_InferSession(
+		OpenVinoSessionHandle session,
+		const unsigned char* input, int inwidth, int inheight, int inpitch,
+		unsigned char* output, int outpitch, bool debug_flag);
+
+	/*
+	* @brief This method releases a session created by "OpenVino_CreateSession". No other call may
+	* use the handle during or after this call.
+	* @param session, handle returned by "OpenVino_CreateSession"
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_DestroySession(
+		OpenVinoSessionHandle session);
+
+	/*
+	* @brief This method reads the live statistics of the default session: min, mean, 95th percentile and
+	* max time of each pipeline stage, model load time and model cache use. It does not block inference
+	* and can be called from any thread, e.g. once per frame by an overlay or by external monitoring.
+	* While frames run at a lower rung of the resolution ladder, the statistics are those of its session.
+	* @param stats, statistics of the session
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_GetStats(
+		OpenVinoStats* stats);
+
+	/*
+	* @brief This method reads the live statistics of a session, see "OpenVino_GetStats".
+	* @param session, handle returned by "OpenVino_CreateSession"
+	* @param stats, statistics of the session
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_GetSessionStats(
+		OpenVinoSessionHandle session,
+		OpenVinoStats* stats);
+
+	/*
+	* @brief This method limits the folder of compiled models. Compiled models are exported there and
+	* imported by later initializations with the same model files, resolution, device and settings,
+	* which skips compilation; "OpenVino_GetStats" reports cache hits and misses. The least recently
+	* used models are deleted when the folder grows over the limit.
+	* @param megabytes, size of all compiled models together, 0 to compile every time, 1024 by default
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetCacheLimit(
+		int megabytes);
+
+	/*
+	* @brief This method sets how many CPU mode default sessions stay loaded after they were replaced,
+	* e.g. by a resolution or device change. Initializing again with the model, resolution, device and
+	* settings of a cached session swaps it back in without compiling, "OpenVino_InitializeAsync" then
+	* reports ready in the next "OpenVino_IsReady". Cached sessions keep their memory; the least recently
+	* used ones are released beyond the count, all of them by "OpenVino_Release".
+	* @param count, number of cached sessions, 0 to release replaced sessions right away, 3 by default
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetSessionCacheSize(
+		int count);
+
+	/*
+	* @brief This method sets the memory the sessions of "OpenVino_SetSessionCacheSize" may take together,
+	* estimated from the model weights and the tensors of their infer requests. The least recently used
+	* sessions are released beyond it.
+	* @param megabytes, memory budget of the cached sessions, 1024 by default
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SetSessionMemoryBudget(
+		int megabytes);
+
+	/*
+	* @brief This method compiles a model into the cache for each resolution, for example from a loading
+	* screen or at install time, so the first initialization at that resolution does not compile.
+	* Settings made before the call apply as for "OpenVino_Initialize". Only the compiled models are created,
+	* no sessions, requests or log files.
+	* @param modelXmlFilePath Path to, for example: style_transfer.xml
+	* @param modelBinFilePath Path to, for example: style_transfer.bin
+	* @param devicename, OpenVINO device the model is compiled for; the OpenCL path of
+	* "OpenVino_Initialize_BaseOCL" needs its Direct3D device, an empty name returns an error
+	* @param widths, inference widths
+	* @param heights, inference heights
+	* @param count, number of resolutions
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_WarmUpCache(
+		const char* modelXmlFilePath,
+		const char* modelBinFilePath,
+		const char* devicename,
+		const int* widths,
+		const int* heights,
+		int count);
+
+	/*
+	* @brief This method picks the fastest variant of a style whose output stays within a quality tolerance,
+	* e.g. among FP32, FP16 and INT8 model files run with several inference precision hints. Each variant
+	* is timed on the device at the resolution, and its outputs are compared by PSNR and SSIM with those of
+	* the first model files run with the first hint, the reference. The chosen hint is applied to later
+	* initializations; the caller initializes with the chosen model files. The choice is kept per machine,
+	* OpenVINO version, model files, resolution and tolerance, so later calls return without probing.
+	* @param modelXmlFilePaths, model files of each variant, the highest precision first
+	* @param modelBinFilePaths, weights of each variant
+	* @param count, number of model files
+	* @param precisions, comma separated precision hints tried with every model file, e.g. "f32,bf16" on
+	* CPU or "f16,f32" on GPU; empty or null for the plugin default
+	* @param devicename, device the variants are timed on
+	* @param framesFolder, folder of representative images, or null for synthetic frames
+	* @param minPsnr, lowest PSNR in dB against the reference, e.g. 30
+	* @param minSsim, lowest SSIM in (0,1) against the reference, e.g. 0.95
+	* @param chosenIndex, index of the chosen model files
+	* @param chosenPrecision, precision hint of the chosen variant, empty for the plugin default
+	* @param maxLength, size of chosenPrecision
+	* @return true if call is successfull or false if not
+	*/
+	DLLEXPORT bool OpenVino_SelectVariant(
+		const char* const* modelXmlFilePaths,
+		const char* const* modelBinFilePaths,
+		int count,
+		const char* precisions,
+		int width,
+		int height,
+		const char* devicename,
+		const char* framesFolder,
+		float minPsnr,
+		float minSsim,
+		int* chosenIndex,
+		char* chosenPrecision,
+		size_t maxLength);
 }
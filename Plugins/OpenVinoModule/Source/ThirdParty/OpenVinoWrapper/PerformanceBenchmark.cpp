@@ -0,0 +1,719 @@
+// PerformanceBenchmark.cpp : Sweeps the CPU inference path over resolution, device, precision, stream
+// count and requests in flight, and reports load time, first inference time and per-stage percentiles
+// as JSON and as a Markdown table. With --readme it instead measures the paths of the plugin the README
+// tables compare, and writes them in the layout of the README.
+//
+// usage: ovst_bench model.xml [options]
+//   --devices CPU,GPU          devices to compile for
+//   --sizes 640x360,1280x720   model resolutions
+//   --precisions default,bf16  inference precision hints, default keeps the plugin's choice
+//   --streams 0,2              CPU streams, 0 keeps the plugin's choice
+//   --requests 1,2             infer requests in flight
+//   --pipelines kernels,graph  host pre/post processing kernels, or pre/post processing in the graph
+//   --frames dir               recorded frames, synthetic 1080p captures if not given
+//   --iterations 100           measured frames per configuration
+//   --json ovst_bench.json     JSON output
+//   --markdown ovst_bench.md   Markdown output, also printed
+//   --readme GPU_OCL,GPU.1     README rows instead of the sweep: GPU_OCL is the shared texture path of
+//                              OpenVino_Initialize_BaseOCL, any other name a device of the CPU capture path
+//   --readme-markdown ovst_readme.md  README tables, one per size, also printed
+//
+// The sweep needs only OpenVINO, TBB and the OpenCV core, imgproc and imgcodecs modules, so regressions show
+// on CPU-only Linux machines. The README rows need Direct3D 11 and the plugin library, they run on Windows.
+
+#if defined _WIN32 || defined _WIN64
+#define NOMINMAX
+#include <Windows.h>
+#include <d3d11.h>
+#include <dxgi.h>
+#define DLLEXPORT __declspec(dllimport)
+#include "OpenVinoWrapper.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include "openvino/openvino.hpp"
+
+#include "BenchmarkUtil.h"
+#include "ImageKernels.h"
+#include "ModelBuilder.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/**
+ * @struct BenchConfig
+ * @brief One point of the sweep
+ */
+struct BenchConfig
+{
+	string device;
+	string pipeline;
+	int width = 0;
+	int height = 0;
+	string precision;
+	int streams = 0;
+	int requests = 1;
+};
+
+/**
+ * @struct BenchResult
+ * @brief Measurements of one configuration, times in ms
+ */
+struct BenchResult
+{
+	BenchConfig config;
+	string error;
+	double load_ms = 0.0;
+	double first_ms = 0.0;
+	double fps = 0.0;
+	vector<double> preprocess;
+	vector<double> infer;
+	vector<double> postprocess;
+};
+
+/**
+ * @struct ReadmeRow
+ * @brief One row of the README performance tables, times in ms
+ */
+struct ReadmeRow
+{
+	// GPU_OCL, or the device of the CPU capture path, e.g. GPU.1
+	string mode;
+	string error;
+	double fps = 0.0;
+	double infer_ms = 0.0;
+	// back buffer read back to the CPU and result uploaded into a texture, 0 on the shared texture path
+	double copy_ms = 0.0;
+	double load_ms = 0.0;
+};
+
+typedef chrono::steady_clock Clock;
+
+static double ElapsedMs(Clock::time_point begin, Clock::time_point end = Clock::now())
+{
+	return chrono::duration<double, milli>(end - begin).count();
+}
+
+static vector<string> SplitList(const string& list)
+{
+	vector<string> items;
+	size_t begin = 0;
+	while (begin <= list.size())
+	{
+		size_t end = list.find(',', begin);
+		if (end == string::npos)
+			end = list.size();
+		if (end > begin)
+			items.push_back(list.substr(begin, end - begin));
+		begin = end + 1;
+	}
+	return items;
+}
+
+/*
+ * @brief Captured frames fed to the model, BGRA as the engine hands them over
+ */
+static vector<cv::Mat> LoadFrames(const string& directory)
+{
+	vector<cv::Mat> frames;
+	if (directory.empty())
+	{
+		// noise keeps the work of the kernels independent of the content
+		cv::Mat capture(1080, 1920, CV_8UC4);
+		for (size_t i = 0; i < capture.total() * 4; i++)
+		{
+			capture.data[i] = static_cast<unsigned char>((i * 2654435761u) >> 24);
+		}
+		frames.push_back(capture);
+		return frames;
+	}
+
+	vector<fs::path> paths;
+	for (const fs::directory_entry& entry : fs::directory_iterator(directory))
+	{
+		if (entry.is_regular_file())
+			paths.push_back(entry.path());
+	}
+	sort(paths.begin(), paths.end());
+	for (const fs::path& path : paths)
+	{
+		cv::Mat image = cv::imread(path.string(), cv::IMREAD_COLOR);
+		if (image.empty())
+			continue;
+		cv::Mat bgra;
+		cv::cvtColor(image, bgra, cv::COLOR_BGR2BGRA);
+		frames.push_back(bgra);
+	}
+	if (frames.empty())
+		throw runtime_error("No images in " + directory);
+	return frames;
+}
+
+/**
+ * @struct BenchRequest
+ * @brief An infer request with the host side of one frame: the pre/post processing of the "kernels"
+ * pipeline, or the caller buffers bound as tensors in the "graph" pipeline
+ */
+struct BenchRequest
+{
+	ov::InferRequest request;
+	PreprocessKernel preprocess;
+	PostprocessKernel postprocess;
+	cv::Mat output;
+	Clock::time_point started;
+	Clock::time_point completed;
+};
+
+/*
+ * @brief Compile one configuration and run "iterations" frames through it
+ */
+static BenchResult RunConfiguration(ov::Core& core, const string& modelPath, const BenchConfig& config,
+	const vector<cv::Mat>& frames, int iterations)
+{
+	BenchResult result;
+	result.config = config;
+	bool in_graph = config.pipeline == "graph";
+
+	try
+	{
+		ModelIO io;
+		io.input = in_graph ? ModelInput::BGRX_U8 : ModelInput::PLANAR_F32;
+		io.output = in_graph ? ModelOutput::BGRA_U8 : ModelOutput::PLANAR_F32;
+		io.width = config.width;
+		io.height = config.height;
+
+		ov::AnyMap properties;
+		if (config.streams > 0)
+			properties.emplace(ov::num_streams(config.streams));
+		if (config.precision != "default")
+			properties[ov::hint::inference_precision.name()] = config.precision;
+
+		// load time as the plugin sees it: reading the IR, building the pre/post processing and compiling
+		Clock::time_point load_begin = Clock::now();
+		ov::CompiledModel compiled = core.compile_model(BuildStyleModel(core, modelPath, io), config.device, properties);
+		result.load_ms = ElapsedMs(load_begin);
+
+		vector<BenchRequest> requests(config.requests);
+		for (BenchRequest& slot : requests)
+		{
+			slot.request = compiled.create_infer_request();
+			slot.output.create(config.height, config.width, CV_8UC4);
+			BenchRequest* stamped = &slot;
+			slot.request.set_callback([stamped](std::exception_ptr) { stamped->completed = Clock::now(); });
+		}
+
+		auto submit = [&](BenchRequest& slot, const cv::Mat& frame) {
+			Clock::time_point begin = Clock::now();
+			if (in_graph)
+			{
+				slot.request.set_input_tensor(ov::Tensor(ov::element::u8,
+					ov::Shape{ 1, static_cast<size_t>(frame.rows), static_cast<size_t>(frame.cols), 4 }, frame.data));
+				slot.request.set_output_tensor(ov::Tensor(ov::element::u8,
+					ov::Shape{ 1, static_cast<size_t>(config.height), static_cast<size_t>(config.width), 4 }, slot.output.data));
+			}
+			else
+			{
+				slot.preprocess.Configure(frame.cols, frame.rows, config.width, config.height);
+				slot.preprocess.Run(frame.data, static_cast<int>(frame.step), slot.request.get_input_tensor().data<float>());
+			}
+			slot.started = Clock::now();
+			slot.request.start_async();
+			return ElapsedMs(begin, slot.started);
+		};
+		auto complete = [&](BenchRequest& slot, double& inferMs) {
+			slot.request.wait();
+			inferMs = ElapsedMs(slot.started, slot.completed);
+			Clock::time_point begin = Clock::now();
+			if (!in_graph)
+			{
+				slot.postprocess.Run(slot.request.get_output_tensor().data<float>(), config.width, config.height,
+					slot.output.data, static_cast<int>(slot.output.step));
+			}
+			return ElapsedMs(begin);
+		};
+
+		// first inference, includes lazy allocations of the plugin
+		Clock::time_point first_begin = Clock::now();
+		double ignored;
+		submit(requests[0], frames[0]);
+		complete(requests[0], ignored);
+		result.first_ms = ElapsedMs(first_begin);
+
+		// frame i runs on request i % count, its result is collected before that request takes frame i + count
+		size_t count = requests.size();
+		Clock::time_point run_begin = Clock::now();
+		for (int i = 0; i < iterations + static_cast<int>(count); i++)
+		{
+			BenchRequest& slot = requests[i % count];
+			if (i >= static_cast<int>(count))
+			{
+				double infer_ms = 0.0;
+				result.postprocess.push_back(complete(slot, infer_ms));
+				result.infer.push_back(infer_ms);
+			}
+			if (i < iterations)
+				result.preprocess.push_back(submit(slot, frames[i % frames.size()]));
+		}
+		result.fps = iterations * 1000.0 / ElapsedMs(run_begin);
+	}
+	catch (std::exception& ex)
+	{
+		result.error = ex.what();
+	}
+	return result;
+}
+
+#if defined _WIN32 || defined _WIN64
+/**
+ * @struct D3DFrame
+ * @brief Direct3D 11 device and the textures of one README row, as the engine holds them
+ */
+struct D3DFrame
+{
+	ID3D11Device* device = nullptr;
+	ID3D11DeviceContext* context = nullptr;
+	ID3D11Texture2D* source = nullptr;   // rendered frame
+	ID3D11Texture2D* staging = nullptr;  // CPU readable copy of it, CPU capture path only
+	ID3D11Texture2D* result = nullptr;   // stylized frame
+	ID3D11Query* done = nullptr;         // signaled once the GPU executed the commands issued before it
+
+	~D3DFrame()
+	{
+		if (done) done->Release();
+		if (result) result->Release();
+		if (staging) staging->Release();
+		if (source) source->Release();
+		if (context) context->Release();
+		if (device) device->Release();
+	}
+};
+
+/*
+ * @brief Create the device on the Intel adapter, whose OpenCL device the shared texture path runs on, or
+ * on the default adapter if there is none
+ */
+static void CreateDevice(D3DFrame& d3d)
+{
+	IDXGIFactory1* factory = nullptr;
+	IDXGIAdapter1* chosen = nullptr;
+	if (SUCCEEDED(CreateDXGIFactory1(__uuidof(IDXGIFactory1), reinterpret_cast<void**>(&factory))))
+	{
+		IDXGIAdapter1* adapter = nullptr;
+		for (UINT i = 0; chosen == nullptr && factory->EnumAdapters1(i, &adapter) != DXGI_ERROR_NOT_FOUND; i++)
+		{
+			DXGI_ADAPTER_DESC1 desc;
+			if (SUCCEEDED(adapter->GetDesc1(&desc)) && desc.VendorId == 0x8086)
+				chosen = adapter;
+			else
+				adapter->Release();
+		}
+		factory->Release();
+	}
+
+	HRESULT r = D3D11CreateDevice(chosen, chosen ? D3D_DRIVER_TYPE_UNKNOWN : D3D_DRIVER_TYPE_HARDWARE, nullptr, 0,
+		nullptr, 0, D3D11_SDK_VERSION, &d3d.device, nullptr, &d3d.context);
+	if (chosen)
+		chosen->Release();
+	if (FAILED(r))
+		throw runtime_error("Direct3D 11 device could not be created");
+
+	D3D11_QUERY_DESC query = { D3D11_QUERY_EVENT, 0 };
+	if (FAILED(d3d.device->CreateQuery(&query, &d3d.done)))
+		throw runtime_error("Direct3D 11 query could not be created");
+}
+
+static ID3D11Texture2D* CreateTexture(ID3D11Device* device, int width, int height, DXGI_FORMAT format,
+	D3D11_USAGE usage, UINT bindFlags, const cv::Mat* pixels)
+{
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = width;
+	desc.Height = height;
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.Format = format;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = usage;
+	desc.BindFlags = bindFlags;
+	desc.CPUAccessFlags = usage == D3D11_USAGE_STAGING ? D3D11_CPU_ACCESS_READ : 0;
+
+	D3D11_SUBRESOURCE_DATA data = {};
+	if (pixels)
+	{
+		data.pSysMem = pixels->data;
+		data.SysMemPitch = static_cast<UINT>(pixels->step);
+	}
+	ID3D11Texture2D* texture = nullptr;
+	if (FAILED(device->CreateTexture2D(&desc, pixels ? &data : nullptr, &texture)))
+		throw runtime_error("Direct3D 11 texture could not be created");
+	return texture;
+}
+
+/*
+ * @brief Wait until the GPU executed the commands issued so far
+ */
+static void WaitForGpu(D3DFrame& d3d)
+{
+	d3d.context->End(d3d.done);
+	while (d3d.context->GetData(d3d.done, nullptr, 0, 0) == S_FALSE)
+	{
+	}
+}
+
+static string LastError()
+{
+	char error[512] = {};
+	OpenVino_GetLastError(error, sizeof(error));
+	return error;
+}
+#endif
+
+/*
+ * @brief Measure one README row: load the model through the plugin library and run "iterations" frames the
+ * way the editor runs them, after one warm-up frame
+ */
+static ReadmeRow RunReadmeRow(const string& modelPath, const string& mode, int width, int height,
+	const cv::Mat& frame, int iterations)
+{
+	ReadmeRow row;
+	row.mode = mode;
+#if defined _WIN32 || defined _WIN64
+	string bin_path = modelPath.substr(0, modelPath.rfind('.')) + ".bin";
+	bool ocl = mode == "GPU_OCL";
+	// released after the session sharing it
+	D3DFrame d3d;
+	try
+	{
+		CreateDevice(d3d);
+		// the engine renders BGRA, the OpenCL path gets RGBA textures like the ones of the upscaler pass
+		cv::Mat rendered;
+		cv::resize(frame, rendered, cv::Size(width, height));
+		if (ocl)
+			cv::cvtColor(rendered, rendered, cv::COLOR_BGRA2RGBA);
+		DXGI_FORMAT format = ocl ? DXGI_FORMAT_R8G8B8A8_UNORM : DXGI_FORMAT_B8G8R8A8_UNORM;
+		UINT bind = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET | (ocl ? D3D11_BIND_UNORDERED_ACCESS : 0);
+		d3d.source = CreateTexture(d3d.device, width, height, format, D3D11_USAGE_DEFAULT, bind, &rendered);
+		d3d.result = CreateTexture(d3d.device, width, height, format, D3D11_USAGE_DEFAULT, bind, nullptr);
+		if (!ocl)
+			d3d.staging = CreateTexture(d3d.device, width, height, format, D3D11_USAGE_STAGING, 0, nullptr);
+
+		Clock::time_point load_begin = Clock::now();
+		bool loaded = ocl
+			? OpenVino_Initialize_BaseOCL(modelPath.c_str(), bin_path.c_str(), d3d.device, width, height)
+			: OpenVino_Initialize(modelPath.c_str(), bin_path.c_str(), width, height, mode.c_str());
+		row.load_ms = ElapsedMs(load_begin);
+		if (!loaded)
+			throw runtime_error(LastError());
+
+		int pitch = width * 4;
+		vector<unsigned char> capture(static_cast<size_t>(pitch) * height);
+		vector<unsigned char> output(static_cast<size_t>(pitch) * height);
+		vector<double> infer_times;
+		vector<double> copy_times;
+		Clock::time_point run_begin = Clock::now();
+		for (int i = 0; i <= iterations; i++)
+		{
+			if (i == 1)
+				run_begin = Clock::now();
+			double infer_ms = 0.0;
+			double copy_ms = 0.0;
+			if (ocl)
+			{
+				// the textures are shared with OpenCL, nothing passes through the CPU
+				Clock::time_point begin = Clock::now();
+				if (!OpenVino_Infer_FromDXData(d3d.source, d3d.result, width, height, false))
+					throw runtime_error(LastError());
+				infer_ms = ElapsedMs(begin);
+			}
+			else
+			{
+				// read back as ReadSurfaceData does, infer, then upload the result into the texture shown
+				Clock::time_point begin = Clock::now();
+				d3d.context->CopyResource(d3d.staging, d3d.source);
+				D3D11_MAPPED_SUBRESOURCE mapped;
+				if (FAILED(d3d.context->Map(d3d.staging, 0, D3D11_MAP_READ, 0, &mapped)))
+					throw runtime_error("Staging texture could not be mapped");
+				for (int y = 0; y < height; y++)
+					memcpy(capture.data() + static_cast<size_t>(y) * pitch, static_cast<const unsigned char*>(mapped.pData) + static_cast<size_t>(y) * mapped.RowPitch, pitch);
+				d3d.context->Unmap(d3d.staging, 0);
+
+				Clock::time_point infer_begin = Clock::now();
+				if (!OpenVino_Infer_FromBGRA(capture.data(), width, height, pitch, output.data(), pitch, false))
+					throw runtime_error(LastError());
+
+				Clock::time_point upload_begin = Clock::now();
+				d3d.context->UpdateSubresource(d3d.result, 0, nullptr, output.data(), pitch, 0);
+				WaitForGpu(d3d);
+				infer_ms = ElapsedMs(infer_begin, upload_begin);
+				copy_ms = ElapsedMs(begin, infer_begin) + ElapsedMs(upload_begin);
+			}
+			// the first frame warms up, it is not counted
+			if (i > 0)
+			{
+				infer_times.push_back(infer_ms);
+				copy_times.push_back(copy_ms);
+			}
+		}
+		row.fps = iterations * 1000.0 / ElapsedMs(run_begin);
+		row.infer_ms = Median(infer_times);
+		row.copy_ms = Median(copy_times);
+	}
+	catch (std::exception& ex)
+	{
+		row.error = ex.what();
+	}
+	OpenVino_Release();
+#else
+	(void)modelPath; (void)width; (void)height; (void)frame; (void)iterations;
+	row.error = "needs Direct3D 11 and the plugin library, run on Windows";
+#endif
+	return row;
+}
+
+static string JsonEscape(const string& text)
+{
+	string escaped;
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+			escaped += '\\';
+		if (static_cast<unsigned char>(c) < 0x20)
+			c = ' ';
+		escaped += c;
+	}
+	return escaped;
+}
+
+static void WriteJsonStage(FILE* file, const char* name, const vector<double>& samples, bool last)
+{
+	fprintf(file, "      \"%s\": { \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f }%s\n", name,
+		Percentile(samples, 50), Percentile(samples, 95), Percentile(samples, 99), last ? "" : ",");
+}
+
+static void WriteJson(FILE* file, const string& modelPath, int iterations, const vector<BenchResult>& results)
+{
+	fprintf(file, "{\n  \"model\": \"%s\",\n  \"iterations\": %d,\n  \"results\": [\n", JsonEscape(modelPath).c_str(), iterations);
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchResult& result = results[i];
+		const BenchConfig& config = result.config;
+		fprintf(file, "    {\n      \"device\": \"%s\", \"pipeline\": \"%s\", \"width\": %d, \"height\": %d,\n"
+			"      \"precision\": \"%s\", \"streams\": %d, \"requests\": %d,\n",
+			JsonEscape(config.device).c_str(), config.pipeline.c_str(), config.width, config.height,
+			JsonEscape(config.precision).c_str(), config.streams, config.requests);
+		if (!result.error.empty())
+		{
+			fprintf(file, "      \"error\": \"%s\"\n", JsonEscape(result.error).c_str());
+		}
+		else
+		{
+			fprintf(file, "      \"fps\": %.2f, \"load_ms\": %.1f, \"first_inference_ms\": %.2f,\n",
+				result.fps, result.load_ms, result.first_ms);
+			WriteJsonStage(file, "preprocess_ms", result.preprocess, false);
+			WriteJsonStage(file, "infer_ms", result.infer, false);
+			WriteJsonStage(file, "postprocess_ms", result.postprocess, true);
+		}
+		fprintf(file, "    }%s\n", i + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+}
+
+static string StageCell(const vector<double>& samples)
+{
+	char cell[64];
+	snprintf(cell, sizeof(cell), "%.1f / %.1f / %.1f ms", Percentile(samples, 50), Percentile(samples, 95), Percentile(samples, 99));
+	return cell;
+}
+
+static void WriteMarkdown(FILE* file, const vector<BenchResult>& results)
+{
+	fprintf(file, "| Device | Pipeline | Resolution | Precision | Streams | Requests | FPS | Loading time | First inference "
+		"| Preprocess p50/p95/p99 | Inference p50/p95/p99 | Postprocess p50/p95/p99 |\n");
+	fprintf(file, "|--------|----------|------------|-----------|---------|----------|-----|--------------|-----------------"
+		"|------------------------|-----------------------|-------------------------|\n");
+	for (const BenchResult& result : results)
+	{
+		const BenchConfig& config = result.config;
+		fprintf(file, "| %s | %s | %dx%d | %s | %s | %d |", config.device.c_str(), config.pipeline.c_str(),
+			config.width, config.height, config.precision.c_str(),
+			config.streams > 0 ? to_string(config.streams).c_str() : "default", config.requests);
+		if (!result.error.empty())
+		{
+			fprintf(file, " failed: %s | | | | | |\n", result.error.c_str());
+			continue;
+		}
+		fprintf(file, " %.1f | %.1fs | %.0fms | %s | %s | %s |\n", result.fps, result.load_ms / 1000.0, result.first_ms,
+			StageCell(result.preprocess).c_str(), StageCell(result.infer).c_str(), StageCell(result.postprocess).c_str());
+	}
+}
+
+/*
+ * @brief A table in the layout of the README, "sized" adds the resolution to the heading
+ */
+static void WriteReadmeTable(FILE* file, const string& modelPath, int width, int height, bool sized,
+	const vector<ReadmeRow>& rows)
+{
+	string name = fs::path(modelPath).stem().string();
+	if (sized)
+		fprintf(file, "### %s inference, %dx%d\n\n", name.c_str(), width, height);
+	else
+		fprintf(file, "### %s inference\n\n", name.c_str());
+	fprintf(file, "|          | FPS  | Inference time |  copy buffer from CPU to GPU | Loading time |\n");
+	fprintf(file, "|----------|------|----------------|------------------------------|--------------|\n");
+	for (const ReadmeRow& row : rows)
+	{
+		if (!row.error.empty())
+		{
+			fprintf(file, "| %-8s | failed: %s | | | |\n", row.mode.c_str(), row.error.c_str());
+			continue;
+		}
+		char copy[32] = "0";
+		if (row.copy_ms > 0.0)
+			snprintf(copy, sizeof(copy), "%.0fms", row.copy_ms);
+		fprintf(file, "| %-8s | %.1f | %.0fms | %s | %.1fs |\n", row.mode.c_str(), row.fps, row.infer_ms, copy, row.load_ms / 1000.0);
+	}
+	fprintf(file, "\n");
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2 || argv[1][0] == '-')
+	{
+		printf("usage: %s model.xml [--devices CPU] [--sizes 1280x720] [--precisions default] [--streams 0]\n"
+			"       [--requests 1,2] [--pipelines kernels,graph] [--frames dir] [--iterations 100]\n"
+			"       [--json ovst_bench.json] [--markdown ovst_bench.md]\n"
+			"   or: %s model.xml --readme GPU_OCL,GPU.1,GPU.0 [--sizes 1280x720] [--frames dir] [--iterations 100]\n"
+			"       [--readme-markdown ovst_readme.md]\n", argv[0], argv[0]);
+		return 1;
+	}
+	string model_path = argv[1];
+	string devices = "CPU", sizes = "1280x720", precisions = "default", streams = "0", requests = "1,2";
+	string pipelines = "kernels,graph", frames_directory, json_path = "ovst_bench.json", markdown_path = "ovst_bench.md";
+	string readme_modes, readme_path = "ovst_readme.md";
+	int iterations = 100;
+	for (int i = 2; i + 1 < argc; i += 2)
+	{
+		string option = argv[i];
+		string value = argv[i + 1];
+		if (option == "--devices") devices = value;
+		else if (option == "--sizes") sizes = value;
+		else if (option == "--precisions") precisions = value;
+		else if (option == "--streams") streams = value;
+		else if (option == "--requests") requests = value;
+		else if (option == "--pipelines") pipelines = value;
+		else if (option == "--frames") frames_directory = value;
+		else if (option == "--iterations") iterations = max(1, atoi(value.c_str()));
+		else if (option == "--json") json_path = value;
+		else if (option == "--markdown") markdown_path = value;
+		else if (option == "--readme") readme_modes = value;
+		else if (option == "--readme-markdown") readme_path = value;
+		else
+		{
+			printf("unknown option %s\n", option.c_str());
+			return 1;
+		}
+	}
+
+	if (!readme_modes.empty())
+	{
+		FILE* readme = fopen(readme_path.c_str(), "w");
+		bool failed = readme == nullptr;
+		try
+		{
+			vector<cv::Mat> frames = LoadFrames(frames_directory);
+			vector<string> size_list = SplitList(sizes);
+			for (const string& size : size_list)
+			{
+				int width = 0;
+				int height = 0;
+				if (sscanf(size.c_str(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+					throw invalid_argument("Invalid size " + size);
+				vector<ReadmeRow> rows;
+				for (const string& mode : SplitList(readme_modes))
+				{
+					rows.push_back(RunReadmeRow(model_path, mode, width, height, frames[0], iterations));
+					failed |= !rows.back().error.empty();
+				}
+				if (readme)
+					WriteReadmeTable(readme, model_path, width, height, size_list.size() > 1, rows);
+				WriteReadmeTable(stdout, model_path, width, height, size_list.size() > 1, rows);
+			}
+		}
+		catch (std::exception& ex)
+		{
+			printf("failed: %s\n", ex.what());
+			failed = true;
+		}
+		if (readme)
+			fclose(readme);
+		return failed ? 1 : 0;
+	}
+
+	vector<BenchResult> results;
+	try
+	{
+		vector<cv::Mat> frames = LoadFrames(frames_directory);
+		ov::Core core;
+		for (const string& device : SplitList(devices))
+		for (const string& size : SplitList(sizes))
+		for (const string& precision : SplitList(precisions))
+		for (const string& stream_count : SplitList(streams))
+		for (const string& request_count : SplitList(requests))
+		for (const string& pipeline : SplitList(pipelines))
+		{
+			BenchConfig config;
+			config.device = device;
+			config.pipeline = pipeline;
+			if (sscanf(size.c_str(), "%dx%d", &config.width, &config.height) != 2 || config.width <= 0 || config.height <= 0)
+				throw invalid_argument("Invalid size " + size);
+			if (pipeline != "kernels" && pipeline != "graph")
+				throw invalid_argument("Invalid pipeline " + pipeline);
+			config.precision = precision;
+			config.streams = atoi(stream_count.c_str());
+			config.requests = max(1, atoi(request_count.c_str()));
+
+			results.push_back(RunConfiguration(core, model_path, config, frames, iterations));
+			const BenchResult& result = results.back();
+			if (result.error.empty())
+				printf("%s %s %s %s streams %d requests %d: %.1f fps\n", device.c_str(), pipeline.c_str(), size.c_str(),
+					precision.c_str(), config.streams, config.requests, result.fps);
+			else
+				printf("%s %s %s %s streams %d requests %d: failed: %s\n", device.c_str(), pipeline.c_str(), size.c_str(),
+					precision.c_str(), config.streams, config.requests, result.error.c_str());
+			fflush(stdout);
+		}
+	}
+	catch (std::exception& ex)
+	{
+		printf("failed: %s\n", ex.what());
+		return 1;
+	}
+
+	FILE* json = fopen(json_path.c_str(), "w");
+	if (json)
+	{
+		WriteJson(json, model_path, iterations, results);
+		fclose(json);
+	}
+	FILE* markdown = fopen(markdown_path.c_str(), "w");
+	if (markdown)
+	{
+		WriteMarkdown(markdown, results);
+		fclose(markdown);
+	}
+	printf("\n");
+	WriteMarkdown(stdout, results);
+	return json && markdown ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+// PinningJitterBenchmark.cpp : Measures how much CPU inference disturbs the threads of a game. A game and a
+// render thread each run a fixed amount of work per 60 Hz frame, first alone, then while style transfer runs
+// back to back on all cores, then while it is pinned to a core set. Their frame work times are reported as
+// median, 99th percentile and maximum, together with the inference rate.
+//
+// usage: ovst_pinning_bench model.xml [core set] [seconds] [width] [height]
+//
+// The core set is given as to OpenVino_SetCoreSet, e.g. "E", "numa:1" or "8-15"; by default the upper half
+// of the logical processors.
+
+#if defined _WIN32 || defined _WIN64
+#define DLLEXPORT __declspec(dllimport)
+#else
+#define DLLEXPORT
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkUtil.h"
+#include "OpenVinoWrapper.h"
+
+using namespace std;
+
+static const double kFrameMs = 1000.0 / 60.0;
+// work of the simulated game thread per frame when it runs alone, the render thread does 3/4 of it
+static const double kGameWorkMs = 8.0;
+// results of the work, kept so it is not optimized away
+static atomic<unsigned int> workSink(0);
+
+/*
+ * @brief Stand-in for a frame of game logic: passes over a buffer larger than the L1 cache
+ */
+static unsigned int Work(vector<unsigned int>& buffer, int passes)
+{
+	unsigned int hash = 2166136261u;
+	for (int pass = 0; pass < passes; pass++)
+	{
+		for (size_t i = 0; i < buffer.size(); i++)
+		{
+			hash = (hash ^ buffer[i]) * 16777619u;
+			buffer[i] = hash;
+		}
+	}
+	return hash;
+}
+
+/*
+ * @brief Passes of "Work" taking "ms" on an idle machine
+ */
+static int CalibrateWork(vector<unsigned int>& buffer, double ms)
+{
+	int passes = 1;
+	for (;;)
+	{
+		chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+		Work(buffer, passes);
+		double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+		if (elapsed > ms / 4)
+			return max(1, static_cast<int>(passes * ms / elapsed));
+		passes *= 2;
+	}
+}
+
+/*
+ * @brief Run "passes" of work once per frame until "stop", and collect how long each frame's work took
+ */
+static void FrameLoop(int passes, const atomic<bool>& stop, vector<double>* times)
+{
+	vector<unsigned int> buffer(64 * 1024, 1u);
+	chrono::steady_clock::time_point next = chrono::steady_clock::now();
+	while (!stop)
+	{
+		chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+		workSink += Work(buffer, passes);
+		times->push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count());
+
+		next += chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double, milli>(kFrameMs));
+		this_thread::sleep_until(next);
+	}
+}
+
+static void PrintTimes(const char* pass, const char* thread, const vector<double>& times, double inferencesPerSecond)
+{
+	double median = Median(times);
+	double p99 = Percentile(times, 99.0);
+	double worst = times.empty() ? 0.0 : *max_element(times.begin(), times.end());
+	printf("%-10s %-7s %10.2f %10.2f %10.2f %10.2f %12.1f\n", pass, thread, median, p99, worst, p99 - median, inferencesPerSecond);
+}
+
+/*
+ * @brief Run the game and render threads for "seconds", with inference on the core set running next to
+ * them unless "model" is null
+ * @return false if initialization or inference failed
+ */
+static bool RunPass(const char* pass, const char* model, const char* coreSet, int width, int height, double seconds,
+	int gamePasses, int renderPasses)
+{
+	char error[512] = {};
+	if (model != nullptr)
+	{
+		string weights = string(model).substr(0, string(model).find_last_of('.')) + ".bin";
+		if (!OpenVino_SetCoreSet(coreSet) || !OpenVino_Initialize(model, weights.c_str(), width, height, "CPU"))
+		{
+			OpenVino_GetLastError(error, sizeof(error));
+			printf("%s failed: %s\n", pass, error);
+			OpenVino_Release();
+			return false;
+		}
+	}
+
+	atomic<bool> stop(false);
+	atomic<bool> failed(false);
+	atomic<int> inferences(0);
+	thread inference;
+	if (model != nullptr)
+	{
+		inference = thread([&]()
+		{
+			vector<unsigned char> input(static_cast<size_t>(width) * height * 4, 128);
+			vector<unsigned char> output(input.size());
+			while (!stop)
+			{
+				if (!OpenVino_Infer_FromBGRA(input.data(), width, height, width * 4, output.data(), width * 4, false))
+				{
+					failed = true;
+					return;
+				}
+				inferences++;
+			}
+		});
+		// the first frames select kernels and allocate
+		this_thread::sleep_for(chrono::seconds(1));
+		inferences = 0;
+	}
+
+	vector<double> game_times, render_times;
+	chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+	thread game(FrameLoop, gamePasses, cref(stop), &game_times);
+	thread render(FrameLoop, renderPasses, cref(stop), &render_times);
+	this_thread::sleep_for(chrono::duration<double>(seconds));
+	stop = true;
+	game.join();
+	render.join();
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	if (inference.joinable())
+		inference.join();
+
+	if (failed)
+	{
+		OpenVino_GetLastError(error, sizeof(error));
+		printf("%s inference failed: %s\n", pass, error);
+	}
+	if (model != nullptr)
+		OpenVino_Release();
+
+	double rate = inferences / elapsed;
+	PrintTimes(pass, "game", game_times, rate);
+	PrintTimes(pass, "render", render_times, rate);
+	return !failed;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printf("usage: %s model.xml [core set] [seconds] [width] [height]\n", argv[0]);
+		return 1;
+	}
+	const char* model = argv[1];
+	int processors = max(2, static_cast<int>(thread::hardware_concurrency()));
+	string core_set = argc > 2 ? argv[2] : to_string(processors / 2) + "-" + to_string(processors - 1);
+	double seconds = argc > 3 ? atof(argv[3]) : 10.0;
+	int width = argc > 4 ? atoi(argv[4]) : 640;
+	int height = argc > 5 ? atoi(argv[5]) : 360;
+
+	vector<unsigned int> buffer(64 * 1024, 1u);
+	int game_passes = CalibrateWork(buffer, kGameWorkMs);
+	int render_passes = max(1, game_passes * 3 / 4);
+	printf("%s at %dx%d, %d processors, pinned to \"%s\", %.0f s per pass\n",
+		model, width, height, processors, core_set.c_str(), seconds);
+	printf("%-10s %-7s %10s %10s %10s %10s %12s\n", "", "thread", "median ms", "p99 ms", "max ms", "jitter ms", "inferences/s");
+
+	if (!RunPass("idle", nullptr, "", width, height, seconds, game_passes, render_passes) ||
+		!RunPass("all cores", model, "", width, height, seconds, game_passes, render_passes) ||
+		!RunPass("pinned", model, core_set.c_str(), width, height, seconds, game_passes, render_passes))
+		return 1;
+	return 0;
+}
@@ -0,0 +1,111 @@
+#include "PipelineStats.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+StageHistogram::StageHistogram()
+	: count(0)
+{
+	for (atomic<float>& sample : samples)
+		sample.store(0.0f, memory_order_relaxed);
+}
+
+void StageHistogram::Record(double ms)
+{
+	uint64_t index = count.fetch_add(1, memory_order_relaxed);
+	samples[index % kWindow].store(static_cast<float>(ms), memory_order_relaxed);
+}
+
+void StageHistogram::Reset()
+{
+	count.store(0, memory_order_relaxed);
+}
+
+StageSummary StageHistogram::Summary() const
+{
+	StageSummary summary;
+	summary.count = count.load(memory_order_relaxed);
+	size_t size = static_cast<size_t>(min<uint64_t>(summary.count, kWindow));
+	if (size == 0)
+		return summary;
+
+	vector<float> window(size);
+	for (size_t i = 0; i < size; i++)
+		window[i] = samples[i].load(memory_order_relaxed);
+
+	double sum = 0.0;
+	for (float sample : window)
+		sum += sample;
+	summary.mean_ms = sum / size;
+	auto range = minmax_element(window.begin(), window.end());
+	summary.min_ms = *range.first;
+	summary.max_ms = *range.second;
+
+	// nearest rank
+	size_t rank = min(size - 1, (size * 95 + 99) / 100 - 1);
+	nth_element(window.begin(), window.begin() + rank, window.end());
+	summary.p95_ms = window[rank];
+	return summary;
+}
+
+PipelineStats::PipelineStats()
+	: load_ms(0.0), loads(0), cache_hits(0), cache_misses(0), frames_checked(0), frames_skipped(0), tiles_total(0), tiles_inferred(0)
+{
+}
+
+void PipelineStats::Record(PipelineStage stage, double ms)
+{
+	stages[static_cast<size_t>(stage)].Record(ms);
+}
+
+void PipelineStats::Record(PipelineStage stage, chrono::steady_clock::time_point begin, chrono::steady_clock::time_point end)
+{
+	Record(stage, chrono::duration<double, milli>(end - begin).count());
+}
+
+void PipelineStats::RecordLoad(double ms, CacheResult cache)
+{
+	load_ms.store(ms, memory_order_relaxed);
+	loads.fetch_add(1, memory_order_relaxed);
+	if (cache == CacheResult::HIT)
+		cache_hits.fetch_add(1, memory_order_relaxed);
+	else if (cache == CacheResult::MISS)
+		cache_misses.fetch_add(1, memory_order_relaxed);
+}
+
+void PipelineStats::RecordChangeCheck(bool skipped)
+{
+	frames_checked.fetch_add(1, memory_order_relaxed);
+	if (skipped)
+		frames_skipped.fetch_add(1, memory_order_relaxed);
+}
+
+void PipelineStats::RecordTiles(int inferred, int total)
+{
+	tiles_total.fetch_add(static_cast<uint64_t>(total), memory_order_relaxed);
+	tiles_inferred.fetch_add(static_cast<uint64_t>(inferred), memory_order_relaxed);
+}
+
+void PipelineStats::ResetStages()
+{
+	for (StageHistogram& stage : stages)
+		stage.Reset();
+}
+
+PipelineSnapshot PipelineStats::Snapshot() const
+{
+	PipelineSnapshot snapshot;
+	for (size_t i = 0; i < static_cast<size_t>(PipelineStage::COUNT); i++)
+		snapshot.stages[i] = stages[i].Summary();
+	snapshot.load_ms = load_ms.load(memory_order_relaxed);
+	snapshot.loads = loads.load(memory_order_relaxed);
+	snapshot.cache_hits = cache_hits.load(memory_order_relaxed);
+	snapshot.cache_misses = cache_misses.load(memory_order_relaxed);
+	snapshot.frames_checked = frames_checked.load(memory_order_relaxed);
+	snapshot.frames_skipped = frames_skipped.load(memory_order_relaxed);
+	snapshot.tiles_total = tiles_total.load(memory_order_relaxed);
+	snapshot.tiles_inferred = tiles_inferred.load(memory_order_relaxed);
+	return snapshot;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Stages a frame passes through, each one is timed separately
+ */
+enum class PipelineStage
+{
+	CAPTURE_HANDOFF, // from the call until the capture is bound or copied into an input tensor, waiting for the pipeline included
+	PREPROCESS,      // host side conversion into the input tensor, part of the graph when processing in graph
+	INFER,           // from the start of the inference until it completed
+	POSTPROCESS,     // host side conversion of the output tensor, part of the graph when processing in graph
+	OUTPUT_COPY,     // copy of the result into the caller's buffer or texture
+	COUNT
+};
+
+/**
+ * @brief Whether a compilation was served from the model cache
+ */
+enum class CacheResult
+{
+	UNKNOWN, // no cache, or the device does not import compiled models
+	HIT,
+	MISS,
+};
+
+/**
+ * @struct StageSummary
+ * @brief Times of one stage in ms over the recent frames, count since initialization
+ */
+struct StageSummary
+{
+	uint64_t count = 0;
+	double min_ms = 0.0;
+	double mean_ms = 0.0;
+	double p95_ms = 0.0;
+	double max_ms = 0.0;
+};
+
+/**
+ * @class StageHistogram
+ * @brief Ring buffer of the most recent times of a stage. Recording is wait-free so inference threads and
+ * completion callbacks never block on a reader; a reader may see a sample that is being replaced.
+ */
+class StageHistogram
+{
+public:
+	static constexpr size_t kWindow = 256;
+
+	StageHistogram();
+
+	void Record(double ms);
+
+	/**
+	 * @brief Forget all samples
+	 */
+	void Reset();
+
+	/**
+	 * @brief Min, mean, 95th percentile and max of the samples in the window
+	 */
+	StageSummary Summary() const;
+
+private:
+	std::atomic<uint64_t> count;
+	std::array<std::atomic<float>, kWindow> samples;
+};
+
+/**
+ * @struct PipelineSnapshot
+ * @brief Stage times, model load time and model cache use at one point in time
+ */
+struct PipelineSnapshot
+{
+	StageSummary stages[static_cast<size_t>(PipelineStage::COUNT)];
+	// time of the last compilation in ms, and number of compilations
+	double load_ms = 0.0;
+	uint64_t loads = 0;
+	uint64_t cache_hits = 0;
+	uint64_t cache_misses = 0;
+	// frames compared by the change detector, and those of them answered with the previous result
+	uint64_t frames_checked = 0;
+	uint64_t frames_skipped = 0;
+	// tiles of the tiled frames, and those of them inferred again because their window changed
+	uint64_t tiles_total = 0;
+	uint64_t tiles_inferred = 0;
+};
+
+/**
+ * @class PipelineStats
+ * @brief Per stage histograms and model load counters of an inference pipeline, readable while it runs
+ */
+class PipelineStats
+{
+public:
+	PipelineStats();
+
+	void Record(PipelineStage stage, double ms);
+
+	/**
+	 * @brief Record the time from "begin" until "end"
+	 */
+	void Record(PipelineStage stage, std::chrono::steady_clock::time_point begin,
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now());
+
+	void RecordLoad(double ms, CacheResult cache);
+
+	/**
+	 * @brief Count a frame compared by the change detector
+	 * @param skipped, true if it was answered with the previous result instead of an inference
+	 */
+	void RecordChangeCheck(bool skipped);
+
+	/**
+	 * @brief Count the tiles of a frame that runs only its changed tiles
+	 * @param inferred, tiles inferred again, the others kept their previous result
+	 * @param total, tiles of the frame
+	 */
+	void RecordTiles(int inferred, int total);
+
+	/**
+	 * @brief Forget the stage times, e.g. of warm-up frames, load counters are kept
+	 */
+	void ResetStages();
+
+	PipelineSnapshot Snapshot() const;
+
+private:
+	StageHistogram stages[static_cast<size_t>(PipelineStage::COUNT)];
+	std::atomic<double> load_ms;
+	std::atomic<uint64_t> loads;
+	std::atomic<uint64_t> cache_hits;
+	std::atomic<uint64_t> cache_misses;
+	std::atomic<uint64_t> frames_checked;
+	std::atomic<uint64_t> frames_skipped;
+	std::atomic<uint64_t> tiles_total;
+	std::atomic<uint64_t> tiles_inferred;
+};
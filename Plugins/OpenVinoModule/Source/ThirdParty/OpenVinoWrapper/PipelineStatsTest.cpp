@@ -0,0 +1,148 @@
+// PipelineStatsTest.cpp : Checks the stage histograms and counters behind "OpenVino_GetStats": the window of
+// the most recent samples, the nearest-rank 95th percentile, stages reset apart from the load counters, and
+// recording from several threads while a reader takes snapshots.
+//
+// usage: ovst_stats_test
+
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "PipelineStats.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void Check(bool condition, const char* what)
+{
+	if (!condition)
+	{
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+static bool Near(double value, double expected)
+{
+	return fabs(value - expected) < 1e-3;
+}
+
+/*
+ * @brief An empty stage reports zeros, a partly filled one all of its samples
+ */
+static void TestPartialWindow()
+{
+	StageHistogram histogram;
+	StageSummary empty = histogram.Summary();
+	Check(empty.count == 0 && empty.min_ms == 0.0 && empty.max_ms == 0.0 && empty.p95_ms == 0.0, "empty stage reports zeros");
+
+	// 1..20 ms, the 95th percentile of 20 samples is the 19th smallest
+	for (int i = 20; i >= 1; i--)
+		histogram.Record(i);
+	StageSummary summary = histogram.Summary();
+	Check(summary.count == 20, "partial window counts every sample");
+	Check(Near(summary.min_ms, 1.0) && Near(summary.max_ms, 20.0), "partial window min and max");
+	Check(Near(summary.mean_ms, 10.5), "partial window mean");
+	Check(Near(summary.p95_ms, 19.0), "partial window nearest-rank p95");
+}
+
+/*
+ * @brief Once more than a window of samples was recorded, only the most recent ones are summarized
+ */
+static void TestWindowWrap()
+{
+	StageHistogram histogram;
+	size_t recorded = StageHistogram::kWindow + 100;
+	for (size_t i = 0; i < recorded; i++)
+		histogram.Record(i < 100 ? 1000.0 : static_cast<double>(i - 100 + 1));
+
+	// the 100 early outliers were replaced by 1..kWindow
+	StageSummary summary = histogram.Summary();
+	Check(summary.count == recorded, "wrapped window keeps the total count");
+	Check(Near(summary.max_ms, StageHistogram::kWindow), "wrapped window forgets the oldest samples");
+	Check(Near(summary.min_ms, 1.0), "wrapped window min");
+	Check(Near(summary.mean_ms, (StageHistogram::kWindow + 1) / 2.0), "wrapped window mean");
+	// nearest rank: ceil(0.95 * 256) = 244
+	Check(Near(summary.p95_ms, 244.0), "wrapped window nearest-rank p95");
+}
+
+/*
+ * @brief Resetting the stages, e.g. after warm-up frames, keeps the load, cache, change and tile counters
+ */
+static void TestResetStages()
+{
+	PipelineStats stats;
+	stats.RecordLoad(1200.0, CacheResult::MISS);
+	stats.RecordLoad(200.0, CacheResult::HIT);
+	stats.RecordLoad(150.0, CacheResult::UNKNOWN);
+	for (int i = 0; i < 10; i++)
+		stats.RecordChangeCheck(i % 3 == 0);
+	stats.RecordTiles(3, 12);
+	stats.Record(PipelineStage::INFER, 25.0);
+	stats.Record(PipelineStage::OUTPUT_COPY, 2.0);
+
+	PipelineSnapshot before = stats.Snapshot();
+	Check(before.stages[static_cast<size_t>(PipelineStage::INFER)].count == 1, "infer stage recorded");
+	Check(before.stages[static_cast<size_t>(PipelineStage::PREPROCESS)].count == 0, "stages are kept apart");
+
+	stats.ResetStages();
+	PipelineSnapshot after = stats.Snapshot();
+	for (size_t i = 0; i < static_cast<size_t>(PipelineStage::COUNT); i++)
+		Check(after.stages[i].count == 0, "stage times are reset");
+	Check(Near(after.load_ms, 150.0) && after.loads == 3, "load time and count survive the reset");
+	Check(after.cache_hits == 1 && after.cache_misses == 1, "cache counters survive the reset");
+	Check(after.frames_checked == 10 && after.frames_skipped == 4, "change counters survive the reset");
+	Check(after.tiles_total == 12 && after.tiles_inferred == 3, "tile counters survive the reset");
+}
+
+/*
+ * @brief Inference threads and completion callbacks record while a reader takes snapshots
+ */
+static void TestConcurrentRecording()
+{
+	const int kSamples = 10000;
+	PipelineStats stats;
+	vector<thread> writers;
+	for (int s = 0; s < 4; s++)
+	{
+		writers.emplace_back([&stats, s]()
+		{
+			for (int i = 0; i < kSamples; i++)
+				stats.Record(static_cast<PipelineStage>(s), s + 1.0);
+		});
+	}
+	thread reader([&stats]()
+	{
+		for (int i = 0; i < 200; i++)
+			stats.Snapshot();
+	});
+	for (thread& writer : writers)
+		writer.join();
+	reader.join();
+
+	PipelineSnapshot snapshot = stats.Snapshot();
+	for (int s = 0; s < 4; s++)
+	{
+		const StageSummary& stage = snapshot.stages[s];
+		Check(stage.count == kSamples, "concurrent samples are all counted");
+		Check(Near(stage.min_ms, s + 1.0) && Near(stage.max_ms, s + 1.0), "concurrent samples stay in their stage");
+	}
+}
+
+int main()
+{
+	TestPartialWindow();
+	TestWindowWrap();
+	TestResetStages();
+	TestConcurrentRecording();
+
+	if (failures > 0)
+	{
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("all checks passed\n");
+	return 0;
+}
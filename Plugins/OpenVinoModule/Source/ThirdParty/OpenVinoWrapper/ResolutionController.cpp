@@ -0,0 +1,126 @@
+#include "ResolutionController.h"
+
+#include <algorithm>
+
+using namespace std;
+
+ResolutionController::ResolutionController()
+	: budget_ms(0.0), rung(0), window_sum(0.0), window_frames(0), settle_frames(0), frame_ms(0.0),
+	hold_windows(0), backoff(1), probing_up(false)
+{
+}
+
+void ResolutionController::SetBudget(double ms)
+{
+	budget_ms = max(ms, 0.0);
+	Reset();
+}
+
+void ResolutionController::SetRungs(const std::vector<double>& pixels)
+{
+	rung_pixels = pixels;
+	Reset();
+}
+
+void ResolutionController::Reset()
+{
+	rung = 0;
+	window_sum = 0.0;
+	window_frames = 0;
+	settle_frames = 0;
+	frame_ms = 0.0;
+	hold_windows = 0;
+	backoff = 1;
+	probing_up = false;
+}
+
+void ResolutionController::SwitchTo(int newRung, bool up)
+{
+	if (!up && probing_up)
+	{
+		// the rung above did not hold the budget, wait longer before trying it again
+		backoff = min(backoff * 2, kMaxBackoff);
+	}
+	hold_windows = up ? 0 : backoff;
+	probing_up = up;
+	rung = newRung;
+	window_sum = 0.0;
+	window_frames = 0;
+	settle_frames = kSettleFrames;
+}
+
+int ResolutionController::Record(double ms, const std::vector<bool>& available)
+{
+	int rung_count = static_cast<int>(rung_pixels.size());
+	if (budget_ms <= 0.0 || rung_count < 2)
+	{
+		rung = 0;
+		return rung;
+	}
+	auto is_available = [&available](int index)
+	{
+		return index == 0 || (index < static_cast<int>(available.size()) && available[index]);
+	};
+	// a rung that went away, e.g. while the ladder is rebuilt, falls back to the highest one left
+	if (!is_available(rung))
+	{
+		int fallback = rung;
+		while (!is_available(fallback))
+			fallback--;
+		SwitchTo(fallback, false);
+	}
+
+	// frames answered without inference say nothing about the cost of a rung
+	if (ms <= 0.0)
+		return rung;
+	if (settle_frames > 0)
+	{
+		settle_frames--;
+		return rung;
+	}
+
+	window_sum += ms;
+	window_frames++;
+	if (window_frames < kWindow)
+		return rung;
+
+	frame_ms = window_sum / window_frames;
+	window_sum = 0.0;
+	window_frames = 0;
+
+	if (frame_ms > budget_ms)
+	{
+		for (int lower = rung + 1; lower < rung_count; lower++)
+		{
+			if (is_available(lower))
+			{
+				SwitchTo(lower, false);
+				return rung;
+			}
+		}
+		return rung;
+	}
+
+	// the rung holds the budget
+	if (probing_up)
+	{
+		probing_up = false;
+		backoff = max(1, backoff / 2);
+	}
+	if (hold_windows > 0)
+	{
+		hold_windows--;
+		return rung;
+	}
+	for (int higher = rung - 1; higher >= 0; higher--)
+	{
+		if (!is_available(higher))
+			continue;
+		// inference time grows about linearly with the pixels
+		double predicted_ms = frame_ms * rung_pixels[higher] / rung_pixels[rung];
+		if (predicted_ms < budget_ms * kUpMargin)
+			SwitchTo(higher, true);
+		break;
+	}
+	return rung;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * @class ResolutionController
+ * @brief Picks the rung of a ladder of inference resolutions that holds a frame time budget. Rung 0 is the
+ * highest resolution, every further rung has fewer pixels. Latencies are averaged over a window of frames
+ * before a decision; the controller steps down when the average is over the budget, and up only when the
+ * average scaled by the pixels of the rung above is well within it. A step up that has to be taken back
+ * doubles the windows waited before the next try, so it does not oscillate between two rungs.
+ */
+class ResolutionController
+{
+public:
+	// frames averaged before a decision
+	static constexpr int kWindow = 30;
+	// frames ignored after a switch, the first frames of a rung allocate and fill caches
+	static constexpr int kSettleFrames = 3;
+	// a step up needs the predicted latency below this fraction of the budget
+	static constexpr double kUpMargin = 0.85;
+	// windows waited before the next step up at most, after failed tries
+	static constexpr int kMaxBackoff = 32;
+
+	ResolutionController();
+
+	/**
+	 * @brief Time one frame may take in ms, 0 disables the controller and returns to rung 0
+	 */
+	void SetBudget(double ms);
+	double GetBudget() const { return budget_ms; }
+
+	/**
+	 * @brief Set the rungs, the controller returns to rung 0
+	 * @param pixels, pixel count of each rung, highest resolution first
+	 */
+	void SetRungs(const std::vector<double>& pixels);
+
+	/**
+	 * @brief Account the latency of a frame that ran at the current rung
+	 * @param ms, latency of the frame, 0 for a frame that did not run the model
+	 * @param available, whether each rung can be switched to right now
+	 * @return rung the next frame runs at
+	 */
+	int Record(double ms, const std::vector<bool>& available);
+
+	int GetRung() const { return rung; }
+
+	/**
+	 * @brief Mean latency of the last complete window in ms, 0 before the first one
+	 */
+	double GetFrameMs() const { return frame_ms; }
+
+	/**
+	 * @brief Return to rung 0 and forget the measurements
+	 */
+	void Reset();
+
+private:
+	void SwitchTo(int newRung, bool up);
+
+	double budget_ms;
+	std::vector<double> rung_pixels;
+	int rung;
+	// latencies of the current window
+	double window_sum;
+	int window_frames;
+	int settle_frames;
+	double frame_ms;
+	// windows to wait before the next step up, and the current penalty for failed tries
+	int hold_windows;
+	int backoff;
+	// the last switch was a step up that has not proved itself yet
+	bool probing_up;
+};
@@ -0,0 +1,144 @@
+// TilingBenchmark.cpp : Compares tiled inference with whole-frame inference at high model
+// resolutions, in frames per second and peak process memory.
+//
+// usage: ovst_tiling_bench model.xml [iterations] [tile size] [halo]
+//
+// Every configuration runs in its own child process, so the peak memory of one run is not
+// hidden by the peak of a previous one.
+
+#if defined _WIN32 || defined _WIN64
+#include <Windows.h>
+#include <Psapi.h>
+#define DLLEXPORT __declspec(dllimport)
+#else
+#include <sys/resource.h>
+#define DLLEXPORT
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "BenchmarkUtil.h"
+#include "OpenVinoWrapper.h"
+
+using namespace std;
+
+struct Resolution
+{
+	const char* name;
+	int width;
+	int height;
+};
+
+static const Resolution kModelSizes[] = {
+	{ "1080p", 1920, 1080 },
+	{ "1440p", 2560, 1440 },
+	{ "4K", 3840, 2160 },
+};
+
+/*
+ * @brief Peak memory of this process in MB
+ */
+static double PeakMemoryMB()
+{
+#if defined _WIN32 || defined _WIN64
+	PROCESS_MEMORY_COUNTERS counters = {};
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakPagefileUsage / (1024.0 * 1024.0);
+#else
+	rusage usage = {};
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+/*
+ * @brief Initialize one configuration, run it and print a result line
+ */
+static int RunConfiguration(const char* model, const Resolution& size, int tileSize, int halo, int iterations)
+{
+	string weights = string(model).substr(0, string(model).find_last_of('.')) + ".bin";
+	OpenVino_SetTiling(tileSize, halo);
+	if (!OpenVino_Initialize(model, weights.c_str(), size.width, size.height, "CPU"))
+	{
+		char error[512] = {};
+		OpenVino_GetLastError(error, sizeof(error));
+		printf("%-6s %-12s failed: %s\n", size.name, tileSize > 0 ? "tiled" : "whole frame", error);
+		return 1;
+	}
+
+	// a 1080p capture, the size the engine hands over most often
+	int capture_width = 1920, capture_height = 1080;
+	vector<unsigned char> capture(static_cast<size_t>(capture_width) * capture_height * 4);
+	for (size_t i = 0; i < capture.size(); i++)
+	{
+		capture[i] = static_cast<unsigned char>((i * 2654435761u) >> 24);
+	}
+	vector<unsigned char> output(static_cast<size_t>(size.width) * size.height * 4);
+
+	// warm-up
+	OpenVino_Infer_FromBGRA(capture.data(), capture_width, capture_height, capture_width * 4,
+		output.data(), size.width * 4, false);
+
+	vector<double> times(iterations);
+	for (int i = 0; i < iterations; i++)
+	{
+		chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+		OpenVino_Infer_FromBGRA(capture.data(), capture_width, capture_height, capture_width * 4,
+			output.data(), size.width * 4, false);
+		chrono::steady_clock::time_point end = chrono::steady_clock::now();
+		times[i] = chrono::duration<double, milli>(end - begin).count();
+	}
+	double median_ms = Median(times);
+
+	char label[32];
+	if (tileSize > 0)
+		snprintf(label, sizeof(label), "tiles %d", tileSize);
+	else
+		snprintf(label, sizeof(label), "whole frame");
+	printf("%-6s %-12s %8.2f ms  %6.2f fps  peak %7.0f MB\n",
+		size.name, label, median_ms, 1000.0 / median_ms, PeakMemoryMB());
+	fflush(stdout);
+	OpenVino_Release();
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	// child: --run model iterations tileSize halo sizeIndex
+	if (argc == 7 && string(argv[1]) == "--run")
+	{
+		int size_index = atoi(argv[6]);
+		return RunConfiguration(argv[2], kModelSizes[size_index], atoi(argv[4]), atoi(argv[5]), max(1, atoi(argv[3])));
+	}
+
+	if (argc < 2)
+	{
+		printf("usage: %s model.xml [iterations] [tile size] [halo]\n", argv[0]);
+		return 1;
+	}
+	string model = argv[1];
+	int iterations = argc > 2 ? atoi(argv[2]) : 20;
+	int tile_size = argc > 3 ? atoi(argv[3]) : 512;
+	int halo = argc > 4 ? atoi(argv[4]) : -1;
+
+	for (int i = 0; i < static_cast<int>(sizeof(kModelSizes) / sizeof(kModelSizes[0])); i++)
+	{
+		for (int tiles : { 0, tile_size })
+		{
+			string command = "\"" + string(argv[0]) + "\" --run \"" + model + "\" " + to_string(iterations) + " " +
+				to_string(tiles) + " " + to_string(halo) + " " + to_string(i);
+#if defined _WIN32 || defined _WIN64
+			// cmd strips the outer quotes of the whole line
+			command = "\"" + command + "\"";
+#endif
+			system(command.c_str());
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,254 @@
+#include "VariantProbe.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <opencv2/imgproc.hpp>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static const char* kExtension = ".probe";
+
+/*
+ * @brief 64 bit FNV-1a of a string, names the file of a choice
+ */
+static uint64_t HashString(const string& text)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (unsigned char c : text)
+		hash = (hash ^ c) * 1099511628211ull;
+	return hash;
+}
+
+/*
+ * @brief Identity of a model file: path, size and modification time
+ */
+static string FileIdentity(const string& path)
+{
+	error_code error;
+	uintmax_t size = fs::file_size(path, error);
+	long long modified = static_cast<long long>(fs::last_write_time(path, error).time_since_epoch().count());
+	return path + " " + to_string(size) + " " + to_string(modified);
+}
+
+VariantProbe::VariantProbe(std::string folder)
+	: folder(folder)
+{
+}
+
+double VariantProbe::Psnr(const cv::Mat& a, const cv::Mat& b)
+{
+	cv::Mat a_bgr, b_bgr;
+	cv::cvtColor(a, a_bgr, cv::COLOR_BGRA2BGR);
+	cv::cvtColor(b, b_bgr, cv::COLOR_BGRA2BGR);
+	double squared = cv::norm(a_bgr, b_bgr, cv::NORM_L2SQR);
+	if (squared == 0.0)
+		return numeric_limits<double>::infinity();
+	double mse = squared / (static_cast<double>(a_bgr.total()) * a_bgr.channels());
+	return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+double VariantProbe::Ssim(const cv::Mat& a, const cv::Mat& b)
+{
+	const double c1 = (0.01 * 255) * (0.01 * 255);
+	const double c2 = (0.03 * 255) * (0.03 * 255);
+	cv::Mat x, y;
+	cv::cvtColor(a, x, cv::COLOR_BGRA2GRAY);
+	cv::cvtColor(b, y, cv::COLOR_BGRA2GRAY);
+	x.convertTo(x, CV_32F);
+	y.convertTo(y, CV_32F);
+
+	auto blur = [](const cv::Mat& image)
+	{
+		cv::Mat blurred;
+		cv::GaussianBlur(image, blurred, cv::Size(11, 11), 1.5);
+		return blurred;
+	};
+	cv::Mat mu_x = blur(x);
+	cv::Mat mu_y = blur(y);
+	cv::Mat mu_x2 = mu_x.mul(mu_x);
+	cv::Mat mu_y2 = mu_y.mul(mu_y);
+	cv::Mat mu_xy = mu_x.mul(mu_y);
+	cv::Mat sigma_x2 = blur(x.mul(x)) - mu_x2;
+	cv::Mat sigma_y2 = blur(y.mul(y)) - mu_y2;
+	cv::Mat sigma_xy = blur(x.mul(y)) - mu_xy;
+
+	cv::Mat numerator = (2 * mu_xy + c1).mul(2 * sigma_xy + c2);
+	cv::Mat denominator = (mu_x2 + mu_y2 + c1).mul(sigma_x2 + sigma_y2 + c2);
+	cv::Mat ssim_map;
+	cv::divide(numerator, denominator, ssim_map);
+	return cv::mean(ssim_map)[0];
+}
+
+VariantScore VariantProbe::Run(const ModelVariant& variant, int width, int height, const std::string& device,
+	const InferenceConfig& config, const std::vector<cv::Mat>& frames, std::vector<cv::Mat>* outputs)
+{
+	VariantScore score;
+	try
+	{
+		InferenceConfig variant_config = config;
+		if (variant.precision.empty())
+			variant_config.properties.erase(ov::hint::inference_precision.name());
+		else
+			variant_config.properties[ov::hint::inference_precision.name()] = variant.precision;
+
+		OpenVinoData data;
+		data.Initialize(variant.xml_path, variant.bin_path, width, height, device, variant_config);
+		data.WarmUpFrame();
+
+		outputs->assign(frames.size(), cv::Mat());
+		double total_ms = 0.0;
+		for (int pass = 0; pass < kTimedPasses; pass++)
+		{
+			for (size_t i = 0; i < frames.size(); i++)
+			{
+				cv::Mat& output = (*outputs)[i];
+				output.create(height, width, CV_8UC4);
+				chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+				data.InferBGRA(frames[i].data, frames[i].cols, frames[i].rows, static_cast<int>(frames[i].step),
+					output.data, static_cast<int>(output.step), false);
+				total_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+			}
+		}
+		score.ms = total_ms / (kTimedPasses * frames.size());
+	}
+	catch (std::exception& ex)
+	{
+		score.error = ex.what();
+		outputs->clear();
+	}
+	return score;
+}
+
+int VariantProbe::Select(
+	const std::vector<ModelVariant>& variants,
+	int width,
+	int height,
+	const std::string& device,
+	const InferenceConfig& config,
+	const std::vector<cv::Mat>& frames,
+	double minPsnr,
+	double minSsim,
+	std::vector<VariantScore>* scores,
+	bool* cached)
+{
+	if (variants.empty())
+		throw std::invalid_argument("No model variant to probe");
+	if (frames.empty())
+		throw std::invalid_argument("No frame to probe the model variants on");
+
+	scores->clear();
+	*cached = false;
+
+	// everything the choice depends on
+	ostringstream key_stream;
+	key_stream << OpenVinoData::DeviceDescription(device)
+		<< "hardware threads " << thread::hardware_concurrency() << "\n"
+		<< "size " << width << "x" << height << " frames " << frames.size() << "\n"
+		<< "tolerance " << minPsnr << " dB " << minSsim << "\n"
+		<< "config graph " << config.process_in_graph << " tile " << config.tile_size << " halo " << config.tile_halo
+		<< " streams " << config.streams << " queue " << config.queue_depth << " cores " << config.core_set << "\n";
+	// the precision hint of each variant replaces the configured one
+	for (const auto& property : config.properties)
+	{
+		if (property.first != ov::hint::inference_precision.name())
+			key_stream << property.first << "=" << property.second << "\n";
+	}
+	for (const ModelVariant& variant : variants)
+	{
+		key_stream << "variant " << FileIdentity(variant.xml_path) << " | " << FileIdentity(variant.bin_path)
+			<< " | " << variant.precision << "\n";
+	}
+	string key = key_stream.str();
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(HashString(key)));
+	fs::path path = fs::path(folder) / (string(name) + kExtension);
+
+	{
+		std::lock_guard<std::mutex> lock(probe_mutex);
+		ifstream file(path);
+		if (file)
+		{
+			stringstream content;
+			content << file.rdbuf();
+			string text = content.str();
+			int chosen = -1;
+			if (text.compare(0, key.size(), key) == 0 &&
+				sscanf(text.c_str() + key.size(), "chosen %d", &chosen) == 1 &&
+				chosen >= 0 && chosen < static_cast<int>(variants.size()))
+			{
+				*cached = true;
+				return chosen;
+			}
+		}
+	}
+
+	vector<cv::Mat> reference;
+	VariantScore reference_score = Run(variants[0], width, height, device, config, frames, &reference);
+	if (!reference_score.error.empty())
+		throw std::runtime_error("Reference variant " + variants[0].xml_path + " failed: " + reference_score.error);
+	reference_score.psnr = numeric_limits<double>::infinity();
+	reference_score.ssim = 1.0;
+	reference_score.within_tolerance = true;
+	scores->push_back(reference_score);
+
+	int chosen = 0;
+	for (size_t v = 1; v < variants.size(); v++)
+	{
+		vector<cv::Mat> outputs;
+		VariantScore score = Run(variants[v], width, height, device, config, frames, &outputs);
+		if (score.error.empty())
+		{
+			// the worst frame decides
+			score.psnr = numeric_limits<double>::infinity();
+			score.ssim = 1.0;
+			for (size_t i = 0; i < frames.size(); i++)
+			{
+				score.psnr = min(score.psnr, Psnr(outputs[i], reference[i]));
+				score.ssim = min(score.ssim, Ssim(outputs[i], reference[i]));
+			}
+			score.within_tolerance = score.psnr >= minPsnr && score.ssim >= minSsim;
+			if (score.within_tolerance && score.ms < (*scores)[chosen].ms)
+				chosen = static_cast<int>(v);
+		}
+		scores->push_back(score);
+	}
+
+	for (size_t v = 0; v < variants.size(); v++)
+	{
+		const VariantScore& score = (*scores)[v];
+		clog << "Variant " << variants[v].xml_path << " " << (variants[v].precision.empty() ? "default" : variants[v].precision) << ": ";
+		if (!score.error.empty())
+			clog << "failed, " << score.error;
+		else
+			clog << score.ms << " ms, PSNR " << score.psnr << " dB, SSIM " << score.ssim << (score.within_tolerance ? "" : ", out of tolerance");
+		clog << (static_cast<int>(v) == chosen ? ", chosen" : "") << endl;
+	}
+
+	try
+	{
+		std::lock_guard<std::mutex> lock(probe_mutex);
+		fs::path temporary = path;
+		temporary += ".tmp";
+		{
+			ofstream file(temporary, ios::trunc);
+			file << key << "chosen " << chosen << "\n";
+			if (!file)
+				throw std::runtime_error("Can't write " + temporary.string());
+		}
+		fs::rename(temporary, path);
+	}
+	catch (std::exception& ex)
+	{
+		// the choice holds for this run, the probe runs again next time
+		clog << "Variant choice is not cached: " << ex.what() << endl;
+	}
+	return chosen;
+}
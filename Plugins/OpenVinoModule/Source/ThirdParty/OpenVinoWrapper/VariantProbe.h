@@ -0,0 +1,93 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "OpenVinoData.h"
+
+/**
+ * @struct ModelVariant
+ * @brief One way to run a style: an IR (FP32, FP16, INT8, ...) and an inference precision hint
+ */
+struct ModelVariant
+{
+	std::string xml_path;
+	std::string bin_path;
+	// INFERENCE_PRECISION_HINT the variant is compiled with, empty for the plugin default
+	std::string precision;
+};
+
+/**
+ * @struct VariantScore
+ * @brief Speed of a variant and quality of its output against the reference variant
+ */
+struct VariantScore
+{
+	double ms = 0.0;    // mean time of a frame
+	double psnr = 0.0;  // dB, infinite for outputs identical to the reference
+	double ssim = 0.0;  // of the luma, 1 for outputs identical to the reference
+	bool within_tolerance = false;
+	std::string error;  // why the variant could not run, empty if it did
+};
+
+/**
+ * @class VariantProbe
+ * @brief Picks the fastest variant of a style whose output stays within a quality tolerance of the first,
+ * highest precision variant. Every variant is timed on representative frames on the target device, and its
+ * outputs are compared with those of the reference by PSNR and SSIM. The choice is kept in a folder per
+ * machine fingerprint (OpenVINO version, device name and capabilities, hardware threads) and per variant
+ * files, resolution and tolerance, so the probe runs only once.
+ */
+class VariantProbe
+{
+public:
+	// Timed passes over the frames per variant, after a warm-up frame
+	static const int kTimedPasses = 3;
+
+	/**
+	 * @param folder, existing folder the choices are kept in
+	 */
+	explicit VariantProbe(std::string folder);
+
+	/**
+	 * @brief Index of the fastest variant within tolerance, the reference (index 0) if no other one is
+	 * @param variants, variants to try, the reference first
+	 * @param config, compilation and scheduling the variants run with, their precision hint is added
+	 * @param frames, representative BGRA frames, of any size
+	 * @param minPsnr, lowest PSNR in dB a variant may have against the reference
+	 * @param minSsim, lowest SSIM in (0,1) a variant may have against the reference
+	 * @param scores, speed and quality of each variant, empty if the choice was cached
+	 * @param cached, set to true if the choice was read from the folder
+	 */
+	int Select(
+		const std::vector<ModelVariant>& variants,
+		int width,
+		int height,
+		const std::string& device,
+		const InferenceConfig& config,
+		const std::vector<cv::Mat>& frames,
+		double minPsnr,
+		double minSsim,
+		std::vector<VariantScore>* scores,
+		bool* cached);
+
+	/**
+	 * @brief PSNR in dB of the color channels of two BGRA images, infinite if they are identical
+	 */
+	static double Psnr(const cv::Mat& a, const cv::Mat& b);
+
+	/**
+	 * @brief Mean SSIM of the luma of two BGRA images, 11x11 Gaussian window
+	 */
+	static double Ssim(const cv::Mat& a, const cv::Mat& b);
+
+private:
+	// Run a variant over the frames, its outputs are kept in "outputs"
+	VariantScore Run(const ModelVariant& variant, int width, int height, const std::string& device,
+		const InferenceConfig& config, const std::vector<cv::Mat>& frames, std::vector<cv::Mat>* outputs);
+
+	std::string folder;
+	// Guards the files of the folder
+	std::mutex probe_mutex;
+};
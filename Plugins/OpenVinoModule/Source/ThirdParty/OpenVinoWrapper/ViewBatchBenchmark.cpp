@@ -0,0 +1,119 @@
+// ViewBatchBenchmark.cpp : Compares one inference per view with one batched inference for all
+// views of a frame, as rendered for stereo or split-screen.
+//
+// usage: ovst_views_bench model.xml [device] [iterations] [width height]
+
+#if defined _WIN32 || defined _WIN64
+#define DLLEXPORT __declspec(dllimport)
+#else
+#define DLLEXPORT
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "BenchmarkUtil.h"
+#include "OpenVinoWrapper.h"
+
+using namespace std;
+
+static const int kViewCounts[] = { 1, 2, 4 };
+
+/*
+ * @brief Time "iterations" frames of "count" views, per view or batched, and return the median ms per frame,
+ * or -1 if inference failed
+ */
+static double TimeFrames(vector<vector<unsigned char>>& views, vector<vector<unsigned char>>& outputs,
+	int count, int width, int height, bool batched, int iterations)
+{
+	vector<const unsigned char*> inputs(count);
+	vector<unsigned char*> results(count);
+	for (int v = 0; v < count; v++)
+	{
+		inputs[v] = views[v].data();
+		results[v] = outputs[v].data();
+	}
+
+	vector<double> times(iterations);
+	for (int i = 0; i <= iterations; i++)
+	{
+		chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+		if (batched)
+		{
+			if (!OpenVino_InferBatch(inputs.data(), count, width, height, width * 4, results.data(), width * 4, false))
+				return -1.0;
+		}
+		else
+		{
+			for (int v = 0; v < count; v++)
+				if (!OpenVino_Infer_FromBGRA(inputs[v], width, height, width * 4, results[v], width * 4, false))
+					return -1.0;
+		}
+		chrono::steady_clock::time_point end = chrono::steady_clock::now();
+
+		// the first frame is the warm-up, it also compiles the batched model
+		if (i > 0)
+			times[i - 1] = chrono::duration<double, milli>(end - begin).count();
+	}
+	return Median(times);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printf("usage: %s model.xml [device] [iterations] [width height]\n", argv[0]);
+		return 1;
+	}
+	string model = argv[1];
+	string device = argc > 2 ? argv[2] : "CPU";
+	int iterations = argc > 3 ? max(1, atoi(argv[3])) : 20;
+	int width = argc > 5 ? atoi(argv[4]) : 1280;
+	int height = argc > 5 ? atoi(argv[5]) : 720;
+
+	string weights = model.substr(0, model.find_last_of('.')) + ".bin";
+	if (!OpenVino_Initialize(model.c_str(), weights.c_str(), width, height, device.c_str()))
+	{
+		char error[512] = {};
+		OpenVino_GetLastError(error, sizeof(error));
+		printf("initialization failed: %s\n", error);
+		return 1;
+	}
+
+	int max_views = kViewCounts[sizeof(kViewCounts) / sizeof(kViewCounts[0]) - 1];
+	vector<vector<unsigned char>> views(max_views), outputs(max_views);
+	for (int v = 0; v < max_views; v++)
+	{
+		views[v].resize(static_cast<size_t>(width) * height * 4);
+		outputs[v].resize(views[v].size());
+		for (size_t i = 0; i < views[v].size(); i++)
+		{
+			views[v][i] = static_cast<unsigned char>(((i + v * 7919) * 2654435761u) >> 24);
+		}
+	}
+
+	printf("%s %dx%d, %d iterations\n", device.c_str(), width, height, iterations);
+	for (int count : kViewCounts)
+	{
+		double per_view_ms = TimeFrames(views, outputs, count, width, height, false, iterations);
+		double batched_ms = TimeFrames(views, outputs, count, width, height, true, iterations);
+		if (per_view_ms < 0.0 || batched_ms < 0.0)
+		{
+			char error[512] = {};
+			OpenVino_GetLastError(error, sizeof(error));
+			printf("%d views  failed: %s\n", count, error);
+			continue;
+		}
+		printf("%d views  per view %8.2f ms  batched %8.2f ms  speedup %5.2fx\n",
+			count, per_view_ms, batched_ms, per_view_ms / batched_ms);
+		fflush(stdout);
+	}
+
+	OpenVino_Release();
+	return 0;
+}